@@ -1,173 +1,341 @@
-#include "vivid/vivid.h"
-#include "vivid/renderer.h"
-#include "vivid/light.h"
-#include "vivid/material.h"
-#include "vivid/world.h"
-
-bool CheckInputs();
-int fillMode = 0;
-Mesh* mesh;
-Transform camera;
-Transform lightTransform;
-
-int WINAPI WinMain(HINSTANCE hInstance,
-				   HINSTANCE prevInstance,
-				   PSTR cmdLine,
-				   int showCmd)
-{
-	vvd::OpenLog("VividApp.log");
-	if(!vvd::Init(hInstance, 1024, 768, "VividApp", false, D3DFMT_A8R8G8B8, D3DPRESENT_INTERVAL_IMMEDIATE)) {
-		exit(1);
-	}
-	vvd::Log("VividApp is up and running!");
-
-	Renderer renderer;
-
-	ImageFilter filter("filter.fx");
-	renderer.EnableFilter(&filter);
-
-	Renderer shadowRenderer;
-
-	camera.SetPosition(30.0f, 40.0f, -20.0f);
-
-	World world(1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f);
-
-	D3DXVECTOR3 pos(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 ambientColor(0.0f, 0.0f, 0.0f);
-	world.SetAmbientColor(pos, ambientColor);
-
-	Light light;
-	light.SetRange(500.0f);
-	light.SetColor(1.0f, .75f, 0.5f);
-	lightTransform.SetPosition(-100.0f, 50.0f, 100.0f);
-
-	Light light2;
-	light2.SetPosition(100.0f, 50.0f, 100.0f, 1.0f);
-	light2.SetRange(500.0f);
-	light2.SetColor(0.5f, 0.75f, 1.0f);
-
-	Light light3;
-	light3.SetPosition(75.0f, 175.0f, 200.0f, 1.0f);
-	light3.SetRange(500.0f);
-	light3.SetColor(1.0f, 1.0f, 1.0f);
-
-	mesh = new Mesh("droid.x");
-	mesh->transform.SetPosition(0.0f, 24.0f, 50.0f);
-	mesh->transform.SetRotation(D3DXToRadian(-90), 0.0f, 0.0f);
-	
-
-	Mesh mesh2("plane.x");
-	mesh2.transform.SetPosition(-100.0f, 50.0f, 50.0f);
-	mesh2.transform.SetRotation(0.0f, D3DXToRadian(-45), 0.0f);
-	mesh2.transform.SetScale(10.0f, 10.0f, 10.0f);
-
-	Mesh mesh3("building.x");
-
-	vvd::SetMinKeyPressTime(DIK_F, 0.25f);
-
-	while(true) {
-		vvd::Update();
-
-		if(!CheckInputs())
-			break;
-
-		renderer.SetCameraPosition(&camera.GetPosition());
-		renderer.SetCameraRotation(&camera.GetLookVector(), &camera.GetUpVector());
-
-		light.SetPosition(lightTransform.GetPosition().x, lightTransform.GetPosition().y, lightTransform.GetPosition().z, 1.0f);
-
-		switch(fillMode) {
-		case 0:
-			renderer.SetFillMode(D3DFILL_SOLID);
-			break;
-		case 1:
-			renderer.SetFillMode(D3DFILL_WIREFRAME);
-			break;
-		case 2:
-			renderer.SetFillMode(D3DFILL_POINT);
-			break;
-		}
-
-		world.Update();
-		shadowRenderer.DrawShadows();
-		renderer.Draw();
-
-		MSG msg;
-		if(!::PeekMessage(&msg, 0, 0, 0, PM_REMOVE)) {
-			if(msg.message == WM_QUIT) {
-				vvd::Log("Recieved quit message from windows; exiting message loop...");
-				break;
-			}
-			::TranslateMessage(&msg);
-			::DispatchMessage(&msg);
-		}
-	}
-	vvd::DeInit();
-	return 0;
-}
-bool CheckInputs() {
-	if(vvd::keyDown(DIK_ESCAPE)) {
-		vvd::Log("User pressed escape; exiting message loop...");
-		return false;
-	}
-	if(vvd::keyDown(DIK_F)) {
-		vvd::Log("Switched fill mode");
-		fillMode++;
-		if(fillMode > 2) {
-			fillMode = 0;
-		}
-	}
-
-	float speed = 75.0f;
-	if(vvd::mouseButtonDown(0)) {
-		if(vvd::keyDown(DIK_W))
-			mesh->transform.AddPositionRelative(speed * vvd::GetDelta(), 0.0f, 0.0f);
-		if(vvd::keyDown(DIK_A))
-			mesh->transform.AddPositionRelative(0.0f, -speed * vvd::GetDelta(), 0.0f);
-		if(vvd::keyDown(DIK_S))
-			mesh->transform.AddPositionRelative(-speed * vvd::GetDelta(), 0.0f, 0.0f);
-		if(vvd::keyDown(DIK_D))
-			mesh->transform.AddPositionRelative(0.0f, speed * vvd::GetDelta(), 0.0f);
-		if(vvd::keyDown(DIK_SPACE))
-			mesh->transform.AddPositionRelative(0.0f, 0.0f, speed * vvd::GetDelta());
-		if(vvd::keyDown(DIK_LCONTROL))
-			mesh->transform.AddPositionRelative(0.0f, 0.0f, -speed * vvd::GetDelta());
-		mesh->transform.AddRotation(0.0f, vvd::mouseDX() * 0.004f, 0.0f);
-	} else if(vvd::mouseButtonDown(1)) {
-		if(vvd::keyDown(DIK_W))
-			lightTransform.AddPositionRelative(0.0f, 0.0f, speed * vvd::GetDelta());
-		if(vvd::keyDown(DIK_A))
-			lightTransform.AddPositionRelative(-speed * vvd::GetDelta(), 0.0f, 0.0f);
-		if(vvd::keyDown(DIK_S))
-			lightTransform.AddPositionRelative(0.0f, 0.0f, -speed * vvd::GetDelta());
-		if(vvd::keyDown(DIK_D))
-			lightTransform.AddPositionRelative(speed * vvd::GetDelta(), 0.0f, 0.0f);
-		if(vvd::keyDown(DIK_SPACE))
-			lightTransform.AddPositionRelative(0.0f, speed * vvd::GetDelta(), 0.0f);
-		if(vvd::keyDown(DIK_LCONTROL))
-			lightTransform.AddPositionRelative(0.0f, -speed * vvd::GetDelta(), 0.0f);
-	} else if(vvd::keyDown(DIK_C)) {
-		camera.SetPosition(&mesh->transform.GetPosition());
-		D3DXVECTOR3 offset(0.0f, 0.0f, mesh->GetRadius() * -1.5f);
-		camera.AddRotation(0.0f, 0.5f * vvd::GetDelta(), 0.0f);
-		D3DXMATRIX matrix = camera.GetRotationMatrix();
-		D3DXVec3TransformCoord(&offset, &offset, &matrix);
-		camera.AddPosition(&offset);
-	} else {
-		if(vvd::keyDown(DIK_W))
-			camera.AddPositionRelative(0.0f, 0.0f, speed * vvd::GetDelta());
-		if(vvd::keyDown(DIK_A))
-			camera.AddPositionRelative(-speed * vvd::GetDelta(), 0.0f, 0.0f);
-		if(vvd::keyDown(DIK_S))
-			camera.AddPositionRelative(0.0f, 0.0f, -speed * vvd::GetDelta());
-		if(vvd::keyDown(DIK_D))
-			camera.AddPositionRelative(speed * vvd::GetDelta(), 0.0f, 0.0f);
-		if(vvd::keyDown(DIK_SPACE))
-			camera.AddPositionRelative(0.0f, speed * vvd::GetDelta(), 0.0f);
-		if(vvd::keyDown(DIK_LCONTROL))
-			camera.AddPositionRelative(0.0f, -speed * vvd::GetDelta(), 0.0f);
-		camera.AddRotation(vvd::mouseDY() * 0.004f, vvd::mouseDX() * 0.004f, 0.0f);
-	}
-
-	return true;
+#include "vivid/vivid.h"
+#include "vivid/renderer.h"
+#include "vivid/light.h"
+#include "vivid/material.h"
+#include "vivid/world.h"
+#include "vivid/transformbatch.h"
+#include "vivid/loader.h"
+#include "vivid/jobs.h"
+#include "vivid/pipeline.h"
+
+#define BENCHMARK_FRAMES 1000
+#define BENCHMARK_OBJECTS 10000
+#define BENCHMARK_PASSES 100
+#define BENCHMARK_SOFTWARE_FRAMES 50
+
+// The renderers the render thread draws with
+struct Renderers {
+	Renderer* scene;
+	Renderer* shadows;
+};
+
+bool CheckInputs();
+void GetCamera(D3DXVECTOR3* pos, D3DXVECTOR3* look, D3DXVECTOR3* up);
+void SetFillMode(Renderer* renderer);
+void RenderFrame(FrameSnapshot* snapshot, void* renderers);
+void BenchmarkTransformBatch();
+void BenchmarkRasterizer(Renderer* renderer);
+volatile int fillMode = 0; // Read by the render thread
+Mesh* mesh;
+Transform camera;
+Transform* lightTransform; // The transform of the light that rides on the droid
+Transform* chasePivot; // Turns around the droid's up axis to swing the chase camera around it
+Transform* chaseCamera; // Rides on chasePivot, behind the droid
+bool chasing = false; // True while C is held and the view is from chaseCamera
+
+int WINAPI WinMain(HINSTANCE hInstance,
+				   HINSTANCE prevInstance,
+				   PSTR cmdLine,
+				   int showCmd)
+{
+	vvd::OpenLog("VividApp.log");
+
+	// -jobs N limits the engine to N threads, so benchmarks can show how the frame time scales
+	const char* jobs = strstr(cmdLine, "-jobs ");
+	if(jobs)
+		vvd::InitJobs(atoi(jobs + 6));
+
+	// -pipelined draws on a render thread while the next frame is simulated; -latency N lets the game
+	// run up to N frames ahead of the screen
+	bool pipelined = strstr(cmdLine, "-pipelined") != 0;
+	int latency = 1;
+	const char* latencyArg = strstr(cmdLine, "-latency ");
+	if(latencyArg)
+		latency = atoi(latencyArg + 9);
+	if(pipelined)
+		vvd::SetMultithreadedDevice(true);
+
+	// -benchmark runs a fixed number of frames on the null device and logs the CPU cost
+	bool benchmark = strstr(cmdLine, "-benchmark") != 0;
+	if(benchmark) {
+		if(!vvd::InitNull(hInstance, 1024, 768, "VividApp")) {
+			exit(1);
+		}
+	} else if(!vvd::Init(hInstance, 1024, 768, "VividApp", false, D3DFMT_A8R8G8B8, D3DPRESENT_INTERVAL_IMMEDIATE)) {
+		exit(1);
+	}
+	vvd::Log("VividApp is up and running!");
+
+	Renderer renderer;
+
+	ImageFilter filter("filter.fx");
+	renderer.EnableFilter(&filter);
+
+	Renderer shadowRenderer;
+
+	camera.SetPosition(30.0f, 40.0f, -20.0f);
+
+	World world(1000.0f, 1000.0f, 1000.0f, 250.0f, 250.0f, 250.0f);
+
+	D3DXVECTOR3 pos(0.0f, 0.0f, 0.0f);
+	D3DXVECTOR3 ambientColor(0.0f, 0.0f, 0.0f);
+	world.SetAmbientColor(pos, ambientColor);
+
+	Light light;
+	light.SetRange(500.0f);
+	light.SetColor(1.0f, .75f, 0.5f);
+
+	Light light2;
+	light2.SetPosition(100.0f, 50.0f, 100.0f, 1.0f);
+	light2.SetRange(500.0f);
+	light2.SetColor(0.5f, 0.75f, 1.0f);
+
+	Light light3;
+	light3.SetPosition(75.0f, 175.0f, 200.0f, 1.0f);
+	light3.SetRange(500.0f);
+	light3.SetColor(1.0f, 1.0f, 1.0f);
+
+	mesh = new Mesh("droid.x");
+	mesh->transform.SetPosition(0.0f, 24.0f, 50.0f);
+	mesh->transform.SetRotation(D3DXToRadian(-90), 0.0f, 0.0f);
+
+	// The first light and the chase camera ride on the droid. The droid is pitched -90 degrees, so in
+	// its space X is east, Y is south and Z is up
+	light.transform.SetParent(&mesh->transform);
+	light.SetPosition(-100.0f, -50.0f, 26.0f, 1.0f);
+	lightTransform = &light.transform;
+	Transform pivot;
+	pivot.SetParent(&mesh->transform);
+	chasePivot = &pivot;
+	Transform chase(0.0f, mesh->GetRadius() * 1.5f, 0.0f);
+	chase.SetParent(&pivot);
+	chaseCamera = &chase;
+
+	Mesh mesh2("plane.x");
+	mesh2.transform.SetPosition(-100.0f, 50.0f, 50.0f);
+	mesh2.transform.SetRotation(0.0f, D3DXToRadian(-45), 0.0f);
+	mesh2.transform.SetScale(10.0f, 10.0f, 10.0f);
+
+	Mesh mesh3("building.x", true); // Shows up once the loader threads have read it
+	mesh3.SetOccluder(true); // Meshes behind the building aren't drawn
+	if(benchmark)
+		Loader::Flush(); // Only time frames with the whole scene
+
+	vvd::SetMinKeyPressTime(DIK_F, 0.25f);
+
+	Renderers renderers = {&renderer, &shadowRenderer};
+	RenderPipeline* pipeline = 0;
+	if(pipelined) {
+		pipeline = new RenderPipeline(latency, RenderFrame, &renderers);
+		std::string msg = "Drawing on a render thread, up to ";
+		msg += vvd::stringconv(pipeline->GetMaxFramesInFlight());
+		msg += " frames behind";
+		vvd::Log(msg.c_str());
+	}
+
+	int frames = 0;
+	double frameTime = 0.0;
+	while(true) {
+		double frameStart = vvd::GetTime();
+		vvd::Update();
+
+		if(!CheckInputs())
+			break;
+
+		D3DXVECTOR3 cameraPos, cameraLook, cameraUp;
+		GetCamera(&cameraPos, &cameraLook, &cameraUp);
+
+		world.Update();
+		if(pipeline) {
+			// The render thread draws this frame while the next one is simulated
+			pipeline->Submit(&cameraPos, &cameraLook, &cameraUp);
+		} else {
+			renderer.SetCameraPosition(&cameraPos);
+			renderer.SetCameraRotation(&cameraLook, &cameraUp);
+			SetFillMode(&renderer);
+			shadowRenderer.DrawShadows();
+			renderer.Draw(&world);
+		}
+
+		if(benchmark) {
+			frameTime += vvd::GetTime() - frameStart;
+			frames++;
+			if(frames == BENCHMARK_FRAMES) {
+				std::string msg = "Benchmark: average CPU time per frame (ms): ";
+				msg += vvd::stringconv(frameTime * 1000.0 / (double)frames);
+				vvd::Log(msg.c_str());
+				vvd::LogFrameStats();
+				if(pipeline)
+					pipeline->Flush(); // The renderer is used on this thread next
+				BenchmarkTransformBatch();
+				BenchmarkRasterizer(&renderer);
+				break;
+			}
+		}
+
+		MSG msg;
+		if(!::PeekMessage(&msg, 0, 0, 0, PM_REMOVE)) {
+			if(msg.message == WM_QUIT) {
+				vvd::Log("Recieved quit message from windows; exiting message loop...");
+				break;
+			}
+			::TranslateMessage(&msg);
+			::DispatchMessage(&msg);
+		}
+	}
+	delete pipeline;
+	vvd::DeInit();
+	return 0;
+}
+// Sets the fill mode picked with the F key
+void SetFillMode(Renderer* renderer) {
+	switch(fillMode) {
+	case 0:
+		renderer->SetFillMode(D3DFILL_SOLID);
+		break;
+	case 1:
+		renderer->SetFillMode(D3DFILL_WIREFRAME);
+		break;
+	case 2:
+		renderer->SetFillMode(D3DFILL_POINT);
+		break;
+	}
+}
+// Gets the view from the free camera, or from the chase camera while C is held
+void GetCamera(D3DXVECTOR3* pos, D3DXVECTOR3* look, D3DXVECTOR3* up) {
+	if(chasing) {
+		// The chase camera is level with the droid, so it looks straight at it with the world's up
+		Vector3 chasePos = chaseCamera->GetWorldPosition();
+		Vector3 toDroid = mesh->transform.GetWorldPosition() - chasePos;
+		*pos = chasePos;
+		*look = toDroid / toDroid.Length();
+		*up = D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+	} else {
+		*pos = camera.GetPosition();
+		*look = camera.GetLookVector();
+		*up = camera.GetUpVector();
+	}
+}
+// Draws a frame the game thread submitted; runs on the render thread
+void RenderFrame(FrameSnapshot* snapshot, void* nRenderers) {
+	Renderers* renderers = (Renderers*)nRenderers;
+	renderers->scene->SetCameraPosition(&snapshot->cameraPos);
+	renderers->scene->SetCameraRotation(&snapshot->cameraLook, &snapshot->cameraUp);
+	SetFillMode(renderers->scene);
+	renderers->shadows->DrawShadows(snapshot);
+	renderers->scene->Draw(snapshot);
+}
+// Logs how long the SSE and one at a time paths of TransformBatch take for a large number of objects
+void BenchmarkTransformBatch() {
+	TransformBatch batch;
+	Vector3 center(0.0f, 0.0f, 0.0f);
+	for(int i = 0; i < BENCHMARK_OBJECTS; i++) {
+		Transform transform((float)(i % 100), (float)(i / 100), 0.0f, i * 0.01f, i * 0.02f, i * 0.03f);
+		batch.Add(&transform, &center, 1.0f);
+	}
+
+	double start = vvd::GetTime();
+	for(int i = 0; i < BENCHMARK_PASSES; i++)
+		batch.ComputeReference();
+	double referenceTime = vvd::GetTime() - start;
+
+	start = vvd::GetTime();
+	for(int i = 0; i < BENCHMARK_PASSES; i++)
+		batch.Compute();
+	double sseTime = vvd::GetTime() - start;
+
+	std::string msg = "Benchmark: one at a time transform batch (ms per pass): ";
+	msg += vvd::stringconv(referenceTime * 1000.0 / (double)BENCHMARK_PASSES);
+	vvd::Log(msg.c_str());
+	msg = "Benchmark: SSE transform batch (ms per pass): ";
+	msg += vvd::stringconv(sseTime * 1000.0 / (double)BENCHMARK_PASSES);
+	vvd::Log(msg.c_str());
+}
+// Logs how many frames per second the software rasterizer draws the scene at with different numbers of threads
+void BenchmarkRasterizer(Renderer* renderer) {
+	int threadCounts[] = {1, 2, 4, 0}; // 0 is one per processor
+	for(int i = 0; i < 4; i++) {
+		Rasterizer rasterizer(1024, 768, threadCounts[i]);
+		renderer->DrawSoftware(&rasterizer); // Warm up
+
+		double start = vvd::GetTime();
+		for(int j = 0; j < BENCHMARK_SOFTWARE_FRAMES; j++)
+			renderer->DrawSoftware(&rasterizer);
+		double time = vvd::GetTime() - start;
+
+		std::string msg = "Benchmark: software rasterizer with ";
+		msg += vvd::stringconv(rasterizer.GetNumThreads());
+		msg += " threads, ";
+		msg += vvd::stringconv(rasterizer.GetNumTriangles());
+		msg += " triangles (frames per second): ";
+		msg += vvd::stringconv((double)BENCHMARK_SOFTWARE_FRAMES / time);
+		vvd::Log(msg.c_str());
+		if(threadCounts[i] == 0)
+			rasterizer.SaveTGA("software.tga");
+	}
+}
+bool CheckInputs() {
+	if(vvd::keyDown(DIK_ESCAPE)) {
+		vvd::Log("User pressed escape; exiting message loop...");
+		return false;
+	}
+	if(vvd::keyDown(DIK_F)) {
+		vvd::Log("Switched fill mode");
+		fillMode++;
+		if(fillMode > 2) {
+			fillMode = 0;
+		}
+	}
+
+	float speed = 75.0f;
+	chasing = false;
+	if(vvd::mouseButtonDown(0)) {
+		if(vvd::keyDown(DIK_W))
+			mesh->transform.AddPositionRelative(speed * vvd::GetDelta(), 0.0f, 0.0f);
+		if(vvd::keyDown(DIK_A))
+			mesh->transform.AddPositionRelative(0.0f, -speed * vvd::GetDelta(), 0.0f);
+		if(vvd::keyDown(DIK_S))
+			mesh->transform.AddPositionRelative(-speed * vvd::GetDelta(), 0.0f, 0.0f);
+		if(vvd::keyDown(DIK_D))
+			mesh->transform.AddPositionRelative(0.0f, speed * vvd::GetDelta(), 0.0f);
+		if(vvd::keyDown(DIK_SPACE))
+			mesh->transform.AddPositionRelative(0.0f, 0.0f, speed * vvd::GetDelta());
+		if(vvd::keyDown(DIK_LCONTROL))
+			mesh->transform.AddPositionRelative(0.0f, 0.0f, -speed * vvd::GetDelta());
+		mesh->transform.AddRotation(0.0f, vvd::mouseDX() * 0.004f, 0.0f);
+	} else if(vvd::mouseButtonDown(1)) {
+		// Moves the light around the droid, in the droid's space
+		if(vvd::keyDown(DIK_W))
+			lightTransform->AddPositionRelative(0.0f, -speed * vvd::GetDelta(), 0.0f);
+		if(vvd::keyDown(DIK_A))
+			lightTransform->AddPositionRelative(-speed * vvd::GetDelta(), 0.0f, 0.0f);
+		if(vvd::keyDown(DIK_S))
+			lightTransform->AddPositionRelative(0.0f, speed * vvd::GetDelta(), 0.0f);
+		if(vvd::keyDown(DIK_D))
+			lightTransform->AddPositionRelative(speed * vvd::GetDelta(), 0.0f, 0.0f);
+		if(vvd::keyDown(DIK_SPACE))
+			lightTransform->AddPositionRelative(0.0f, 0.0f, speed * vvd::GetDelta());
+		if(vvd::keyDown(DIK_LCONTROL))
+			lightTransform->AddPositionRelative(0.0f, 0.0f, -speed * vvd::GetDelta());
+	} else if(vvd::keyDown(DIK_C)) {
+		// The chase camera follows the droid through its parents; only the pivot is turned here
+		chasing = true;
+		chasePivot->AddRotation(0.0f, 0.0f, 0.5f * vvd::GetDelta());
+	} else {
+		if(vvd::keyDown(DIK_W))
+			camera.AddPositionRelative(0.0f, 0.0f, speed * vvd::GetDelta());
+		if(vvd::keyDown(DIK_A))
+			camera.AddPositionRelative(-speed * vvd::GetDelta(), 0.0f, 0.0f);
+		if(vvd::keyDown(DIK_S))
+			camera.AddPositionRelative(0.0f, 0.0f, -speed * vvd::GetDelta());
+		if(vvd::keyDown(DIK_D))
+			camera.AddPositionRelative(speed * vvd::GetDelta(), 0.0f, 0.0f);
+		if(vvd::keyDown(DIK_SPACE))
+			camera.AddPositionRelative(0.0f, speed * vvd::GetDelta(), 0.0f);
+		if(vvd::keyDown(DIK_LCONTROL))
+			camera.AddPositionRelative(0.0f, -speed * vvd::GetDelta(), 0.0f);
+		camera.AddRotation(vvd::mouseDY() * 0.004f, vvd::mouseDX() * 0.004f, 0.0f);
+	}
+
+	return true;
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+// Checks the software rasterizer's coverage, depth testing and lighting without Direct3D,
+// and measures how many frames per second it draws with different numbers of threads
+
+#include "rasterizer.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define CLEAR_COLOR 0xFF000000
+
+static int failures = 0; // Number of checks that failed
+
+// Reports a failed check
+static void Check(bool ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+// Gets the wall clock time in seconds
+static double GetTime() {
+	timeval time;
+	gettimeofday(&time, 0);
+	return (double)time.tv_sec + (double)time.tv_usec / 1000000.0;
+}
+// Adds a clockwise quad facing -z, from (x0, y0) to (x1, y1) at depth z, in the specified material
+static void AddQuad(XMeshData* mesh, float x0, float y0, float x1, float y1, float z, unsigned int material) {
+	unsigned int first = (unsigned int)mesh->positions.size();
+	mesh->positions.push_back(Vector3(x0, y0, z));
+	mesh->positions.push_back(Vector3(x0, y1, z));
+	mesh->positions.push_back(Vector3(x1, y1, z));
+	mesh->positions.push_back(Vector3(x1, y0, z));
+	for(int i = 0; i < 4; i++)
+		mesh->normals.push_back(Vector3(0.0f, 0.0f, -1.0f));
+	unsigned int indices[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+	mesh->indices.insert(mesh->indices.end(), indices, indices + 6);
+	mesh->attributes.push_back(material);
+	mesh->attributes.push_back(material);
+}
+// Adds a material with the specified diffuse color
+static void AddMaterial(XMeshData* mesh, float r, float g, float b) {
+	XMaterial material;
+	material.diffuse = Vector4(r, g, b, 1.0f);
+	material.power = 0.0f;
+	material.specular = Vector3(0.0f, 0.0f, 0.0f);
+	material.emissive = Vector3(0.0f, 0.0f, 0.0f);
+	mesh->materials.push_back(material);
+}
+// Counts the pixels that aren't the clear color
+static int CountCovered(Rasterizer* rasterizer) {
+	int covered = 0;
+	for(int y = 0; y < rasterizer->GetHeight(); y++) {
+		for(int x = 0; x < rasterizer->GetWidth(); x++) {
+			if(rasterizer->GetColorBuffer()[y * rasterizer->GetPitch() + x] != CLEAR_COLOR)
+				covered++;
+		}
+	}
+	return covered;
+}
+// Gets the color of a pixel
+static unsigned int GetPixel(Rasterizer* rasterizer, int x, int y) {
+	return rasterizer->GetColorBuffer()[y * rasterizer->GetPitch() + x];
+}
+// Gets the depth of a pixel
+static float GetDepth(Rasterizer* rasterizer, int x, int y) {
+	return rasterizer->GetDepthBuffer()[y * rasterizer->GetPitch() + x];
+}
+// Checks that two triangles sharing an edge cover every pixel of a quad once, and that nearer triangles win
+static void TestCoverage() {
+	printf("Coverage and depth\n");
+	Rasterizer rasterizer(64, 64, 1);
+	Vector3 ambient(1.0f, 1.0f, 1.0f);
+	std::vector<SceneLight*> noLights;
+	rasterizer.SetLights(&noLights, &ambient);
+	Transform transform;
+
+	// The quad covers pixel centers 16 to 47 both ways; the shared diagonal runs through pixel centers
+	XMeshData quad;
+	AddMaterial(&quad, 1.0f, 1.0f, 1.0f);
+	AddQuad(&quad, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0);
+	rasterizer.Clear(CLEAR_COLOR);
+	rasterizer.DrawMesh(&quad, &transform);
+	rasterizer.Flush();
+	Check(CountCovered(&rasterizer) == 32 * 32, "the quad covers exactly its pixels, with no gaps along the shared edge");
+	Check(GetPixel(&rasterizer, 16, 16) == 0xFFFFFFFF && GetPixel(&rasterizer, 15, 16) == CLEAR_COLOR &&
+		GetPixel(&rasterizer, 47, 47) == 0xFFFFFFFF && GetPixel(&rasterizer, 48, 47) == CLEAR_COLOR, "the quad's edges land on the right pixels");
+	Check(GetDepth(&rasterizer, 30, 30) == 0.5f && GetDepth(&rasterizer, 0, 0) == 1.0f, "the quad writes its depth");
+
+	// Front to back in one mesh: a nearer red quad, then a farther green one behind everything
+	XMeshData layers;
+	AddMaterial(&layers, 1.0f, 0.0f, 0.0f);
+	AddMaterial(&layers, 0.0f, 1.0f, 0.0f);
+	AddQuad(&layers, -0.25f, -0.25f, 0.25f, 0.25f, 0.25f, 0);
+	AddQuad(&layers, -1.0f, -1.0f, 1.0f, 1.0f, 0.75f, 1);
+	rasterizer.DrawMesh(&layers, &transform);
+	rasterizer.Flush();
+	Check(GetPixel(&rasterizer, 32, 32) == 0xFFFF0000 && GetDepth(&rasterizer, 32, 32) == 0.25f, "the nearest triangle wins");
+	Check(GetPixel(&rasterizer, 20, 20) == 0xFFFFFFFF && GetDepth(&rasterizer, 20, 20) == 0.5f, "a farther triangle doesn't overwrite a nearer one");
+	Check(GetPixel(&rasterizer, 0, 0) == 0xFF00FF00 && GetDepth(&rasterizer, 0, 0) == 0.75f, "a farther triangle fills the empty pixels");
+	Check(CountCovered(&rasterizer) == 64 * 64, "the far quad covers the whole screen");
+
+	// The transform moves the mesh; the quad's right half goes off the screen
+	rasterizer.Clear(CLEAR_COLOR);
+	transform.SetPosition(1.0f, 0.0f, 0.0f);
+	rasterizer.DrawMesh(&quad, &transform);
+	rasterizer.Flush();
+	Check(CountCovered(&rasterizer) == 16 * 32 && GetPixel(&rasterizer, 48, 30) == 0xFFFFFFFF, "the transform moves the mesh");
+
+	// Reversed triangles are culled
+	XMeshData back = quad;
+	for(int i = 0; i < (int)back.indices.size(); i += 3)
+		std::swap(back.indices[i + 1], back.indices[i + 2]);
+	rasterizer.Clear(CLEAR_COLOR);
+	transform.SetPosition(0.0f, 0.0f, 0.0f);
+	rasterizer.DrawMesh(&back, &transform);
+	rasterizer.Flush();
+	Check(CountCovered(&rasterizer) == 0, "back faces are culled");
+}
+// Checks that SceneLights light the mesh the way the effects do
+static void TestLighting() {
+	printf("Lighting\n");
+	Rasterizer rasterizer(64, 64, 1);
+	XMeshData quad;
+	AddMaterial(&quad, 1.0f, 1.0f, 1.0f);
+	AddQuad(&quad, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0);
+	Transform transform;
+	Vector3 ambient(0.0f, 0.0f, 0.0f);
+
+	SceneLight light;
+	light.SetPosition(0.0f, 0.0f, 0.0f, 1.0f);
+	light.SetRange(2.0f);
+	light.SetColor(1.0f, 0.0f, 0.0f);
+	std::vector<SceneLight*> lights(1, &light);
+	rasterizer.SetLights(&lights, &ambient);
+	rasterizer.Clear(CLEAR_COLOR);
+	rasterizer.DrawMesh(&quad, &transform);
+	rasterizer.Flush();
+	unsigned int center = GetPixel(&rasterizer, 32, 32);
+	Check((center & 0x00FF0000) != 0 && (center & 0x0000FFFF) == 0, "a red light in front lights the quad red");
+
+	light.SetPosition(0.0f, 0.0f, 1.5f, 1.0f);
+	rasterizer.SetLights(&lights, &ambient);
+	rasterizer.Clear(CLEAR_COLOR);
+	rasterizer.DrawMesh(&quad, &transform);
+	rasterizer.Flush();
+	Check(GetPixel(&rasterizer, 32, 32) == 0xFF000000, "a light behind the quad doesn't light it");
+}
+// Builds layers of screen filling grids, so every tile has plenty of triangles and overdraw
+static void BuildBenchmarkMesh(XMeshData* mesh, int cells, int layers) {
+	AddMaterial(mesh, 0.8f, 0.8f, 0.8f);
+	for(int layer = 0; layer < layers; layer++) {
+		float z = 0.9f - layer * 0.1f; // Back to front, so every layer passes the depth test
+		for(int y = 0; y < cells; y++) {
+			for(int x = 0; x < cells; x++) {
+				float x0 = -1.0f + 2.0f * x / cells, y0 = -1.0f + 2.0f * y / cells;
+				AddQuad(mesh, x0, y0, x0 + 2.0f / cells, y0 + 2.0f / cells, z, 0);
+			}
+		}
+	}
+}
+// Draws the benchmark mesh with 1 to N threads; the pictures have to match and the frame rates are printed
+static void TestThreads() {
+	const int width = 640, height = 480, frames = 20;
+	printf("Threads\n");
+	XMeshData mesh;
+	BuildBenchmarkMesh(&mesh, 100, 4);
+	Transform transform;
+	Vector3 ambient(0.2f, 0.2f, 0.2f);
+	SceneLight light;
+	light.SetPosition(0.0f, 0.0f, -1.0f, 1.0f);
+	light.SetRange(3.0f);
+	std::vector<SceneLight*> lights(1, &light);
+
+	std::vector<unsigned int> reference;
+	// At least four threads, so the tiles are shared out even on machines with fewer processors
+	int maxThreads = Min(Max(Thread::GetNumProcessors(), 4), MAX_RASTER_THREADS);
+	for(int numThreads = 1; ; numThreads = Min(numThreads * 2, maxThreads)) {
+		Rasterizer rasterizer(width, height, numThreads);
+		rasterizer.SetLights(&lights, &ambient);
+		double start = GetTime();
+		for(int i = 0; i < frames; i++) {
+			rasterizer.Clear(CLEAR_COLOR);
+			rasterizer.DrawMesh(&mesh, &transform);
+			rasterizer.Flush();
+		}
+		double fps = frames / (GetTime() - start);
+		printf("%d thread%s: %.1f fps, %d triangles per frame\n", rasterizer.GetNumThreads(), rasterizer.GetNumThreads() == 1 ? "" : "s",
+			fps, rasterizer.GetNumTriangles());
+
+		const unsigned int* pixels = rasterizer.GetColorBuffer();
+		int numPixels = rasterizer.GetPitch() * height;
+		if(reference.empty()) {
+			reference.assign(pixels, pixels + numPixels);
+			Check(CountCovered(&rasterizer) == width * height, "the benchmark covers the screen");
+		} else {
+			Check(memcmp(&reference[0], pixels, numPixels * sizeof(unsigned int)) == 0, "every thread count draws the same picture");
+		}
+		if(numThreads >= maxThreads)
+			break;
+	}
+}
+int main() {
+	TestCoverage();
+	TestLighting();
+	TestThreads();
+
+	if(failures)
+		return 1;
+	printf("All rasterizer tests passed\n");
+	return 0;
+}
\ No newline at end of file
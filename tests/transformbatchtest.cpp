@@ -0,0 +1,149 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+// Checks the SSE transform batch against Transform and Frustum, and times it against them
+
+#include "transformbatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+static int failures = 0; // Number of checks that failed
+
+// Reports a failed check
+static void Check(bool ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+// Returns a random number in [min, max)
+static float Random(float min, float max) {
+	return min + (max - min) * (float)rand() / ((float)RAND_MAX + 1.0f);
+}
+// Returns true if the numbers differ by less than the tolerance, relative to their size
+static bool Near(float a, float b) {
+	return fabsf(a - b) <= 1e-3f * Max(1.0f, fabsf(b));
+}
+// Gets the milliseconds since the last call
+static double Elapsed() {
+	static clock_t last = clock();
+	clock_t now = clock();
+	double ms = (double)(now - last) * 1000.0 / CLOCKS_PER_SEC;
+	last = now;
+	return ms;
+}
+int main() {
+	const int count = 100003; // Not a multiple of four, so the padding gets used
+	const int runs = 20;
+	srand(1);
+	std::vector<Transform> transforms(count);
+	std::vector<Vector3> centers(count);
+	std::vector<float> radii(count);
+	TransformBatch batch;
+	for(int i = 0; i < count; i++) {
+		transforms[i].SetPosition(Random(-500.0f, 500.0f), Random(-500.0f, 500.0f), Random(-500.0f, 500.0f));
+		transforms[i].SetRotation(Random(-3.0f, 3.0f), Random(-3.0f, 3.0f), Random(-3.0f, 3.0f));
+		transforms[i].SetScale(Random(0.5f, 2.0f), Random(0.5f, 2.0f), Random(0.5f, 2.0f));
+		centers[i] = Vector3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f));
+		radii[i] = Random(1.0f, 10.0f);
+		batch.Add(&transforms[i], &centers[i], radii[i]);
+	}
+	Check(batch.GetCount() == count, "every object was added");
+
+	// Compute() has to match Transform and the one at a time version
+	batch.Compute();
+	TransformBatch reference = batch;
+	reference.ComputeReference();
+	bool matricesMatch = true, spheresMatch = true;
+	for(int i = 0; i < count; i++) {
+		Matrix m = transforms[i].GetMatrix();
+		Matrix* sse = batch.GetMatrices() + i;
+		Matrix* ref = reference.GetMatrices() + i;
+		for(int r = 0; r < 4; r++) {
+			for(int c = 0; c < 4; c++)
+				matricesMatch = matricesMatch && Near(sse->m[r][c], m.m[r][c]) && Near(ref->m[r][c], m.m[r][c]);
+		}
+		Vector3 center = m.TransformCoord(centers[i]);
+		float radius = radii[i] * Max(Max(m.GetRow(0).Length(), m.GetRow(1).Length()), m.GetRow(2).Length());
+		Vector4 sphere = batch.GetSphere(i);
+		Vector4 refSphere = reference.GetSphere(i);
+		spheresMatch = spheresMatch && Near(sphere.x, center.x) && Near(sphere.y, center.y) && Near(sphere.z, center.z) &&
+			Near(sphere.w, radius) && Near(refSphere.x, center.x) && Near(refSphere.w, radius);
+	}
+	Check(matricesMatch, "the batch's matrices match Transform::GetMatrix()");
+	Check(spheresMatch, "the batch's bounding spheres match the transformed spheres");
+
+	// Cull() has to keep exactly the spheres Frustum::Intersects() keeps
+	Matrix viewProj = Matrix::LookAtLH(Vector3(0.0f, 0.0f, -100.0f), Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f)) *
+		Matrix::PerspectiveFovLH(1.0f, 4.0f / 3.0f, 1.0f, 400.0f);
+	Frustum frustum(&viewProj);
+	std::vector<int> visible(count);
+	int numVisible = batch.Cull(&frustum, &visible[0]);
+	bool cullMatches = true;
+	int next = 0;
+	for(int i = 0; i < count; i++) {
+		Vector4 sphere = batch.GetSphere(i);
+		Vector3 center = sphere.XYZ();
+		if(frustum.Intersects(&center, sphere.w)) {
+			cullMatches = cullMatches && next < numVisible && visible[next] == i;
+			next++;
+		}
+	}
+	Check(cullMatches && next == numVisible, "Cull() keeps the same objects as Frustum::Intersects()");
+	Check(numVisible > 0 && numVisible < count, "some objects are culled and some aren't");
+
+	// Spheres already in world space cull the same way
+	TransformBatch spheres;
+	for(int i = 0; i < count; i++) {
+		Vector4 sphere = batch.GetSphere(i);
+		Vector3 center = sphere.XYZ();
+		spheres.AddSphere(&center, sphere.w);
+	}
+	std::vector<int> sphereVisible(count);
+	Check(spheres.Cull(&frustum, &sphereVisible[0]) == numVisible && sphereVisible[numVisible - 1] == visible[numVisible - 1],
+		"world spheres cull the same as the batch they came from");
+	spheres.Compute();
+	Check(Near(spheres.GetSphere(count - 1).w, batch.GetSphere(count - 1).w), "world spheres have identity transforms");
+
+	// Throughput
+	printf("%d objects, best of %d runs\n", count, runs);
+	double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+	int kept = 0;
+	for(int run = 0; run < runs; run++) {
+		Elapsed();
+		batch.Compute();
+		best[0] = Min(best[0], Elapsed());
+		reference.ComputeReference();
+		best[1] = Min(best[1], Elapsed());
+		kept += batch.Cull(&frustum, &visible[0]);
+		best[2] = Min(best[2], Elapsed());
+		for(int i = 0; i < count; i++) {
+			Vector4 sphere = batch.GetSphere(i);
+			Vector3 center = sphere.XYZ();
+			if(frustum.Intersects(&center, sphere.w))
+				kept++;
+		}
+		best[3] = Min(best[3], Elapsed());
+	}
+	printf("Compute: %.2f ms, ComputeReference: %.2f ms\n", best[0], best[1]);
+	printf("Cull: %.2f ms, Frustum::Intersects: %.2f ms (%d kept)\n", best[2], best[3], kept / (2 * runs));
+
+	if(failures)
+		return 1;
+	printf("All transform batch tests passed\n");
+	return 0;
+}
\ No newline at end of file
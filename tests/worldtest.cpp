@@ -0,0 +1,174 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+// Checks the World's cell assignment and the light ranking without Direct3D
+
+#include "world.h"
+#include "uniformgrid.h"
+#include "octree.h"
+#include <stdio.h>
+
+static int failures = 0; // Number of checks that failed
+
+// Reports a failed check
+static void Check(bool ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+// Returns true if the cell list holds the cell
+static bool HasCell(std::vector<Cell*>* cells, Cell* cell) {
+	for(int i = 0; i < (int)cells->size(); i++) {
+		if((*cells)[i] == cell)
+			return true;
+	}
+	return false;
+}
+// Puts meshes and lights in the cells of a world and checks the lights each mesh gets
+static void TestWorld(World* world, const char* name) {
+	printf("%s\n", name);
+	SceneMesh nearMesh;
+	nearMesh.SetBounds(Vector3(0.0f, 0.0f, 0.0f), 1.0f);
+	nearMesh.transform.SetPosition(5.0f, 5.0f, 5.0f);
+	SceneMesh::meshes.push_back(&nearMesh);
+	SceneMesh farMesh;
+	farMesh.SetBounds(Vector3(0.0f, 0.0f, 0.0f), 1.0f);
+	farMesh.transform.SetPosition(85.0f, 85.0f, 85.0f);
+	SceneMesh::meshes.push_back(&farMesh);
+
+	SceneLight bright;
+	bright.SetPosition(6.0f, 5.0f, 5.0f, 1.0f);
+	bright.SetRange(10.0f);
+	SceneLight dim;
+	dim.SetPosition(6.0f, 5.0f, 5.0f, 1.0f);
+	dim.SetRange(10.0f);
+	dim.SetColor(0.5f, 0.5f, 0.5f);
+	SceneLight sun;
+	sun.SetPosition(0.0f, -1.0f, 0.0f, 0.0f);
+	sun.SetColor(0.25f, 0.25f, 0.25f);
+	world->Update();
+
+	Check(!nearMesh.GetCells()->empty() && !farMesh.GetCells()->empty(), "every mesh is in a cell");
+	Cell* cell = world->GetIndex()->GetCell(Vector3(5.0f, 5.0f, 5.0f));
+	Check(HasCell(nearMesh.GetCells(), cell), "the mesh is in the cell at its position");
+	Check(!HasCell(farMesh.GetCells(), cell), "a distant mesh isn't in that cell");
+
+	std::vector<SceneLight*>* lights = nearMesh.GetLights();
+	Check(lights->size() == 3, "the near mesh gets both point lights and the directional light");
+	if(lights->size() == 3)
+		Check((*lights)[0] == &bright && (*lights)[1] == &dim && (*lights)[2] == &sun, "lights are ranked strongest first");
+	lights = farMesh.GetLights();
+	Check(lights->size() == 1 && (*lights)[0] == &sun, "the far mesh only gets the directional light");
+
+	// Moving the mesh moves it to other cells and out of the point lights' range
+	nearMesh.transform.SetPosition(85.0f, 5.0f, 5.0f);
+	world->Update();
+	Check(!HasCell(nearMesh.GetCells(), cell), "a moved mesh leaves its old cell");
+	lights = nearMesh.GetLights();
+	Check(lights->size() == 1 && (*lights)[0] == &sun, "a moved mesh drops the lights out of range");
+
+	// Lights carried by a parent move with it
+	bright.transform.SetParent(&nearMesh.transform);
+	bright.SetPosition(1.0f, 0.0f, 0.0f, 1.0f);
+	world->Update();
+	lights = nearMesh.GetLights();
+	Check(lights->size() == 2 && (*lights)[0] == &bright, "a light parented to the mesh lights it");
+
+	SceneMesh::meshes.remove(&nearMesh);
+	SceneMesh::meshes.remove(&farMesh);
+}
+// Checks that lights only go in cells the meshes created, and follow the light when it moves
+static void TestSparseLights() {
+	printf("Sparse octree lights\n");
+	Octree* octree = new Octree(1000.0f, 10.0f);
+	World world(octree);
+	SceneLight light;
+	light.SetPosition(0.0f, 0.0f, 0.0f, 1.0f);
+	light.SetRange(400.0f);
+	world.Update();
+	Check(octree->GetNumCells() == 0 && light.GetCells()->empty(), "a light alone creates no cells");
+
+	SceneMesh mesh;
+	mesh.SetBounds(Vector3(0.0f, 0.0f, 0.0f), 1.0f);
+	mesh.transform.SetPosition(50.0f, 0.0f, 0.0f);
+	SceneMesh::meshes.push_back(&mesh);
+	world.Update();
+	Check(octree->GetNumCells() > 0 && (int)light.GetCells()->size() == octree->GetNumCells(), "the light reaches the cells the mesh created");
+	Check(mesh.GetLights()->size() == 1, "the mesh gets the light");
+	int numNodes = octree->GetNumNodes();
+	world.Update();
+	Check(octree->GetNumNodes() == numNodes, "nothing moved, so no nodes were created");
+
+	light.SetPosition(500.0f, 500.0f, 500.0f, 1.0f);
+	light.SetRange(10.0f);
+	world.Update();
+	Check(light.GetCells()->empty() && mesh.GetLights()->empty(), "a moved light leaves the cells out of its range");
+	Check(octree->GetNumNodes() == numNodes, "a moved light doesn't create nodes");
+	SceneMesh::meshes.remove(&mesh);
+}
+// Checks that a light changing only makes the meshes in its cells select their lights again
+static void TestLightCaching() {
+	printf("Light caching\n");
+	World world(new UniformGrid(100.0f, 100.0f, 100.0f, 10.0f, 10.0f, 10.0f));
+	SceneMesh meshA;
+	meshA.SetBounds(Vector3(0.0f, 0.0f, 0.0f), 1.0f);
+	meshA.transform.SetPosition(5.0f, 5.0f, 5.0f);
+	SceneMesh::meshes.push_back(&meshA);
+	SceneMesh meshB;
+	meshB.SetBounds(Vector3(0.0f, 0.0f, 0.0f), 1.0f);
+	meshB.transform.SetPosition(85.0f, 85.0f, 85.0f);
+	SceneMesh::meshes.push_back(&meshB);
+	SceneLight lightA;
+	lightA.SetPosition(5.0f, 5.0f, 5.0f, 1.0f);
+	lightA.SetRange(4.0f);
+	SceneLight lightB;
+	lightB.SetPosition(85.0f, 85.0f, 85.0f, 1.0f);
+	lightB.SetRange(4.0f);
+	world.Update();
+	meshA.GetLights();
+	meshB.GetLights();
+
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	int selections = stats->lightSelections;
+	lightB.SetColor(1.0f, 0.0f, 0.0f);
+	lightB.SetPosition(85.0f, 86.0f, 85.0f, 1.0f);
+	world.Update();
+	meshA.GetLights();
+	Check(stats->lightSelections == selections, "a light changing in other cells keeps the mesh's lights");
+	Check(meshB.GetLights()->size() == 1 && stats->lightSelections == selections + 1, "a light changing in the mesh's cells ranks its lights again");
+	meshB.GetLights();
+	Check(stats->lightSelections == selections + 1, "the lights stay cached until something changes again");
+
+	// A light entering the mesh's cells
+	lightB.SetPosition(6.0f, 5.0f, 5.0f, 1.0f);
+	world.Update();
+	Check(meshA.GetLights()->size() == 2 && meshB.GetLights()->empty(), "a light moving between cells reaches the meshes it moved to");
+	SceneMesh::meshes.remove(&meshA);
+	SceneMesh::meshes.remove(&meshB);
+}
+int main() {
+	World grid(new UniformGrid(100.0f, 100.0f, 100.0f, 10.0f, 10.0f, 10.0f));
+	TestWorld(&grid, "UniformGrid");
+	World octree(new Octree(100.0f, 10.0f));
+	TestWorld(&octree, "Octree");
+	TestSparseLights();
+	TestLightCaching();
+	Check(SceneLight::lights.empty(), "destroyed lights leave the light list");
+
+	if(failures)
+		return 1;
+	printf("All world tests passed\n");
+	return 0;
+}
\ No newline at end of file
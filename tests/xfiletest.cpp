@@ -0,0 +1,58 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+// Checks that the X file parser reads a small mesh and rejects corrupt counts without allocating them
+
+#include "xfile.h"
+#include <stdio.h>
+#include <string.h>
+#include <new>
+
+static int failures = 0; // Number of checks that failed
+
+// Parses the text and checks whether it was accepted; the error has to contain the text specified if it wasn't
+static void CheckParse(const char* text, bool accepted, const char* error, const char* what) {
+	XFile parser;
+	XMeshData mesh;
+	bool result = false;
+	try {
+		result = parser.Parse(text, strlen(text), &mesh);
+	} catch(std::bad_alloc&) {
+		printf("FAILED: %s: the parser ran out of memory\n", what);
+		failures++;
+		return;
+	}
+	if(result != accepted || (!accepted && !strstr(parser.GetError(), error))) {
+		printf("FAILED: %s: %s\n", what, result ? "accepted" : parser.GetError());
+		failures++;
+	}
+}
+int main() {
+	CheckParse("xof 0302txt 0032\n"
+		"Mesh { 3; 0.0;0.0;0.0;, 1.0;0.0;0.0;, 0.0;1.0;0.0;; 1; 3;0,1,2;;\n"
+		"MeshNormals { 1; 0.0;0.0;1.0;; 1; 3;0,0,0;; }\n"
+		"MeshTextureCoords { 3; 0.0;0.0;, 1.0;0.0;, 0.0;1.0;; }\n"
+		"MeshMaterialList { 1; 1; 0;; Material { 1.0;1.0;1.0;1.0;; 0.0; 0.0;0.0;0.0;; 0.0;0.0;0.0;; } } }\n",
+		true, "", "a small mesh");
+	CheckParse("xof 0302txt 0032\nMesh { 4000000000; 0.0;0.0;0.0;; 0; }\n", false, "larger than the file", "a huge vertex count");
+	CheckParse("xof 0302txt 0032\nMesh { 1e30; 0.0;0.0;0.0;; 0; }\n", false, "out of range", "a vertex count too big for an unsigned int");
+	CheckParse("xof 0302txt 0032\nMesh { 1; 0.0;0.0;0.0;; 0; MeshNormals { 3000000000; } }\n", false, "larger than the file", "a huge normal count");
+	CheckParse("xof 0302txt 0032\nMesh { 1; 0.0;0.0;0.0;; 0; MeshTextureCoords { 4294967295; } }\n", false, "larger than the file", "a huge texture coordinate count");
+	CheckParse("xof 0302txt 0032\nMesh { 1; 0.0;0.0;0.0;; 0; MeshMaterialList { 1; 4294967295; } }\n", false, "larger than the file", "a huge face material count");
+
+	if(failures)
+		return 1;
+	printf("All X file tests passed\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "cell.h"
+#include "scene.h"
+#include <assert.h>
+Cell::Cell() {
+	color.x = 0.0f; color.y = 0.0f; color.z = 0.0f; color.w = 1.0f;
+	lightsRevision = 0;
+}
+// Returns true if the cell contains the specified mesh
+bool Cell::Contains(SceneMesh* mesh) {
+	// Iterate through the list and check if we've already added this mesh
+	for(int i = 0; i < (int)meshes.size(); i++) {
+		if(meshes[i] == mesh)
+			return true; // Yes
+	}
+	return false; // No
+}
+// Returns true if the cell contains the specified light
+bool Cell::Contains(SceneLight* light) {
+	// Iterate through the list and check if we've already added this light
+	for(int i = 0; i < (int)lights.size(); i++) {
+		if(lights[i] == light)
+			return true; // Yes
+	}
+	return false; // No
+}
+// Adds the specified mesh to the cell; it mustn't be in the cell already
+void Cell::AddMesh(SceneMesh* mesh) {
+	assert(!Contains(mesh)); // The World takes meshes out of their old cells first, so only debug builds search
+	meshes.push_back(mesh);
+	mesh->AddCell(this); // Add this cell to the mesh's list
+}
+// Adds the specified light to the cell; it mustn't be in the cell already
+void Cell::AddLight(SceneLight* light) {
+	assert(!Contains(light));
+	lights.push_back(light);
+	light->AddCell(this); // Add this cell to the light's list
+	LightChanged();
+}
+// Removes the specified mesh from the cell
+void Cell::RemoveMesh(SceneMesh* mesh) {
+	for(int i = 0; i < (int)meshes.size(); i++) {
+		if(meshes[i] == mesh) {
+			// Order doesn't matter, so swap with the last mesh instead of shifting the list
+			meshes[i] = meshes.back();
+			meshes.pop_back();
+			mesh->RemoveCell(this); // Remove this cell from the mesh's list
+			return;
+		}
+	}
+}
+// Removes the specified light from the cell
+void Cell::RemoveLight(SceneLight* light) {
+	for(int i = 0; i < (int)lights.size(); i++) {
+		if(lights[i] == light) {
+			lights[i] = lights.back();
+			lights.pop_back();
+			light->RemoveCell(this); // Remove this cell from the light's list
+			LightChanged();
+			return;
+		}
+	}
+}
+// Clears the lists of lights and meshes
+void Cell::Clear() {
+	for(int i = 0; i < (int)meshes.size(); i++)
+		meshes[i]->RemoveCell(this); // Remove this cell from the mesh's list
+
+	for(int i = 0; i < (int)lights.size(); i++)
+		lights[i]->RemoveCell(this); // Remove this cell from the light's list
+
+	if(!lights.empty())
+		LightChanged();
+	meshes.clear();
+	lights.clear();
+}
+// Sets the ambient color of the cell
+void Cell::SetAmbientColor(Vector3 nColor) {
+	color.x = nColor.x; color.y = nColor.y; color.z = nColor.z; color.w = 1.0f;
+}
+// Gets the ambient color of the cell
+Vector4 Cell::GetAmbientColor() {
+	return color;
+}
+// Gets the list of lights in the cell
+std::vector<SceneLight*>* Cell::GetLights() {
+	return &lights;
+}
+// Gets the list of meshes in the cell
+std::vector<SceneMesh*>* Cell::GetMeshes() {
+	return &meshes;
+}
+// Gets SceneLight::GetLightingRevision() as of the last time a light entered, left or changed in the cell
+int Cell::GetLightsRevision() {
+	return lightsRevision;
+}
+// Called by the lights in the cell when they move, change range or are recolored
+void Cell::LightChanged() {
+	lightsRevision = SceneLight::GetLightingRevision();
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "countingdevice.h"
+
+// Takes over the caller's reference to the real device
+CountingDevice::CountingDevice(IDirect3DDevice9* ndevice) {
+	device = ndevice;
+	references = 1;
+}
+// Gets the device the calls are passed to
+IDirect3DDevice9* CountingDevice::GetRealDevice() {
+	return device;
+}
+// Hands out the CountingDevice for the device interface, so nothing gets around it; anything else goes to the real device
+HRESULT STDMETHODCALLTYPE CountingDevice::QueryInterface(REFIID riid, void** ppvObj) {
+	if(IsEqualGUID(riid, IID_IDirect3DDevice9) || IsEqualGUID(riid, IID_IUnknown)) {
+		AddRef();
+		*ppvObj = this;
+		return S_OK;
+	}
+	return device->QueryInterface(riid, ppvObj);
+}
+// Adds a reference; D3DX meshes and effects keep one while they're alive
+ULONG STDMETHODCALLTYPE CountingDevice::AddRef() {
+	return InterlockedIncrement(&references);
+}
+// Releases the real device and deletes the CountingDevice with the last reference
+ULONG STDMETHODCALLTYPE CountingDevice::Release() {
+	ULONG count = InterlockedDecrement(&references);
+	if(count == 0) {
+		device->Release();
+		delete this;
+	}
+	return count;
+}
+// Sets a render target
+HRESULT STDMETHODCALLTYPE CountingDevice::SetRenderTarget(DWORD RenderTargetIndex, IDirect3DSurface9* pRenderTarget) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetRenderTarget(RenderTargetIndex, pRenderTarget);
+}
+// Sets the depth buffer
+HRESULT STDMETHODCALLTYPE CountingDevice::SetDepthStencilSurface(IDirect3DSurface9* pNewZStencil) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetDepthStencilSurface(pNewZStencil);
+}
+// Sets the viewport
+HRESULT STDMETHODCALLTYPE CountingDevice::SetViewport(CONST D3DVIEWPORT9* pViewport) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetViewport(pViewport);
+}
+// Sets the scissor rectangle
+HRESULT STDMETHODCALLTYPE CountingDevice::SetScissorRect(CONST RECT* pRect) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetScissorRect(pRect);
+}
+// Sets a fixed function transform
+HRESULT STDMETHODCALLTYPE CountingDevice::SetTransform(D3DTRANSFORMSTATETYPE State, CONST D3DMATRIX* pMatrix) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetTransform(State, pMatrix);
+}
+// Sets a user clip plane
+HRESULT STDMETHODCALLTYPE CountingDevice::SetClipPlane(DWORD Index, CONST float* pPlane) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetClipPlane(Index, pPlane);
+}
+// Sets a render state
+HRESULT STDMETHODCALLTYPE CountingDevice::SetRenderState(D3DRENDERSTATETYPE State, DWORD Value) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetRenderState(State, Value);
+}
+// Binds a texture to a sampler
+HRESULT STDMETHODCALLTYPE CountingDevice::SetTexture(DWORD Stage, IDirect3DBaseTexture9* pTexture) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetTexture(Stage, pTexture);
+}
+// Sets a fixed function texture stage state
+HRESULT STDMETHODCALLTYPE CountingDevice::SetTextureStageState(DWORD Stage, D3DTEXTURESTAGESTATETYPE Type, DWORD Value) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetTextureStageState(Stage, Type, Value);
+}
+// Sets a sampler state
+HRESULT STDMETHODCALLTYPE CountingDevice::SetSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD Value) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetSamplerState(Sampler, Type, Value);
+}
+// Sets the vertex declaration
+HRESULT STDMETHODCALLTYPE CountingDevice::SetVertexDeclaration(IDirect3DVertexDeclaration9* pDecl) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetVertexDeclaration(pDecl);
+}
+// Sets the flexible vertex format
+HRESULT STDMETHODCALLTYPE CountingDevice::SetFVF(DWORD FVF) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetFVF(FVF);
+}
+// Sets the vertex shader
+HRESULT STDMETHODCALLTYPE CountingDevice::SetVertexShader(IDirect3DVertexShader9* pShader) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetVertexShader(pShader);
+}
+// Sets the pixel shader
+HRESULT STDMETHODCALLTYPE CountingDevice::SetPixelShader(IDirect3DPixelShader9* pShader) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetPixelShader(pShader);
+}
+// Binds a vertex buffer to a stream
+HRESULT STDMETHODCALLTYPE CountingDevice::SetStreamSource(UINT StreamNumber, IDirect3DVertexBuffer9* pStreamData, UINT OffsetInBytes, UINT Stride) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetStreamSource(StreamNumber, pStreamData, OffsetInBytes, Stride);
+}
+// Sets a stream's instancing frequency
+HRESULT STDMETHODCALLTYPE CountingDevice::SetStreamSourceFreq(UINT StreamNumber, UINT Setting) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetStreamSourceFreq(StreamNumber, Setting);
+}
+// Binds an index buffer
+HRESULT STDMETHODCALLTYPE CountingDevice::SetIndices(IDirect3DIndexBuffer9* pIndexData) {
+	vvd::GetFrameStats()->deviceStateChanges++;
+	return device->SetIndices(pIndexData);
+}
+// Uploads float vertex shader constants
+HRESULT STDMETHODCALLTYPE CountingDevice::SetVertexShaderConstantF(UINT StartRegister, CONST float* pConstantData, UINT Vector4fCount) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceConstantUploads++;
+	stats->deviceConstants += Vector4fCount;
+	return device->SetVertexShaderConstantF(StartRegister, pConstantData, Vector4fCount);
+}
+// Uploads integer vertex shader constants
+HRESULT STDMETHODCALLTYPE CountingDevice::SetVertexShaderConstantI(UINT StartRegister, CONST int* pConstantData, UINT Vector4iCount) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceConstantUploads++;
+	stats->deviceConstants += Vector4iCount;
+	return device->SetVertexShaderConstantI(StartRegister, pConstantData, Vector4iCount);
+}
+// Uploads bool vertex shader constants
+HRESULT STDMETHODCALLTYPE CountingDevice::SetVertexShaderConstantB(UINT StartRegister, CONST BOOL* pConstantData, UINT BoolCount) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceConstantUploads++;
+	stats->deviceConstants += BoolCount;
+	return device->SetVertexShaderConstantB(StartRegister, pConstantData, BoolCount);
+}
+// Uploads float pixel shader constants
+HRESULT STDMETHODCALLTYPE CountingDevice::SetPixelShaderConstantF(UINT StartRegister, CONST float* pConstantData, UINT Vector4fCount) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceConstantUploads++;
+	stats->deviceConstants += Vector4fCount;
+	return device->SetPixelShaderConstantF(StartRegister, pConstantData, Vector4fCount);
+}
+// Uploads integer pixel shader constants
+HRESULT STDMETHODCALLTYPE CountingDevice::SetPixelShaderConstantI(UINT StartRegister, CONST int* pConstantData, UINT Vector4iCount) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceConstantUploads++;
+	stats->deviceConstants += Vector4iCount;
+	return device->SetPixelShaderConstantI(StartRegister, pConstantData, Vector4iCount);
+}
+// Uploads bool pixel shader constants
+HRESULT STDMETHODCALLTYPE CountingDevice::SetPixelShaderConstantB(UINT StartRegister, CONST BOOL* pConstantData, UINT BoolCount) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceConstantUploads++;
+	stats->deviceConstants += BoolCount;
+	return device->SetPixelShaderConstantB(StartRegister, pConstantData, BoolCount);
+}
+// Draws non-indexed primitives
+HRESULT STDMETHODCALLTYPE CountingDevice::DrawPrimitive(D3DPRIMITIVETYPE PrimitiveType, UINT StartVertex, UINT PrimitiveCount) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceDrawCalls++;
+	stats->devicePrimitives += PrimitiveCount;
+	return device->DrawPrimitive(PrimitiveType, StartVertex, PrimitiveCount);
+}
+// Draws indexed primitives; ID3DXMesh::DrawSubset() ends up here
+HRESULT STDMETHODCALLTYPE CountingDevice::DrawIndexedPrimitive(D3DPRIMITIVETYPE PrimitiveType, INT BaseVertexIndex, UINT MinVertexIndex, UINT NumVertices, UINT startIndex, UINT primCount) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceDrawCalls++;
+	stats->devicePrimitives += primCount;
+	return device->DrawIndexedPrimitive(PrimitiveType, BaseVertexIndex, MinVertexIndex, NumVertices, startIndex, primCount);
+}
+// Draws non-indexed primitives from user memory
+HRESULT STDMETHODCALLTYPE CountingDevice::DrawPrimitiveUP(D3DPRIMITIVETYPE PrimitiveType, UINT PrimitiveCount, CONST void* pVertexStreamZeroData, UINT VertexStreamZeroStride) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceDrawCalls++;
+	stats->devicePrimitives += PrimitiveCount;
+	return device->DrawPrimitiveUP(PrimitiveType, PrimitiveCount, pVertexStreamZeroData, VertexStreamZeroStride);
+}
+// Draws indexed primitives from user memory
+HRESULT STDMETHODCALLTYPE CountingDevice::DrawIndexedPrimitiveUP(D3DPRIMITIVETYPE PrimitiveType, UINT MinVertexIndex, UINT NumVertices, UINT PrimitiveCount, CONST void* pIndexData, D3DFORMAT IndexDataFormat, CONST void* pVertexStreamZeroData, UINT VertexStreamZeroStride) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	stats->deviceDrawCalls++;
+	stats->devicePrimitives += PrimitiveCount;
+	return device->DrawIndexedPrimitiveUP(PrimitiveType, MinVertexIndex, NumVertices, PrimitiveCount, pIndexData, IndexDataFormat, pVertexStreamZeroData, VertexStreamZeroStride);
+}
+// Draws a rectangular patch
+HRESULT STDMETHODCALLTYPE CountingDevice::DrawRectPatch(UINT Handle, CONST float* pNumSegs, CONST D3DRECTPATCH_INFO* pRectPatchInfo) {
+	vvd::GetFrameStats()->deviceDrawCalls++;
+	return device->DrawRectPatch(Handle, pNumSegs, pRectPatchInfo);
+}
+// Draws a triangular patch
+HRESULT STDMETHODCALLTYPE CountingDevice::DrawTriPatch(UINT Handle, CONST float* pNumSegs, CONST D3DTRIPATCH_INFO* pTriPatchInfo) {
+	vvd::GetFrameStats()->deviceDrawCalls++;
+	return device->DrawTriPatch(Handle, pNumSegs, pTriPatchInfo);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef cell_h
+#define cell_h
+#include "vmath.h"
+#include <vector>
+
+class SceneMesh;
+class SceneLight;
+
+// The World is divided into Cells, which contain Meshes and Lights
+struct Cell {
+public:
+	Cell();
+	bool Contains(SceneMesh* mesh); // Returns true if the cell contains the specified mesh
+	bool Contains(SceneLight* light); // Returns true if the cell contains the specified light
+	void AddMesh(SceneMesh* mesh); // Adds the specified mesh to the cell; it mustn't be in the cell already
+	void AddLight(SceneLight* light); // Adds the specified light to the cell; it mustn't be in the cell already
+	void RemoveMesh(SceneMesh* mesh); // Removes the specified mesh from the cell
+	void RemoveLight(SceneLight* light); // Removes the specified light from the cell
+	void Clear(); // Clears the lists of lights and meshes
+	void SetAmbientColor(Vector3 nColor); // Sets the ambient color of the cell
+	Vector4 GetAmbientColor(); // Gets the ambient color of the cell
+	std::vector<SceneLight*>* GetLights(); // Gets the list of lights in the cell
+	std::vector<SceneMesh*>* GetMeshes(); // Gets the list of meshes in the cell
+	// Gets SceneLight::GetLightingRevision() as of the last time a light entered, left or changed in the cell
+	// A mesh whose lights were selected after that doesn't need to select them again for this cell
+	int GetLightsRevision();
+	void LightChanged(); // Called by the lights in the cell when they move, change range or are recolored
+private:
+	Vector4 color; // Ambient color
+	std::vector<SceneMesh*> meshes; // List of meshes in the cell
+	std::vector<SceneLight*> lights; // List of lights in the cell
+	int lightsRevision; // SceneLight::GetLightingRevision() when the lights in the cell last changed
+};
+
+#endif
\ No newline at end of file
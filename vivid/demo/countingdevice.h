@@ -0,0 +1,162 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#ifndef countingdevice_h
+#define countingdevice_h
+#include "vivid.h"
+
+// Sits in front of the real device and counts the state changes, shader constant uploads and draw calls
+// made through it in GetFrameStats(). Init() hands it out from GetDevice() on the null device, so the calls
+// D3DX meshes and effects make on their own are counted too, not just the ones the Renderer makes.
+// Everything else is passed straight through
+class CountingDevice : public IDirect3DDevice9 {
+public:
+	CountingDevice(IDirect3DDevice9* device); // Takes over the caller's reference to the real device
+	IDirect3DDevice9* GetRealDevice(); // Gets the device the calls are passed to
+
+	// IUnknown
+	STDMETHOD(QueryInterface)(REFIID riid, void** ppvObj);
+	STDMETHOD_(ULONG, AddRef)();
+	STDMETHOD_(ULONG, Release)(); // Releases the real device and deletes the CountingDevice with the last reference
+
+	// Counted in FrameStats::deviceStateChanges
+	STDMETHOD(SetRenderTarget)(DWORD RenderTargetIndex, IDirect3DSurface9* pRenderTarget);
+	STDMETHOD(SetDepthStencilSurface)(IDirect3DSurface9* pNewZStencil);
+	STDMETHOD(SetViewport)(CONST D3DVIEWPORT9* pViewport);
+	STDMETHOD(SetScissorRect)(CONST RECT* pRect);
+	STDMETHOD(SetTransform)(D3DTRANSFORMSTATETYPE State, CONST D3DMATRIX* pMatrix);
+	STDMETHOD(SetClipPlane)(DWORD Index, CONST float* pPlane);
+	STDMETHOD(SetRenderState)(D3DRENDERSTATETYPE State, DWORD Value);
+	STDMETHOD(SetTexture)(DWORD Stage, IDirect3DBaseTexture9* pTexture);
+	STDMETHOD(SetTextureStageState)(DWORD Stage, D3DTEXTURESTAGESTATETYPE Type, DWORD Value);
+	STDMETHOD(SetSamplerState)(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD Value);
+	STDMETHOD(SetVertexDeclaration)(IDirect3DVertexDeclaration9* pDecl);
+	STDMETHOD(SetFVF)(DWORD FVF);
+	STDMETHOD(SetVertexShader)(IDirect3DVertexShader9* pShader);
+	STDMETHOD(SetPixelShader)(IDirect3DPixelShader9* pShader);
+	STDMETHOD(SetStreamSource)(UINT StreamNumber, IDirect3DVertexBuffer9* pStreamData, UINT OffsetInBytes, UINT Stride);
+	STDMETHOD(SetStreamSourceFreq)(UINT StreamNumber, UINT Setting);
+	STDMETHOD(SetIndices)(IDirect3DIndexBuffer9* pIndexData);
+
+	// Counted in FrameStats::deviceConstantUploads and deviceConstants
+	STDMETHOD(SetVertexShaderConstantF)(UINT StartRegister, CONST float* pConstantData, UINT Vector4fCount);
+	STDMETHOD(SetVertexShaderConstantI)(UINT StartRegister, CONST int* pConstantData, UINT Vector4iCount);
+	STDMETHOD(SetVertexShaderConstantB)(UINT StartRegister, CONST BOOL* pConstantData, UINT BoolCount);
+	STDMETHOD(SetPixelShaderConstantF)(UINT StartRegister, CONST float* pConstantData, UINT Vector4fCount);
+	STDMETHOD(SetPixelShaderConstantI)(UINT StartRegister, CONST int* pConstantData, UINT Vector4iCount);
+	STDMETHOD(SetPixelShaderConstantB)(UINT StartRegister, CONST BOOL* pConstantData, UINT BoolCount);
+
+	// Counted in FrameStats::deviceDrawCalls and devicePrimitives
+	STDMETHOD(DrawPrimitive)(D3DPRIMITIVETYPE PrimitiveType, UINT StartVertex, UINT PrimitiveCount);
+	STDMETHOD(DrawIndexedPrimitive)(D3DPRIMITIVETYPE PrimitiveType, INT BaseVertexIndex, UINT MinVertexIndex, UINT NumVertices, UINT startIndex, UINT primCount);
+	STDMETHOD(DrawPrimitiveUP)(D3DPRIMITIVETYPE PrimitiveType, UINT PrimitiveCount, CONST void* pVertexStreamZeroData, UINT VertexStreamZeroStride);
+	STDMETHOD(DrawIndexedPrimitiveUP)(D3DPRIMITIVETYPE PrimitiveType, UINT MinVertexIndex, UINT NumVertices, UINT PrimitiveCount, CONST void* pIndexData, D3DFORMAT IndexDataFormat, CONST void* pVertexStreamZeroData, UINT VertexStreamZeroStride);
+	STDMETHOD(DrawRectPatch)(UINT Handle, CONST float* pNumSegs, CONST D3DRECTPATCH_INFO* pRectPatchInfo);
+	STDMETHOD(DrawTriPatch)(UINT Handle, CONST float* pNumSegs, CONST D3DTRIPATCH_INFO* pTriPatchInfo);
+
+	// Passed through
+	STDMETHOD(TestCooperativeLevel)() { return device->TestCooperativeLevel(); }
+	STDMETHOD_(UINT, GetAvailableTextureMem)() { return device->GetAvailableTextureMem(); }
+	STDMETHOD(EvictManagedResources)() { return device->EvictManagedResources(); }
+	STDMETHOD(GetDirect3D)(IDirect3D9** ppD3D9) { return device->GetDirect3D(ppD3D9); }
+	STDMETHOD(GetDeviceCaps)(D3DCAPS9* pCaps) { return device->GetDeviceCaps(pCaps); }
+	STDMETHOD(GetDisplayMode)(UINT iSwapChain, D3DDISPLAYMODE* pMode) { return device->GetDisplayMode(iSwapChain, pMode); }
+	STDMETHOD(GetCreationParameters)(D3DDEVICE_CREATION_PARAMETERS* pParameters) { return device->GetCreationParameters(pParameters); }
+	STDMETHOD(SetCursorProperties)(UINT XHotSpot, UINT YHotSpot, IDirect3DSurface9* pCursorBitmap) { return device->SetCursorProperties(XHotSpot, YHotSpot, pCursorBitmap); }
+	STDMETHOD_(void, SetCursorPosition)(int X, int Y, DWORD Flags) { device->SetCursorPosition(X, Y, Flags); }
+	STDMETHOD_(BOOL, ShowCursor)(BOOL bShow) { return device->ShowCursor(bShow); }
+	STDMETHOD(CreateAdditionalSwapChain)(D3DPRESENT_PARAMETERS* pPresentationParameters, IDirect3DSwapChain9** pSwapChain) { return device->CreateAdditionalSwapChain(pPresentationParameters, pSwapChain); }
+	STDMETHOD(GetSwapChain)(UINT iSwapChain, IDirect3DSwapChain9** pSwapChain) { return device->GetSwapChain(iSwapChain, pSwapChain); }
+	STDMETHOD_(UINT, GetNumberOfSwapChains)() { return device->GetNumberOfSwapChains(); }
+	STDMETHOD(Reset)(D3DPRESENT_PARAMETERS* pPresentationParameters) { return device->Reset(pPresentationParameters); }
+	STDMETHOD(Present)(CONST RECT* pSourceRect, CONST RECT* pDestRect, HWND hDestWindowOverride, CONST RGNDATA* pDirtyRegion) { return device->Present(pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion); }
+	STDMETHOD(GetBackBuffer)(UINT iSwapChain, UINT iBackBuffer, D3DBACKBUFFER_TYPE Type, IDirect3DSurface9** ppBackBuffer) { return device->GetBackBuffer(iSwapChain, iBackBuffer, Type, ppBackBuffer); }
+	STDMETHOD(GetRasterStatus)(UINT iSwapChain, D3DRASTER_STATUS* pRasterStatus) { return device->GetRasterStatus(iSwapChain, pRasterStatus); }
+	STDMETHOD(SetDialogBoxMode)(BOOL bEnableDialogs) { return device->SetDialogBoxMode(bEnableDialogs); }
+	STDMETHOD_(void, SetGammaRamp)(UINT iSwapChain, DWORD Flags, CONST D3DGAMMARAMP* pRamp) { device->SetGammaRamp(iSwapChain, Flags, pRamp); }
+	STDMETHOD_(void, GetGammaRamp)(UINT iSwapChain, D3DGAMMARAMP* pRamp) { device->GetGammaRamp(iSwapChain, pRamp); }
+	STDMETHOD(CreateTexture)(UINT Width, UINT Height, UINT Levels, DWORD Usage, D3DFORMAT Format, D3DPOOL Pool, IDirect3DTexture9** ppTexture, HANDLE* pSharedHandle) { return device->CreateTexture(Width, Height, Levels, Usage, Format, Pool, ppTexture, pSharedHandle); }
+	STDMETHOD(CreateVolumeTexture)(UINT Width, UINT Height, UINT Depth, UINT Levels, DWORD Usage, D3DFORMAT Format, D3DPOOL Pool, IDirect3DVolumeTexture9** ppVolumeTexture, HANDLE* pSharedHandle) { return device->CreateVolumeTexture(Width, Height, Depth, Levels, Usage, Format, Pool, ppVolumeTexture, pSharedHandle); }
+	STDMETHOD(CreateCubeTexture)(UINT EdgeLength, UINT Levels, DWORD Usage, D3DFORMAT Format, D3DPOOL Pool, IDirect3DCubeTexture9** ppCubeTexture, HANDLE* pSharedHandle) { return device->CreateCubeTexture(EdgeLength, Levels, Usage, Format, Pool, ppCubeTexture, pSharedHandle); }
+	STDMETHOD(CreateVertexBuffer)(UINT Length, DWORD Usage, DWORD FVF, D3DPOOL Pool, IDirect3DVertexBuffer9** ppVertexBuffer, HANDLE* pSharedHandle) { return device->CreateVertexBuffer(Length, Usage, FVF, Pool, ppVertexBuffer, pSharedHandle); }
+	STDMETHOD(CreateIndexBuffer)(UINT Length, DWORD Usage, D3DFORMAT Format, D3DPOOL Pool, IDirect3DIndexBuffer9** ppIndexBuffer, HANDLE* pSharedHandle) { return device->CreateIndexBuffer(Length, Usage, Format, Pool, ppIndexBuffer, pSharedHandle); }
+	STDMETHOD(CreateRenderTarget)(UINT Width, UINT Height, D3DFORMAT Format, D3DMULTISAMPLE_TYPE MultiSample, DWORD MultisampleQuality, BOOL Lockable, IDirect3DSurface9** ppSurface, HANDLE* pSharedHandle) { return device->CreateRenderTarget(Width, Height, Format, MultiSample, MultisampleQuality, Lockable, ppSurface, pSharedHandle); }
+	STDMETHOD(CreateDepthStencilSurface)(UINT Width, UINT Height, D3DFORMAT Format, D3DMULTISAMPLE_TYPE MultiSample, DWORD MultisampleQuality, BOOL Discard, IDirect3DSurface9** ppSurface, HANDLE* pSharedHandle) { return device->CreateDepthStencilSurface(Width, Height, Format, MultiSample, MultisampleQuality, Discard, ppSurface, pSharedHandle); }
+	STDMETHOD(UpdateSurface)(IDirect3DSurface9* pSourceSurface, CONST RECT* pSourceRect, IDirect3DSurface9* pDestinationSurface, CONST POINT* pDestPoint) { return device->UpdateSurface(pSourceSurface, pSourceRect, pDestinationSurface, pDestPoint); }
+	STDMETHOD(UpdateTexture)(IDirect3DBaseTexture9* pSourceTexture, IDirect3DBaseTexture9* pDestinationTexture) { return device->UpdateTexture(pSourceTexture, pDestinationTexture); }
+	STDMETHOD(GetRenderTargetData)(IDirect3DSurface9* pRenderTarget, IDirect3DSurface9* pDestSurface) { return device->GetRenderTargetData(pRenderTarget, pDestSurface); }
+	STDMETHOD(GetFrontBufferData)(UINT iSwapChain, IDirect3DSurface9* pDestSurface) { return device->GetFrontBufferData(iSwapChain, pDestSurface); }
+	STDMETHOD(StretchRect)(IDirect3DSurface9* pSourceSurface, CONST RECT* pSourceRect, IDirect3DSurface9* pDestSurface, CONST RECT* pDestRect, D3DTEXTUREFILTERTYPE Filter) { return device->StretchRect(pSourceSurface, pSourceRect, pDestSurface, pDestRect, Filter); }
+	STDMETHOD(ColorFill)(IDirect3DSurface9* pSurface, CONST RECT* pRect, D3DCOLOR color) { return device->ColorFill(pSurface, pRect, color); }
+	STDMETHOD(CreateOffscreenPlainSurface)(UINT Width, UINT Height, D3DFORMAT Format, D3DPOOL Pool, IDirect3DSurface9** ppSurface, HANDLE* pSharedHandle) { return device->CreateOffscreenPlainSurface(Width, Height, Format, Pool, ppSurface, pSharedHandle); }
+	STDMETHOD(GetRenderTarget)(DWORD RenderTargetIndex, IDirect3DSurface9** ppRenderTarget) { return device->GetRenderTarget(RenderTargetIndex, ppRenderTarget); }
+	STDMETHOD(GetDepthStencilSurface)(IDirect3DSurface9** ppZStencilSurface) { return device->GetDepthStencilSurface(ppZStencilSurface); }
+	STDMETHOD(BeginScene)() { return device->BeginScene(); }
+	STDMETHOD(EndScene)() { return device->EndScene(); }
+	STDMETHOD(Clear)(DWORD Count, CONST D3DRECT* pRects, DWORD Flags, D3DCOLOR Color, float Z, DWORD Stencil) { return device->Clear(Count, pRects, Flags, Color, Z, Stencil); }
+	STDMETHOD(GetTransform)(D3DTRANSFORMSTATETYPE State, D3DMATRIX* pMatrix) { return device->GetTransform(State, pMatrix); }
+	STDMETHOD(MultiplyTransform)(D3DTRANSFORMSTATETYPE State, CONST D3DMATRIX* pMatrix) { return device->MultiplyTransform(State, pMatrix); }
+	STDMETHOD(GetViewport)(D3DVIEWPORT9* pViewport) { return device->GetViewport(pViewport); }
+	STDMETHOD(SetMaterial)(CONST D3DMATERIAL9* pMaterial) { return device->SetMaterial(pMaterial); }
+	STDMETHOD(GetMaterial)(D3DMATERIAL9* pMaterial) { return device->GetMaterial(pMaterial); }
+	STDMETHOD(SetLight)(DWORD Index, CONST D3DLIGHT9* pLight) { return device->SetLight(Index, pLight); }
+	STDMETHOD(GetLight)(DWORD Index, D3DLIGHT9* pLight) { return device->GetLight(Index, pLight); }
+	STDMETHOD(LightEnable)(DWORD Index, BOOL Enable) { return device->LightEnable(Index, Enable); }
+	STDMETHOD(GetLightEnable)(DWORD Index, BOOL* pEnable) { return device->GetLightEnable(Index, pEnable); }
+	STDMETHOD(GetClipPlane)(DWORD Index, float* pPlane) { return device->GetClipPlane(Index, pPlane); }
+	STDMETHOD(GetRenderState)(D3DRENDERSTATETYPE State, DWORD* pValue) { return device->GetRenderState(State, pValue); }
+	STDMETHOD(CreateStateBlock)(D3DSTATEBLOCKTYPE Type, IDirect3DStateBlock9** ppSB) { return device->CreateStateBlock(Type, ppSB); }
+	STDMETHOD(BeginStateBlock)() { return device->BeginStateBlock(); }
+	STDMETHOD(EndStateBlock)(IDirect3DStateBlock9** ppSB) { return device->EndStateBlock(ppSB); }
+	STDMETHOD(SetClipStatus)(CONST D3DCLIPSTATUS9* pClipStatus) { return device->SetClipStatus(pClipStatus); }
+	STDMETHOD(GetClipStatus)(D3DCLIPSTATUS9* pClipStatus) { return device->GetClipStatus(pClipStatus); }
+	STDMETHOD(GetTexture)(DWORD Stage, IDirect3DBaseTexture9** ppTexture) { return device->GetTexture(Stage, ppTexture); }
+	STDMETHOD(GetTextureStageState)(DWORD Stage, D3DTEXTURESTAGESTATETYPE Type, DWORD* pValue) { return device->GetTextureStageState(Stage, Type, pValue); }
+	STDMETHOD(GetSamplerState)(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD* pValue) { return device->GetSamplerState(Sampler, Type, pValue); }
+	STDMETHOD(ValidateDevice)(DWORD* pNumPasses) { return device->ValidateDevice(pNumPasses); }
+	STDMETHOD(SetPaletteEntries)(UINT PaletteNumber, CONST PALETTEENTRY* pEntries) { return device->SetPaletteEntries(PaletteNumber, pEntries); }
+	STDMETHOD(GetPaletteEntries)(UINT PaletteNumber, PALETTEENTRY* pEntries) { return device->GetPaletteEntries(PaletteNumber, pEntries); }
+	STDMETHOD(SetCurrentTexturePalette)(UINT PaletteNumber) { return device->SetCurrentTexturePalette(PaletteNumber); }
+	STDMETHOD(GetCurrentTexturePalette)(UINT* PaletteNumber) { return device->GetCurrentTexturePalette(PaletteNumber); }
+	STDMETHOD(GetScissorRect)(RECT* pRect) { return device->GetScissorRect(pRect); }
+	STDMETHOD(SetSoftwareVertexProcessing)(BOOL bSoftware) { return device->SetSoftwareVertexProcessing(bSoftware); }
+	STDMETHOD_(BOOL, GetSoftwareVertexProcessing)() { return device->GetSoftwareVertexProcessing(); }
+	STDMETHOD(SetNPatchMode)(float nSegments) { return device->SetNPatchMode(nSegments); }
+	STDMETHOD_(float, GetNPatchMode)() { return device->GetNPatchMode(); }
+	STDMETHOD(ProcessVertices)(UINT SrcStartIndex, UINT DestIndex, UINT VertexCount, IDirect3DVertexBuffer9* pDestBuffer, IDirect3DVertexDeclaration9* pVertexDecl, DWORD Flags) { return device->ProcessVertices(SrcStartIndex, DestIndex, VertexCount, pDestBuffer, pVertexDecl, Flags); }
+	STDMETHOD(CreateVertexDeclaration)(CONST D3DVERTEXELEMENT9* pVertexElements, IDirect3DVertexDeclaration9** ppDecl) { return device->CreateVertexDeclaration(pVertexElements, ppDecl); }
+	STDMETHOD(GetVertexDeclaration)(IDirect3DVertexDeclaration9** ppDecl) { return device->GetVertexDeclaration(ppDecl); }
+	STDMETHOD(GetFVF)(DWORD* pFVF) { return device->GetFVF(pFVF); }
+	STDMETHOD(CreateVertexShader)(CONST DWORD* pFunction, IDirect3DVertexShader9** ppShader) { return device->CreateVertexShader(pFunction, ppShader); }
+	STDMETHOD(GetVertexShader)(IDirect3DVertexShader9** ppShader) { return device->GetVertexShader(ppShader); }
+	STDMETHOD(GetVertexShaderConstantF)(UINT StartRegister, float* pConstantData, UINT Vector4fCount) { return device->GetVertexShaderConstantF(StartRegister, pConstantData, Vector4fCount); }
+	STDMETHOD(GetVertexShaderConstantI)(UINT StartRegister, int* pConstantData, UINT Vector4iCount) { return device->GetVertexShaderConstantI(StartRegister, pConstantData, Vector4iCount); }
+	STDMETHOD(GetVertexShaderConstantB)(UINT StartRegister, BOOL* pConstantData, UINT BoolCount) { return device->GetVertexShaderConstantB(StartRegister, pConstantData, BoolCount); }
+	STDMETHOD(GetStreamSource)(UINT StreamNumber, IDirect3DVertexBuffer9** ppStreamData, UINT* pOffsetInBytes, UINT* pStride) { return device->GetStreamSource(StreamNumber, ppStreamData, pOffsetInBytes, pStride); }
+	STDMETHOD(GetStreamSourceFreq)(UINT StreamNumber, UINT* pSetting) { return device->GetStreamSourceFreq(StreamNumber, pSetting); }
+	STDMETHOD(GetIndices)(IDirect3DIndexBuffer9** ppIndexData) { return device->GetIndices(ppIndexData); }
+	STDMETHOD(CreatePixelShader)(CONST DWORD* pFunction, IDirect3DPixelShader9** ppShader) { return device->CreatePixelShader(pFunction, ppShader); }
+	STDMETHOD(GetPixelShader)(IDirect3DPixelShader9** ppShader) { return device->GetPixelShader(ppShader); }
+	STDMETHOD(GetPixelShaderConstantF)(UINT StartRegister, float* pConstantData, UINT Vector4fCount) { return device->GetPixelShaderConstantF(StartRegister, pConstantData, Vector4fCount); }
+	STDMETHOD(GetPixelShaderConstantI)(UINT StartRegister, int* pConstantData, UINT Vector4iCount) { return device->GetPixelShaderConstantI(StartRegister, pConstantData, Vector4iCount); }
+	STDMETHOD(GetPixelShaderConstantB)(UINT StartRegister, BOOL* pConstantData, UINT BoolCount) { return device->GetPixelShaderConstantB(StartRegister, pConstantData, BoolCount); }
+	STDMETHOD(DeletePatch)(UINT Handle) { return device->DeletePatch(Handle); }
+	STDMETHOD(CreateQuery)(D3DQUERYTYPE Type, IDirect3DQuery9** ppQuery) { return device->CreateQuery(Type, ppQuery); }
+protected:
+	~CountingDevice() {} // Use Release()
+	IDirect3DDevice9* device; // The real device
+	volatile LONG references; // COM reference count of the CountingDevice itself
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,170 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "loader.h"
+#include "mesh.h"
+
+Mutex Loader::mutex;
+Semaphore Loader::queued;
+std::list<LoadJob*> Loader::jobs;
+std::list<LoadJob*> Loader::waiting;
+std::list<LoadJob*> Loader::done;
+Thread Loader::threads[MAX_LOADER_THREADS];
+int Loader::numThreads = 0;
+bool Loader::stopping = false;
+bool Loader::deferred = false;
+
+// Starts loading the file into the mesh; starts the loader threads the first time
+void Loader::Queue(Mesh* mesh, LPCSTR file) {
+	if(numThreads == 0) {
+		// Leave a processor for the render thread
+		int count = Max(1, Min(Thread::GetNumProcessors() - 1, MAX_LOADER_THREADS));
+		stopping = false;
+		for(int i = 0; i < count; i++) {
+			if(threads[i].Start(Work, 0))
+				numThreads++;
+		}
+		if(numThreads == 0) {
+			vvd::Log("Vivid: Failed to start the loader threads");
+			exit(1);
+		}
+	}
+
+	LoadJob* job = new LoadJob;
+	job->mesh = mesh;
+	job->file = file;
+	job->data = new MeshFileData;
+	{
+		ScopedLock lock(&mutex);
+		jobs.push_back(job);
+		waiting.push_back(job);
+	}
+	queued.Signal();
+
+	std::string msg = "Vivid: Queued X file: ";
+	msg += file;
+	vvd::Log(msg.c_str());
+}
+// Drops the mesh's load; called when a pending mesh is deleted
+void Loader::Cancel(Mesh* mesh) {
+	ScopedLock lock(&mutex);
+	std::list<LoadJob*>::iterator i = jobs.begin();
+	while(i != jobs.end()) {
+		if((*i)->mesh == mesh)
+			(*i)->mesh = 0; // The job is deleted once it reaches Update()
+		i++;
+	}
+}
+// Finishes loads the loader threads are done with; called every frame by vvd::Update()
+void Loader::Update() {
+	for(int i = 0; i < MAX_LOADS_PER_FRAME; i++) {
+		LoadJob* job;
+		{
+			ScopedLock lock(&mutex);
+			// Skip cancelled jobs without counting them against the frame
+			while(!done.empty() && done.front()->mesh == 0) {
+				job = done.front();
+				done.pop_front();
+				jobs.remove(job);
+				delete job->data;
+				delete job;
+			}
+			if(done.empty())
+				return;
+			job = done.front();
+			done.pop_front();
+		}
+
+		// Meshes are only deleted on the render thread, so the mesh can't go away while it's finished
+		job->mesh->CreateFromFiles(job->data);
+		{
+			ScopedLock lock(&mutex);
+			jobs.remove(job);
+		}
+		delete job->data;
+		delete job;
+	}
+}
+// Waits for every queued load and finishes it; for loading screens
+void Loader::Flush() {
+	while(GetNumPending() > 0) {
+		Update();
+		Sleep(1);
+	}
+}
+// Gets the number of loads that haven't finished
+int Loader::GetNumPending() {
+	ScopedLock lock(&mutex);
+	return (int)jobs.size();
+}
+// Returns true if a load is waiting for Update()
+bool Loader::IsReady() {
+	ScopedLock lock(&mutex);
+	return !done.empty();
+}
+// Makes vvd::Update() leave the loads alone
+void Loader::SetDeferred(bool nDeferred) {
+	deferred = nDeferred;
+}
+// Returns true if vvd::Update() leaves the loads alone
+bool Loader::IsDeferred() {
+	return deferred;
+}
+// Stops the loader threads; unfinished loads are dropped
+void Loader::Shutdown() {
+	if(numThreads == 0)
+		return;
+	{
+		ScopedLock lock(&mutex);
+		stopping = true;
+	}
+	queued.Signal(numThreads);
+	for(int i = 0; i < numThreads; i++)
+		threads[i].Join();
+	numThreads = 0;
+
+	std::list<LoadJob*>::iterator i = jobs.begin();
+	while(i != jobs.end()) {
+		delete (*i)->data;
+		delete *i;
+		i++;
+	}
+	jobs.clear();
+	waiting.clear();
+	done.clear();
+}
+// Loader thread body
+void Loader::Work(void* data) {
+	while(true) {
+		queued.Wait();
+		LoadJob* job;
+		bool cancelled;
+		{
+			ScopedLock lock(&mutex);
+			if(stopping)
+				return;
+			job = waiting.front();
+			waiting.pop_front();
+			cancelled = job->mesh == 0;
+		}
+
+		// The device isn't touched here, so nothing else needs locking
+		if(!cancelled)
+			Mesh::ReadFiles(job->file.c_str(), job->data);
+
+		ScopedLock lock(&mutex);
+		done.push_back(job);
+	}
+}
\ No newline at end of file
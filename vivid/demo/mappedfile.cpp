@@ -0,0 +1,113 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "mappedfile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+	data = 0;
+	size = 0;
+	open = false;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = 0;
+#endif
+}
+MappedFile::~MappedFile() {
+	Close();
+}
+// Maps the file specified; returns false if it can't be opened
+bool MappedFile::Open(const char* nFile) {
+	Close();
+#ifdef _WIN32
+	file = CreateFile(nFile, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if(file == INVALID_HANDLE_VALUE)
+		return false;
+	size = GetFileSize(file, 0);
+	if(size > 0) {
+		// Empty files can't be mapped
+		mapping = CreateFileMapping(file, 0, PAGE_READONLY, 0, 0, 0);
+		if(mapping)
+			data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if(!data) {
+			Close();
+			return false;
+		}
+	}
+#else
+	int fd = ::open(nFile, O_RDONLY);
+	if(fd < 0)
+		return false;
+	struct stat info;
+	if(fstat(fd, &info) != 0) {
+		::close(fd);
+		return false;
+	}
+	size = (size_t)info.st_size;
+	if(size > 0) {
+		void* view = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(view == MAP_FAILED) {
+			::close(fd);
+			size = 0;
+			return false;
+		}
+		data = (const char*)view;
+	}
+	::close(fd); // The mapping stays valid after the file is closed
+#endif
+	if(!data)
+		data = "";
+	open = true;
+	return true;
+}
+// Unmaps the file
+void MappedFile::Close() {
+#ifdef _WIN32
+	if(open && size > 0)
+		UnmapViewOfFile(data);
+	if(mapping)
+		CloseHandle(mapping);
+	if(file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	mapping = 0;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if(open && size > 0)
+		munmap((void*)data, size);
+#endif
+	data = 0;
+	size = 0;
+	open = false;
+}
+// Returns true if a file is mapped
+bool MappedFile::IsOpen() {
+	return open;
+}
+// Gets the contents of the file; not null terminated
+const char* MappedFile::GetData() {
+	return data;
+}
+// Gets the size of the file in bytes
+size_t MappedFile::GetSize() {
+	return size;
+}
\ No newline at end of file
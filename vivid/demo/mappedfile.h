@@ -0,0 +1,43 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef mappedfile_h
+#define mappedfile_h
+#include <stddef.h>
+
+// Read only view of a whole file; the operating system maps it into memory, so reading it doesn't copy anything
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+	bool Open(const char* file); // Maps the file specified; returns false if it can't be opened
+	void Close(); // Unmaps the file
+	bool IsOpen(); // Returns true if a file is mapped
+	const char* GetData(); // Gets the contents of the file; not null terminated
+	size_t GetSize(); // Gets the size of the file in bytes
+protected:
+	const char* data; // Start of the mapped view
+	size_t size; // Size of the file
+	bool open; // True if a file is mapped
+#ifdef _WIN32
+	void* file; // File handle
+	void* mapping; // File mapping handle
+#endif
+private:
+	MappedFile(const MappedFile&); // Views can't be shared
+	MappedFile& operator=(const MappedFile&);
+};
+
+#endif
\ No newline at end of file
@@ -1,59 +1,118 @@
-// Vivid Engine v0.01
-// Copyright (C) 2006 Evan Todd
-
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// version 2 as published by the Free Software Foundation.
-
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-// GNU General Public License (included in README.txt) for more details.
-
-// You can contact the author at evanofsky@sbcglobal.net.
-
-#ifndef mesh_h
-#define mesh_h
-#include "vivid.h"
-#include "transform.h"
-#include "material.h"
-#include "world.h"
-
-struct Cell;
-
-class Mesh {
-public:
-	static std::list<Mesh*> meshes; // Static list of meshes; used for caching and rendering
-	Mesh(LPCSTR file); // Loads the x file specified
-	Mesh();
-	Mesh(const Mesh& vMesh);
-	~Mesh();
-	void LoadMesh(LPCSTR xfile); // Loads the x file specified
-	void DrawSubset(DWORD index); // Draws the specified subset of the mesh
-	DWORD GetNumFaces(); // Returns the number of faces (triangles) in the mesh
-	DWORD GetNumVertices(); // Returns the number of vertices (points) in the mesh
-	DWORD GetFVF(); // Returns the Flexible Vertex Format of the mesh
-	int GetNumSubsets(); // Returns the number of subsets (materials) in the mesh
-	Transform transform; // World transform
-	std::vector<Material>* GetMaterials(); // Gets the list of materials in this mesh
-	std::vector<Cell*>* GetCells(); // Gets the list of cells this mesh is inside
-	D3DXVECTOR3 GetCenter(); // Gets the center of the mesh
-	float GetRadius(); // Gets the distance from the center to the outermost vertex of the mesh
-	bool IsAlpha(); // Returns true if this mesh has alpha information
-	bool IsTranslucent(); // Returns true if this mesh needs access to the back buffer
-	void AddCell(Cell* cell); // Adds a cell to the list of cells this mesh is inside
-	void ClearCells(); // Clears the list of cells this mesh is inside
-protected:
-	ID3DXMesh* d3dmesh; // Actual mesh data
-	LPCSTR filename; // Mesh file name; used for caching
-	DWORD numSubsets; // Number of subsets (materials) in the mesh
-	std::vector<Material> materials; // List of materials; loaded from X file
-	std::vector<Cell*> cells; // List of cells this mesh is inside
-	D3DXVECTOR3 center; // The center of the mesh
-	float radius; // The distance from the center to the outermost vertex of the mesh
-	bool alpha; // True if this mesh has alpha information
-	bool translucent; // True if this mesh needs access to the back buffer
-	void SetTo(Mesh* mesh);
-};
-
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#ifndef mesh_h
+#define mesh_h
+#include "vivid.h"
+#include "transform.h"
+#include "scene.h"
+#include "material.h"
+#include "world.h"
+#include "xfile.h"
+#include "resource.h"
+
+struct Cell;
+class Light;
+
+#define COOKED_MESH_EXTENSION ".vmc" // Appended to the X file name to get the cooked mesh file name
+#define COOKED_MESH_MAGIC 0x48534D56 // "VMSH"
+#define COOKED_MESH_VERSION 1 // Bump whenever the layout or the import steps change
+
+// Start of a cooked mesh file; followed by the vertices, the indices, the attribute id of every face,
+// the attribute table, and the material file name of every subset (null terminated, empty for none)
+struct CookedMeshHeader {
+	DWORD magic; // COOKED_MESH_MAGIC
+	DWORD version; // COOKED_MESH_VERSION
+	FILETIME sourceTime; // Last write time of the X file it was cooked from
+	DWORD sourceSize; // Size of the X file it was cooked from
+	DWORD options; // Mesh creation options; only D3DXMESH_32BIT is kept
+	DWORD numVertices;
+	DWORD numFaces;
+	DWORD vertexSize; // Bytes per vertex
+	DWORD numAttributes; // Entries in the attribute table
+	DWORD numSubsets;
+	D3DVERTEXELEMENT9 decl[MAX_FVF_DECL_SIZE]; // Vertex declaration, tangents included
+	D3DXVECTOR3 center; // Bounding sphere
+	float radius;
+};
+
+// Everything read from a mesh's files before the device is needed; filled in by Mesh::ReadFiles()
+struct MeshFileData {
+	std::vector<BYTE> cooked; // The cooked mesh file; empty if it's missing or out of date
+	XMeshData xdata; // The parsed X file; only read if there's no usable cooked file
+	bool parsed; // True if xdata holds the X file
+	std::string error; // Why the X file couldn't be parsed
+};
+
+// A mesh loaded from an X file, with its materials; the transform, bounding sphere, cells and lights
+// are kept by SceneMesh, so the World and the light ranking don't need Direct3D
+class Mesh : public SceneMesh {
+public:
+	static std::list<Mesh*> occluders; // Meshes marked with SetOccluder(); drawn into the Renderer's occlusion buffer
+	Mesh(LPCSTR file); // Loads the x file specified
+	// Loads the x file specified; if async is true the Loader reads it in the background, and the
+	// mesh isn't rendered or put in cells until IsLoaded() returns true
+	Mesh(LPCSTR file, bool async);
+	Mesh();
+	Mesh(const Mesh& vMesh);
+	~Mesh();
+	void LoadMesh(LPCSTR xfile); // Loads the x file specified
+	bool IsLoaded(); // Returns false until a mesh loaded in the background is ready
+	// Reads the cooked mesh if it's current, otherwise parses the X file; doesn't touch the device, so it's thread safe
+	static void ReadFiles(LPCSTR xfile, MeshFileData* data);
+	void CreateFromFiles(MeshFileData* data); // Creates the mesh and its materials from the data ReadFiles() read; render thread only
+	void DrawSubset(DWORD index); // Draws the specified subset of the mesh
+	// Draws the specified subset once for each world matrix in the instance buffer
+	// The effect must be using a technique that reads the matrix from TEXCOORD4-7
+	void DrawSubsetInstanced(DWORD index, IDirect3DVertexBuffer9* instances, UINT numInstances);
+	ID3DXMesh* GetD3DMesh(); // Gets the mesh data; shared by every mesh loaded from the same file
+	DWORD GetNumFaces(); // Returns the number of faces (triangles) in the mesh
+	DWORD GetNumVertices(); // Returns the number of vertices (points) in the mesh
+	DWORD GetFVF(); // Returns the Flexible Vertex Format of the mesh
+	int GetNumSubsets(); // Returns the number of subsets (materials) in the mesh
+	std::vector<Material>* GetMaterials(); // Gets the list of materials in this mesh
+	bool IsAlpha(); // Returns true if this mesh has alpha information
+	bool IsTranslucent(); // Returns true if this mesh needs access to the back buffer
+	// Marks the mesh as an occluder; the Renderer skips meshes hidden behind occluders. Off by default;
+	// meant for a few big, closed meshes like buildings and terrain
+	void SetOccluder(bool nOccluder);
+	bool IsOccluder(); // Returns true if the mesh is an occluder
+protected:
+	ID3DXMesh* d3dmesh; // Actual mesh data
+	IDirect3DVertexDeclaration9* instanceDecl; // Mesh vertex declaration plus the per-instance world matrix stream
+	std::vector<D3DXATTRIBUTERANGE> attributes; // Vertex and face ranges of each subset; for instanced drawing
+	LPCSTR filename; // Interned mesh file name; owned by the ResourceCache
+	Resource* resource; // Cache entry the mesh data belongs to; 0 if it wasn't loaded from a file
+	DWORD numSubsets; // Number of subsets (materials) in the mesh
+	std::vector<Material> materials; // List of materials; loaded from X file
+	bool alpha; // True if this mesh has alpha information
+	bool translucent; // True if this mesh needs access to the back buffer
+	bool occluder; // True if the mesh is in the occluders list
+	bool loading; // True while the Loader is loading the mesh in the background
+	void SetTo(Mesh* mesh);
+	void SetResource(Resource* nResource); // Switches the mesh to another cache entry
+	// Reads a file written by SaveCooked(); returns false if the file is missing, was cooked by another
+	// version, is older than the X file, or is truncated
+	static bool ReadCooked(LPCSTR cookedFile, LPCSTR xfile, std::vector<BYTE>* data);
+	bool CreateFromCooked(std::vector<BYTE>* cooked, std::vector<std::string>* materialFiles); // Creates the mesh from a cooked mesh file
+	void SaveCooked(LPCSTR cookedFile, LPCSTR xfile, std::vector<std::string>* materialFiles); // Writes the loaded mesh to a cooked mesh file
+	// Loads, welds and optimizes the X file and computes its tangents and bounding sphere
+	// Uses the data our own parser read, or D3DX if xdata is 0
+	void ImportX(LPCSTR xfile, XMeshData* xdata, std::vector<std::string>* materialFiles);
+	// Builds the mesh from the data our own X file parser read
+	void CreateFromXData(LPCSTR xfile, XMeshData* data, std::vector<DWORD>* adjacency, std::vector<std::string>* materialFiles);
+	void FinishLoading(LPCSTR xfile, std::vector<std::string>* materialFiles); // Builds the attribute table, instancing declaration and materials
+};
+
 #endif
\ No newline at end of file
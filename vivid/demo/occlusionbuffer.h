@@ -0,0 +1,43 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef occlusionbuffer_h
+#define occlusionbuffer_h
+#include "rasterizer.h"
+
+#define OCCLUSION_BUFFER_WIDTH 256 // Width of the occlusion depth buffer in pixels; the height follows the viewport
+
+// Low resolution depth buffer of the big meshes that hide the rest of the scene. The occluders are
+// rasterized on the CPU at the start of a frame, then each mesh's screen rectangle is tested against
+// them before it's drawn
+class OcclusionBuffer {
+public:
+	OcclusionBuffer(int nWidth, int nHeight);
+	void Begin(const Matrix* nViewProj); // Clears the buffer and sets the view projection matrix for the frame
+	// Rasterizes an occluder; positions are read every stride bytes, and indices are 32 bit if indices32 is true
+	void DrawOccluder(const Matrix* world, const void* positions, int stride, int numVertices,
+		const void* indices, bool indices32, int numTriangles);
+	void End(); // Finishes rasterizing the occluders; call before IsOccluded()
+	// Returns true if the occluders hide the whole bounding sphere; spheres crossing the near plane are never hidden
+	bool IsOccluded(const Vector3* center, float radius);
+	int GetWidth(); // Gets the width of the buffer in pixels
+	int GetHeight(); // Gets the height of the buffer in pixels
+	int GetNumTriangles(); // Gets the number of occluder triangles rasterized by the last End()
+protected:
+	Rasterizer rasterizer; // Depth only, on the calling thread
+	Matrix viewProj; // View projection matrix of the frame
+};
+
+#endif
\ No newline at end of file
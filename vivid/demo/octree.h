@@ -0,0 +1,67 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef octree_h
+#define octree_h
+#include "vmath.h"
+#include "cell.h"
+#include "spatialindex.h"
+
+// A node of the octree; children are only created once something is inside them
+struct OctreeNode {
+	Vector3 boxMin; // Bounding box of the node; nodes along the edge of the tree reach out forever
+	Vector3 boxMax;
+	Vector3 center; // Split point of the node
+	float halfSize; // Half the size of the node along each axis, ignoring the edge
+	OctreeNode* children[8]; // Child nodes; bit 0 of the index is +X, bit 1 is +Y, bit 2 is +Z
+	Cell* cell; // The cell; only leaf nodes have one
+};
+
+// Divides a cube centered on the origin into eight children, down to leaves of about the specified size
+// Nodes and cells are only created where meshes and lights are, so big, mostly empty worlds cost little,
+// and the queries skip whole empty branches
+class Octree : public SpatialIndex {
+public:
+	Octree(float nWorldSize, float nCellSize); // The leaf cells are the first power of two division no bigger than nCellSize
+	~Octree();
+	void GetCells(Vector3 center, float radius, std::vector<Cell*>* cells); // Gets every cell overlapped by the bounding box of the sphere
+	Cell* GetCell(Vector3 pos); // Gets the cell at the position specified
+	void GetAllCells(std::vector<Cell*>* cells); // Gets every cell that exists
+	int GetNumCells(); // Gets the number of cells created so far
+	void QuerySphere(Vector3 center, float radius, std::vector<Cell*>* cells); // Gets the cells touching the sphere
+	void QueryFrustum(Frustum* frustum, std::vector<Cell*>* cells); // Gets the cells at least partially inside the frustum
+	// Gets the cells the ray passes through before it has traveled the specified length
+	void QueryRay(Vector3 origin, Vector3 direction, float length, std::vector<Cell*>* cells);
+	int GetDepth(); // Gets the number of levels below the root
+	int GetNumNodes(); // Gets the number of nodes created so far
+protected:
+	OctreeNode* CreateNode(OctreeNode* parent, int index); // Creates the specified child of the node
+	void DeleteNode(OctreeNode* node); // Deletes the node, its children, and its cell
+	// Adds the leaf cells under the node that overlap the box to the list; creates missing nodes
+	void Insert(OctreeNode* node, int level, Vector3* boxMin, Vector3* boxMax, std::vector<Cell*>* cells);
+	void CollectCells(OctreeNode* node, std::vector<Cell*>* cells); // Adds every cell under the node to the list
+	void QuerySphere(OctreeNode* node, Vector3* center, float radius, std::vector<Cell*>* cells);
+	void QueryFrustum(OctreeNode* node, Frustum* frustum, std::vector<Cell*>* cells);
+	void QueryRay(OctreeNode* node, Vector3* origin, Vector3* direction, float length, std::vector<Cell*>* cells);
+	float worldSize; // Size of the root cube along each axis
+	int depth; // Number of levels below the root
+	int numNodes; // Number of nodes created so far
+	int numCells; // Number of leaf cells created so far
+	OctreeNode* root; // The root node
+private:
+	Octree(const Octree& octree); // Not copyable; the octree owns its nodes
+};
+
+#endif
\ No newline at end of file
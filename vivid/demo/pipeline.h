@@ -0,0 +1,76 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef pipeline_h
+#define pipeline_h
+#include "snapshot.h"
+#include "thread.h"
+
+#define MAX_FRAMES_IN_FLIGHT 3 // Most frames the game thread can run ahead of the screen
+#define SNAPSHOT_QUEUE_SIZE 4 // Slots in a SnapshotQueue; at least MAX_FRAMES_IN_FLIGHT
+
+typedef void (*RenderFunction)(FrameSnapshot* snapshot, void* data); // Draws a snapshot on the render thread
+
+// Ring of snapshots passed from one thread to another without locking. Only one thread may push and only one
+// other thread may pop; each index is only written by its own side, and the other side just reads it
+class SnapshotQueue {
+public:
+	SnapshotQueue();
+	bool Push(FrameSnapshot* snapshot); // Adds a snapshot; returns false if the queue is full
+	FrameSnapshot* Pop(); // Takes the oldest snapshot; returns 0 if the queue is empty
+protected:
+	FrameSnapshot* snapshots[SNAPSHOT_QUEUE_SIZE];
+	volatile long head; // Snapshots popped so far; only the consumer changes it
+	volatile long tail; // Snapshots pushed so far; only the producer changes it
+};
+
+// Draws on a render thread while the game thread simulates the next frame. The game thread writes frame N+1
+// while the render thread draws an immutable snapshot of frame N, so the two overlap instead of taking turns.
+// Snapshots travel to the render thread and back through two SnapshotQueues; the game thread only waits when
+// it's maxFramesInFlight frames ahead. Input takes that many more frames to reach the screen, which the frame
+// statistics measure. Create the device after vvd::SetMultithreadedDevice(true), and call Flush() before
+// deleting meshes or lights, since the render thread may still be drawing them. Meshes loaded in the
+// background are finished by Submit() instead of vvd::Update()
+class RenderPipeline {
+public:
+	// Starts the render thread, which calls function(snapshot, data) for every frame. maxFramesInFlight is at most
+	// MAX_FRAMES_IN_FLIGHT; 1 is double buffering: the live scene is simulated while its last snapshot is drawn
+	RenderPipeline(int nMaxFramesInFlight, RenderFunction nFunction, void* nData);
+	~RenderPipeline(); // Draws the frames in flight and stops the render thread
+	// Captures the scene into a free snapshot and hands it to the render thread; call it once the frame has been
+	// simulated. Waits if maxFramesInFlight frames are already waiting to be drawn. Adds the statistics of the
+	// frame the snapshot was last drawn for to the current frame's
+	void Submit(D3DXVECTOR3* cameraPos, D3DXVECTOR3* cameraLook, D3DXVECTOR3* cameraUp);
+	void Flush(); // Waits until the render thread has drawn every frame handed to it
+	int GetMaxFramesInFlight(); // Gets the number of frames the game thread can run ahead of the screen
+protected:
+	static void Run(void* pipeline); // Render thread body
+	bool DrawNext(); // Draws the oldest ready snapshot and hands it back; returns false if there wasn't one
+	FrameSnapshot snapshots[MAX_FRAMES_IN_FLIGHT]; // maxFramesInFlight of them are used
+	SnapshotQueue ready; // Captured snapshots waiting to be drawn; pushed by the game thread
+	SnapshotQueue done; // Drawn snapshots; pushed by the render thread
+	Semaphore readyCount; // Signaled for every snapshot pushed into ready, and once to stop
+	Semaphore doneCount; // Signaled for every snapshot pushed into done
+	Thread thread; // The render thread
+	RenderFunction function; // Draws a snapshot
+	void* data; // Passed to the function
+	int maxFramesInFlight; // Most snapshots handed to the render thread and not handed back yet
+	volatile long frame; // Frames submitted so far; read by the render thread to measure the latency
+private:
+	RenderPipeline(const RenderPipeline&);
+	RenderPipeline& operator=(const RenderPipeline&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,510 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "rasterizer.h"
+#include <stdio.h>
+#ifdef RASTER_SSE
+#include <xmmintrin.h>
+#endif
+
+Rasterizer::Rasterizer(int nWidth, int nHeight, int nNumThreads) {
+	width = nWidth;
+	height = nHeight;
+	pitch = (width + 3) & ~3;
+	tilesX = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	tilesY = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	colorBuffer.resize(pitch * height, 0);
+	depthBuffer.resize(pitch * height, 1.0f);
+	bins.resize(tilesX * tilesY);
+	viewProj = Matrix::Identity();
+	cullBackFaces = true;
+	depthOnly = false;
+	numLights = 0;
+	ambient = Vector3(0.0f, 0.0f, 0.0f);
+	numTriangles = 0;
+	nextTile = 0;
+	stopping = false;
+
+	if(nNumThreads <= 0)
+		nNumThreads = Thread::GetNumProcessors();
+	numThreads = 1;
+	for(int i = 0; i < Min(nNumThreads, MAX_RASTER_THREADS) - 1; i++) {
+		if(threads[i].Start(Work, this))
+			numThreads++;
+	}
+}
+Rasterizer::~Rasterizer() {
+	stopping = true;
+	if(numThreads > 1)
+		start.Signal(numThreads - 1);
+	for(int i = 0; i < numThreads - 1; i++)
+		threads[i].Join();
+}
+// Sets the view projection matrix used by DrawTriangles()
+void Rasterizer::SetViewProjection(const Matrix* nViewProj) {
+	viewProj = *nViewProj;
+}
+// Skips counterclockwise triangles, like D3DCULL_CCW; on by default
+void Rasterizer::SetCullBackFaces(bool nCullBackFaces) {
+	cullBackFaces = nCullBackFaces;
+}
+// Only writes the depth buffer; skips lighting and colors
+void Rasterizer::SetDepthOnly(bool nDepthOnly) {
+	depthOnly = nDepthOnly;
+}
+// Sets the lights used by DrawTriangles()
+void Rasterizer::SetLights(int nNumLights, const Vector4* positions, const Vector4* colors, const float* ranges, const Vector3* nAmbient) {
+	numLights = Min(nNumLights, MAX_RASTER_LIGHTS);
+	for(int i = 0; i < numLights; i++) {
+		lightPositions[i] = positions[i];
+		lightColors[i] = colors[i].XYZ();
+		lightRanges[i] = ranges[i];
+	}
+	ambient = *nAmbient;
+}
+// Sets the lights from a ranked light list
+void Rasterizer::SetLights(std::vector<SceneLight*>* lights, const Vector3* nAmbient) {
+	numLights = Min((int)lights->size(), MAX_RASTER_LIGHTS);
+	for(int i = 0; i < numLights; i++) {
+		SceneLight* light = (*lights)[i];
+		lightPositions[i] = light->GetPosition();
+		lightColors[i] = light->GetColor();
+		lightRanges[i] = light->GetRange();
+	}
+	ambient = *nAmbient;
+}
+// Clears the color buffer to an A8R8G8B8 color and the depth buffer to 1
+void Rasterizer::Clear(unsigned int color) {
+	std::fill(colorBuffer.begin(), colorBuffer.end(), color);
+	std::fill(depthBuffer.begin(), depthBuffer.end(), 1.0f);
+}
+// Transforms, lights and bins triangles
+void Rasterizer::DrawTriangles(const Matrix* world, const Vector4* diffuse, const void* positions, const void* normals, int stride,
+	int numVertices, const void* indices, bool indices32, int nNumTriangles) {
+	Matrix worldViewProj = *world * viewProj;
+	Vector3 color = diffuse->XYZ();
+
+	// Transform and light every vertex once
+	vertices.resize(numVertices);
+	for(int i = 0; i < numVertices; i++) {
+		Vector3 position = *(const Vector3*)((const char*)positions + i * stride);
+		vertices[i].position = worldViewProj.Transform(position);
+		if(depthOnly)
+			continue;
+		Vector3 lighting;
+		if(normals) {
+			Vector3 normal = world->TransformNormal(*(const Vector3*)((const char*)normals + i * stride)).Normalized();
+			lighting = Light(world->TransformCoord(position), &normal);
+		} else {
+			lighting = Light(world->TransformCoord(position), 0);
+		}
+		vertices[i].color = Vector3(color.x * lighting.x, color.y * lighting.y, color.z * lighting.z);
+	}
+
+	for(int i = 0; i < nNumTriangles; i++) {
+		unsigned int a, b, c;
+		if(indices32) {
+			const unsigned int* triangle = (const unsigned int*)indices + i * 3;
+			a = triangle[0]; b = triangle[1]; c = triangle[2];
+		} else {
+			const unsigned short* triangle = (const unsigned short*)indices + i * 3;
+			a = triangle[0]; b = triangle[1]; c = triangle[2];
+		}
+		if(a >= (unsigned int)numVertices || b >= (unsigned int)numVertices || c >= (unsigned int)numVertices)
+			continue;
+		ClipTriangle(&vertices[a], &vertices[b], &vertices[c]);
+	}
+}
+// Draws a parsed X file at the transform's world matrix, each material's triangles in its diffuse color
+void Rasterizer::DrawMesh(const XMeshData* mesh, Transform* transform) {
+	if(mesh->positions.empty() || mesh->indices.empty())
+		return;
+	Matrix world = transform->GetMatrix();
+	const void* normals = mesh->normals.size() == mesh->positions.size() ? &mesh->normals[0] : 0;
+	int numVertices = (int)mesh->positions.size();
+	int numFaces = (int)mesh->indices.size() / 3;
+
+	if(mesh->materials.empty() || (int)mesh->attributes.size() != numFaces) {
+		Vector4 white(1.0f, 1.0f, 1.0f, 1.0f);
+		DrawTriangles(&world, &white, &mesh->positions[0], normals, sizeof(Vector3), numVertices, &mesh->indices[0], true, numFaces);
+		return;
+	}
+	for(int i = 0; i < (int)mesh->materials.size(); i++) {
+		materialIndices.clear();
+		for(int j = 0; j < numFaces; j++) {
+			if(mesh->attributes[j] == (unsigned int)i)
+				materialIndices.insert(materialIndices.end(), &mesh->indices[j * 3], &mesh->indices[j * 3] + 3);
+		}
+		if(!materialIndices.empty()) {
+			DrawTriangles(&world, &mesh->materials[i].diffuse, &mesh->positions[0], normals, sizeof(Vector3), numVertices,
+				&materialIndices[0], true, (int)materialIndices.size() / 3);
+		}
+	}
+}
+// Lights a vertex; the same falloff as the effects, plus the ambient color
+Vector3 Rasterizer::Light(const Vector3& position, const Vector3* normal) {
+	Vector3 total = ambient;
+	for(int i = 0; i < numLights; i++) {
+		Vector3 toLight;
+		float attenuation = 1.0f;
+		if(lightPositions[i].w == 0.0f) {
+			toLight = lightPositions[i].XYZ().Normalized();
+		} else {
+			toLight = lightPositions[i].XYZ() - position;
+			float distance = toLight.Length();
+			attenuation = 1.0f - (distance / lightRanges[i]);
+			if(attenuation <= 0.0f || distance == 0.0f)
+				continue;
+			toLight = toLight / distance;
+		}
+		float lambert = normal ? normal->Dot(toLight) : 1.0f;
+		if(lambert > 0.0f)
+			total += lightColors[i] * (lambert * attenuation);
+	}
+	return total;
+}
+// Clips the triangle against the near plane and sets up what's left
+void Rasterizer::ClipTriangle(const RasterVertex* a, const RasterVertex* b, const RasterVertex* c) {
+	const RasterVertex* in[3] = {a, b, c};
+
+	// Skip triangles entirely outside one of the other planes
+	int outside[5] = {0, 0, 0, 0, 0};
+	int numInside = 0;
+	for(int i = 0; i < 3; i++) {
+		const Vector4& p = in[i]->position;
+		outside[0] += p.x < -p.w;
+		outside[1] += p.x > p.w;
+		outside[2] += p.y < -p.w;
+		outside[3] += p.y > p.w;
+		outside[4] += p.z > p.w;
+		numInside += p.z >= 0.0f;
+	}
+	for(int i = 0; i < 5; i++) {
+		if(outside[i] == 3)
+			return;
+	}
+	if(numInside == 0)
+		return;
+	if(numInside == 3) {
+		SetupTriangle(a, b, c);
+		return;
+	}
+
+	// Cut off the part behind the near plane; one vertex in front leaves a triangle, two leave a quad
+	RasterVertex clipped[4];
+	int count = 0;
+	for(int i = 0; i < 3; i++) {
+		const RasterVertex* from = in[i];
+		const RasterVertex* to = in[(i + 1) % 3];
+		bool fromInside = from->position.z >= 0.0f;
+		if(fromInside)
+			clipped[count++] = *from;
+		if(fromInside != (to->position.z >= 0.0f)) {
+			float t = from->position.z / (from->position.z - to->position.z);
+			clipped[count].position = from->position + (to->position - from->position) * t;
+			clipped[count].color = Vector3::Lerp(from->color, to->color, t);
+			count++;
+		}
+	}
+	for(int i = 2; i < count; i++)
+		SetupTriangle(&clipped[0], &clipped[i - 1], &clipped[i]);
+}
+// Sets up the triangle's edge functions and attribute planes and adds it to the bins of the tiles it touches
+void Rasterizer::SetupTriangle(const RasterVertex* a, const RasterVertex* b, const RasterVertex* c) {
+	const RasterVertex* v[3] = {a, b, c};
+	float x[3], y[3], z[3], invW[3];
+	for(int i = 0; i < 3; i++) {
+		invW[i] = 1.0f / v[i]->position.w;
+		x[i] = (v[i]->position.x * invW[i] * 0.5f + 0.5f) * (float)width;
+		y[i] = (0.5f - v[i]->position.y * invW[i] * 0.5f) * (float)height;
+		z[i] = v[i]->position.z * invW[i];
+	}
+
+	// Clockwise on the screen is positive, since y points down
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if(area == 0.0f)
+		return;
+	int order[3] = {0, 1, 2};
+	if(area < 0.0f) {
+		if(cullBackFaces)
+			return;
+		order[1] = 2;
+		order[2] = 1;
+		area = -area;
+	}
+
+	RasterTriangle triangle;
+	float minX = (float)width, minY = (float)height, maxX = 0.0f, maxY = 0.0f;
+	for(int i = 0; i < 3; i++) {
+		minX = Min(minX, x[i]);
+		minY = Min(minY, y[i]);
+		maxX = Max(maxX, x[i]);
+		maxY = Max(maxY, y[i]);
+	}
+	triangle.minX = Max((int)floorf(minX), 0);
+	triangle.minY = Max((int)floorf(minY), 0);
+	triangle.maxX = Min((int)ceilf(maxX), width - 1);
+	triangle.maxY = Min((int)ceilf(maxY), height - 1);
+	if(triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		return;
+
+	// Edge i runs between the two vertices other than i
+	for(int i = 0; i < 3; i++) {
+		int from = order[(i + 1) % 3];
+		int to = order[(i + 2) % 3];
+		float* edge = triangle.edges[i];
+		edge[0] = y[from] - y[to];
+		edge[1] = x[to] - x[from];
+		edge[2] = x[from] * y[to] - x[to] * y[from];
+		triangle.topLeft[i] = edge[0] > 0.0f || (edge[0] == 0.0f && edge[1] > 0.0f);
+	}
+
+	// An attribute is the sum of its vertex values weighted by the normalized edge functions
+	float values[6][3];
+	for(int i = 0; i < 3; i++) {
+		int vertex = order[i];
+		values[0][i] = z[vertex];
+		values[1][i] = invW[vertex];
+		values[2][i] = v[vertex]->color.x * invW[vertex];
+		values[3][i] = v[vertex]->color.y * invW[vertex];
+		values[4][i] = v[vertex]->color.z * invW[vertex];
+	}
+	float* planes[5] = {triangle.depth, triangle.invW, triangle.red, triangle.green, triangle.blue};
+	float invArea = 1.0f / area;
+	for(int p = 0; p < 5; p++) {
+		for(int j = 0; j < 3; j++) {
+			planes[p][j] = (values[p][0] * triangle.edges[0][j] + values[p][1] * triangle.edges[1][j] +
+				values[p][2] * triangle.edges[2][j]) * invArea;
+		}
+	}
+
+	// Bin it in every tile it touches; tiles entirely outside an edge are skipped
+	int index = (int)triangles.size();
+	triangles.push_back(triangle);
+	for(int ty = triangle.minY / RASTER_TILE_SIZE; ty <= triangle.maxY / RASTER_TILE_SIZE; ty++) {
+		for(int tx = triangle.minX / RASTER_TILE_SIZE; tx <= triangle.maxX / RASTER_TILE_SIZE; tx++) {
+			float left = (float)(tx * RASTER_TILE_SIZE), top = (float)(ty * RASTER_TILE_SIZE);
+			float right = left + RASTER_TILE_SIZE, bottom = top + RASTER_TILE_SIZE;
+			bool touches = true;
+			for(int i = 0; i < 3 && touches; i++) {
+				const float* edge = triangle.edges[i];
+				// The corner of the tile furthest inside the edge
+				float cornerX = edge[0] > 0.0f ? right : left;
+				float cornerY = edge[1] > 0.0f ? bottom : top;
+				touches = edge[0] * cornerX + edge[1] * cornerY + edge[2] >= 0.0f;
+			}
+			if(touches)
+				bins[ty * tilesX + tx].push_back(index);
+		}
+	}
+}
+// Shades the triangles binned since the last flush
+void Rasterizer::Flush() {
+	numTriangles = (int)triangles.size();
+	nextTile = 0;
+	if(numThreads > 1)
+		start.Signal(numThreads - 1);
+	ShadeTiles();
+	for(int i = 0; i < numThreads - 1; i++)
+		finished.Wait();
+
+	triangles.clear();
+	for(int i = 0; i < (int)bins.size(); i++)
+		bins[i].clear();
+}
+// Helper thread body
+void Rasterizer::Work(void* nRasterizer) {
+	Rasterizer* rasterizer = (Rasterizer*)nRasterizer;
+	while(true) {
+		rasterizer->start.Wait();
+		if(rasterizer->stopping)
+			return;
+		rasterizer->ShadeTiles();
+		rasterizer->finished.Signal();
+	}
+}
+// Shades tiles until there are none left
+void Rasterizer::ShadeTiles() {
+	int numTiles = tilesX * tilesY;
+	while(true) {
+		int tile;
+		{
+			ScopedLock lock(&tileMutex);
+			tile = nextTile++;
+		}
+		if(tile >= numTiles)
+			return;
+		if(!bins[tile].empty())
+			ShadeTile(tile);
+	}
+}
+// Packs a color into an A8R8G8B8 pixel
+static inline unsigned int PackColor(float r, float g, float b) {
+	int red = (int)(Min(Max(r, 0.0f), 1.0f) * 255.0f + 0.5f);
+	int green = (int)(Min(Max(g, 0.0f), 1.0f) * 255.0f + 0.5f);
+	int blue = (int)(Min(Max(b, 0.0f), 1.0f) * 255.0f + 0.5f);
+	return 0xFF000000 | (red << 16) | (green << 8) | blue;
+}
+// Shades every triangle in the tile's bin, in the order they were drawn
+void Rasterizer::ShadeTile(int tile) {
+	int tileX = (tile % tilesX) * RASTER_TILE_SIZE;
+	int tileY = (tile / tilesX) * RASTER_TILE_SIZE;
+	int tileMaxX = Min(tileX + RASTER_TILE_SIZE, width) - 1;
+	int tileMaxY = Min(tileY + RASTER_TILE_SIZE, height) - 1;
+	std::vector<int>& bin = bins[tile];
+
+	for(int k = 0; k < (int)bin.size(); k++) {
+		const RasterTriangle& t = triangles[bin[k]];
+		int x0 = Max(t.minX, tileX), x1 = Min(t.maxX, tileMaxX);
+		int y0 = Max(t.minY, tileY), y1 = Min(t.maxY, tileMaxY);
+
+#ifdef RASTER_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 firstX = _mm_set1_ps((float)x0 + 0.5f);
+		const __m128 lastX = _mm_set1_ps((float)x1 + 0.5f);
+		__m128 edgeA[3], topLeft[3];
+		for(int i = 0; i < 3; i++) {
+			edgeA[i] = _mm_set1_ps(t.edges[i][0]);
+			topLeft[i] = t.topLeft[i] ? _mm_cmpeq_ps(zero, zero) : zero; // All ones without SSE2
+		}
+		const __m128 depthA = _mm_set1_ps(t.depth[0]), invWA = _mm_set1_ps(t.invW[0]);
+		const __m128 redA = _mm_set1_ps(t.red[0]), greenA = _mm_set1_ps(t.green[0]), blueA = _mm_set1_ps(t.blue[0]);
+		for(int y = y0; y <= y1; y++) {
+			float py = (float)y + 0.5f;
+			unsigned int* colorRow = &colorBuffer[y * pitch];
+			float* depthRow = &depthBuffer[y * pitch];
+			// The y terms are the same along the row
+			__m128 edgeRow[3];
+			for(int i = 0; i < 3; i++)
+				edgeRow[i] = _mm_set1_ps(t.edges[i][1] * py + t.edges[i][2]);
+			__m128 depthRow0 = _mm_set1_ps(t.depth[1] * py + t.depth[2]);
+			__m128 invWRow = _mm_set1_ps(t.invW[1] * py + t.invW[2]);
+			__m128 redRow = _mm_set1_ps(t.red[1] * py + t.red[2]);
+			__m128 greenRow = _mm_set1_ps(t.green[1] * py + t.green[2]);
+			__m128 blueRow = _mm_set1_ps(t.blue[1] * py + t.blue[2]);
+
+			// Groups of four start on a multiple of four, so they never leave the row or the tile
+			for(int x = x0 & ~3; x <= x1; x += 4) {
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+				__m128 inside = _mm_and_ps(_mm_cmpge_ps(px, firstX), _mm_cmple_ps(px, lastX));
+				for(int i = 0; i < 3; i++) {
+					__m128 e = _mm_add_ps(_mm_mul_ps(edgeA[i], px), edgeRow[i]);
+					// Pixels exactly on an edge belong to the triangle only if it's a top or left edge
+					__m128 in = _mm_or_ps(_mm_cmpgt_ps(e, zero), _mm_and_ps(_mm_cmpeq_ps(e, zero), topLeft[i]));
+					inside = _mm_and_ps(inside, in);
+				}
+				if(_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, px), depthRow0);
+				__m128 stored = _mm_loadu_ps(depthRow + x);
+				inside = _mm_and_ps(inside, _mm_cmplt_ps(depth, stored));
+				int mask = _mm_movemask_ps(inside);
+				if(mask == 0)
+					continue;
+				_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, depth), _mm_andnot_ps(inside, stored)));
+				if(depthOnly)
+					continue;
+
+				// Perspective correct colors
+				__m128 w = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_mul_ps(invWA, px), invWRow));
+				float red[4], green[4], blue[4];
+				_mm_storeu_ps(red, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(redA, px), redRow), w));
+				_mm_storeu_ps(green, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(greenA, px), greenRow), w));
+				_mm_storeu_ps(blue, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(blueA, px), blueRow), w));
+				for(int i = 0; i < 4; i++) {
+					if(mask & (1 << i))
+						colorRow[x + i] = PackColor(red[i], green[i], blue[i]);
+				}
+			}
+		}
+#else
+		for(int y = y0; y <= y1; y++) {
+			float py = (float)y + 0.5f;
+			unsigned int* colorRow = &colorBuffer[y * pitch];
+			float* depthRow = &depthBuffer[y * pitch];
+			for(int x = x0; x <= x1; x++) {
+				float px = (float)x + 0.5f;
+				bool inside = true;
+				for(int i = 0; i < 3 && inside; i++) {
+					float e = t.edges[i][0] * px + t.edges[i][1] * py + t.edges[i][2];
+					inside = e > 0.0f || (e == 0.0f && t.topLeft[i]);
+				}
+				if(!inside)
+					continue;
+				float depth = t.depth[0] * px + t.depth[1] * py + t.depth[2];
+				if(depth >= depthRow[x])
+					continue;
+				depthRow[x] = depth;
+				if(depthOnly)
+					continue;
+				float w = 1.0f / (t.invW[0] * px + t.invW[1] * py + t.invW[2]);
+				colorRow[x] = PackColor((t.red[0] * px + t.red[1] * py + t.red[2]) * w,
+					(t.green[0] * px + t.green[1] * py + t.green[2]) * w,
+					(t.blue[0] * px + t.blue[1] * py + t.blue[2]) * w);
+			}
+		}
+#endif
+	}
+}
+// Gets the color buffer; A8R8G8B8 pixels, top row first, GetPitch() pixels per row
+const unsigned int* Rasterizer::GetColorBuffer() {
+	return &colorBuffer[0];
+}
+// Gets the depth buffer; laid out like the color buffer
+const float* Rasterizer::GetDepthBuffer() {
+	return &depthBuffer[0];
+}
+// Gets the width of the buffers in pixels
+int Rasterizer::GetWidth() {
+	return width;
+}
+// Gets the height of the buffers in pixels
+int Rasterizer::GetHeight() {
+	return height;
+}
+// Gets the number of pixels per row
+int Rasterizer::GetPitch() {
+	return pitch;
+}
+// Gets the number of threads shading tiles, the calling thread included
+int Rasterizer::GetNumThreads() {
+	return numThreads;
+}
+// Gets the number of triangles shaded by the last Flush()
+int Rasterizer::GetNumTriangles() {
+	return numTriangles;
+}
+// Writes the color buffer to a 32 bit TGA file
+bool Rasterizer::SaveTGA(const char* file) {
+	FILE* out = fopen(file, "wb");
+	if(!out)
+		return false;
+	unsigned char header[18] = {0};
+	header[2] = 2; // Uncompressed true color
+	header[12] = (unsigned char)(width & 0xFF);
+	header[13] = (unsigned char)(width >> 8);
+	header[14] = (unsigned char)(height & 0xFF);
+	header[15] = (unsigned char)(height >> 8);
+	header[16] = 32; // Bits per pixel
+	header[17] = 0x28; // Eight alpha bits, top row first
+	bool written = fwrite(header, sizeof(header), 1, out) == 1;
+	// A8R8G8B8 words are B, G, R, A in memory on little endian machines, which is what TGA wants
+	for(int y = 0; y < height && written; y++)
+		written = fwrite(&colorBuffer[y * pitch], width * 4, 1, out) == 1;
+	fclose(out);
+	return written;
+}
\ No newline at end of file
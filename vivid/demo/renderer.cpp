@@ -1,606 +1,1244 @@
-// Vivid Engine v0.01
-// Copyright (C) 2006 Evan Todd
-
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// version 2 as published by the Free Software Foundation.
-
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-// GNU General Public License (included in README.txt) for more details.
-
-// You can contact the author at evanofsky@sbcglobal.net.
-
-#include "renderer.h"
-
-Renderer::Renderer() {
-	SetCullMode(D3DCULL_CCW); // Default cull mode: counter clockwise culling
-	SetFillMode(D3DFILL_SOLID); // Default fill mode: solid fill
-	SetBackgroundColor(0x000000); // Default background color: black
-	SetBackgroundTexture(0); // Default background texture: none
-	SetCameraPosition(0.0f, 0.0f, 0.0f); // Default position: origin
-
-	D3DXVECTOR3 nLook(0.0f, 0.0f, 1.0f); // Default look direction: Z axis
-	D3DXVECTOR3 nUp(0.0f, 1.0f, 0.0f); // Default up direction: Y axis
-	SetCameraRotation(&nLook, &nUp); // Sets the camera rotation
-
-	// Set up to render to the back buffer by default
-	SetViewport(0, 0, vvd::GetWidth(), vvd::GetHeight(), 0.0f, 1.0f);
-
-	SetDepthBias(0.99f);
-
-	renderTargets.resize(vvd::GetDeviceCaps()->NumSimultaneousRTs);
-	for(int i = 0; i < (int)renderTargets.size(); i++) {
-		renderTargets[i] = 0;
-	}
-
-	// Set the default render target to the back buffer
-	SetRenderTarget(0, &(RenderTarget::defaultTarget));
-
-	// No default technique
-	technique = 0;
-
-	// Set up the projection matrix
-	SetProjection(3.14159265358f * 0.5f, (float)vvd::GetWidth() / (float)vvd::GetHeight(), 1.0f, 10000.0f);
-}
-Renderer::~Renderer() {}
-Renderer::Renderer(const Renderer& renderer) {
-	cameraPos = renderer.cameraPos;
-	cameraMat = renderer.cameraMat;
-	cullMode = renderer.cullMode;
-	fillMode = renderer.fillMode;
-	backgroundColor = renderer.backgroundColor;
-	backgroundTex = renderer.backgroundTex;
-	projectionMat = renderer.projectionMat;
-	view = renderer.view;
-	look = renderer.look;
-	up = renderer.up;
-	renderTargets = renderer.renderTargets;
-	technique = renderer.technique;
-	nearPlane = renderer.nearPlane;
-	farPlane = renderer.farPlane;
-	fovY = renderer.fovY;
-	filters = renderer.filters;
-}
-// Sets the position of the camera
-void Renderer::SetCameraPosition(D3DXVECTOR3* nCameraPos) {
-	cameraPos = *nCameraPos;
-}
-// Sets the position of the camera
-void Renderer::SetCameraPosition(float x, float y, float z) {
-	cameraPos.x = x; cameraPos.y = y; cameraPos.z = z;
-}
-// Sets the rotation of the camera;
-// Look defines where the camera points
-// Up defines the rotation on the Z axis
-void Renderer::SetCameraRotation(D3DXVECTOR3* nLook, D3DXVECTOR3* nUp) {
-	look = cameraPos + (*nLook);
-	up = *nUp;
-}
-// Three options: D3DCULL_NONE, D3DCULL_CW, and D3DCULL_CCW
-void Renderer::SetCullMode(DWORD nCullMode) {
-	cullMode = nCullMode;
-}
-// Three options: D3DFILL_POINT, D3DFILL_WIREFRAME, and D3DFILL_SOLID
-void Renderer::SetFillMode(DWORD nFillMode) {
-	fillMode = nFillMode;
-}
-// Sets the color of the background (in hex code)
-void Renderer::SetBackgroundColor(D3DCOLOR nBackgroundColor) {
-	backgroundColor = nBackgroundColor;
-}
-// Sets the background texture
-void Renderer::SetBackgroundTexture(IDirect3DTexture9* nBackgroundTex) {
-	backgroundTex = nBackgroundTex;
-}
-// Sets the projection matrix
-void Renderer::SetProjectionMatrix(D3DXMATRIX* nProjectionMat) {
-	projectionMat = *nProjectionMat;
-}
-// Generates the projection matrix based on the values given
-void Renderer::SetProjection(float nFovY, float aspect, float zn, float zf) {
-	D3DXMatrixPerspectiveFovLH(&projectionMat, nFovY, aspect, zn, zf);
-	fovY = nFovY;
-	nearPlane = zn;
-	farPlane = zf;
-}
-// Sets the viewport
-void Renderer::SetViewport(D3DVIEWPORT9* nView) {
-	view = *nView;
-}
-// Generates the viewport based on the values given
-// X and Y define the position of the upper left hand corner
-// width and height define the width and height of the rendering area
-// minZ and maxZ define the minimum and maximum values for the Z buffer
-void Renderer::SetViewport(DWORD x, DWORD y, DWORD width, DWORD height, float minZ, float maxZ) {
-	view.Height = height;
-	view.Width = width;
-	view.X = x;
-	view.Y = y;
-	view.MinZ = minZ;
-	view.MaxZ = maxZ;
-}
-// Points the camera at the target specified
-void Renderer::CameraLookAt(D3DXVECTOR3* target) {
-	look = *target - cameraPos;
-}
-// Points the camera at the target specified
-void Renderer::CameraLookAt(float x, float y, float z) {
-	look.x = x - cameraPos.x;
-	look.y = y - cameraPos.y;
-	look.z = z - cameraPos.z;
-}
-// Sets the render target
-void Renderer::SetRenderTarget(int index, RenderTarget* nTarget) {
-	if(index >= (int)renderTargets.size()) {
-		std::string msg = "Failed to set render target ";
-		msg += vvd::stringconv(index);
-		msg += "; device only supports ";
-		msg += vvd::stringconv((int)renderTargets.size());
-		msg += " render targets";
-		vvd::Log(msg.c_str());
-		exit(1);
-	}
-	renderTargets[index] = nTarget;
-	if(index == 0) {
-		view.Height = renderTargets[index]->GetHeight();
-		view.Width = renderTargets[index]->GetWidth();
-		SetProjection(fovY, (float)renderTargets[index]->GetWidth() / (float)renderTargets[index]->GetHeight(), nearPlane, farPlane);
-	}
-}
-// Sets the desired effect technique
-void Renderer::SetTechnique(LPCSTR nTechnique) {
-	technique = nTechnique;
-}
-// Sets the depth bias
-void Renderer::SetDepthBias(float nBias) {
-	depthBias = nBias;
-}
-// Draws the entire scene
-void Renderer::Draw() {
-	IDirect3DDevice9* device = vvd::GetDevice();
-	if(vvd::CheckDeviceState()) { // Check if we've lost the device
-		BeginScene();
-
-		std::vector<Mesh*> alphaMeshes;
-		std::vector<Mesh*> translucentMeshes;
-
-		// Render all the meshes
-		std::list<Mesh*>::iterator i = Mesh::meshes.begin();
-		while(i != Mesh::meshes.end()) {
-			Mesh* mesh = *i;
-			if(mesh->IsAlpha() && !mesh->IsTranslucent()) {
-				alphaMeshes.push_back(mesh);
-			} else if(mesh->IsTranslucent()) {
-				translucentMeshes.push_back(mesh);
-			} else {
-				DrawMesh(mesh);
-			}
-			i++;
-		}
-
-		for(int j = 0; j < (int)alphaMeshes.size(); j++) {
-			DrawMesh(alphaMeshes[j]);
-		}
-
-		if(renderTargets[0] == &(RenderTarget::defaultTarget))
-			RenderTarget::Update();
-
-		for(int j = 0; j < (int)translucentMeshes.size(); j++) {
-			DrawMesh(translucentMeshes[j]);
-		}
-
-		// Draw the render targets if we're rendering to the back buffer
-		if(renderTargets[0] == &(RenderTarget::defaultTarget) && !RenderTarget::targets.empty()) {
-			DrawRenderTargets();
-		}
-		EndScene();
-	}
-}
-// Draws the entire scene's shadows
-void Renderer::DrawShadows() {
-	IDirect3DDevice9* device = vvd::GetDevice();
-	if(vvd::CheckDeviceState()) { // Check if we've lost the device
-		D3DXVECTOR3 look;
-		D3DXVECTOR3 up;
-
-		SetTechnique("Shadow");
-		SetCullMode(D3DCULL_CW);
-
-		std::list<Light*>::iterator i = Light::lights.begin();
-		while(i != Light::lights.end()) {
-			Light* light = *i;
-
-			SetProjection(D3DX_PI/2, 1.0f, 1.0f, light->GetRange());
-			SetCameraPosition(light->GetPosition().x, light->GetPosition().y, light->GetPosition().z);
-
-			for(int k = 0; k < 6; k++) {
-				look = GetCubeMapLook(k);
-				up = GetCubeMapUp(k);
-				SetCameraRotation(&look, &up);
-				SetCameraPosition(light->GetPosition().x, light->GetPosition().y, light->GetPosition().z);
-				SetRenderTarget(0, light->GetShadowMapTarget(k));
-
-				BeginScene();
-				// Render all the meshes
-				std::list<Mesh*>::iterator j = Mesh::meshes.begin();
-				while(j != Mesh::meshes.end()) {
-					DrawMesh(*j);
-					j++;
-				}
-				EndScene();
-			}
-			i++;
-		}
-
-	}
-}
-// Clears the render target to the background color
-void Renderer::ClearScreen() {
-	BeginScene();
-	EndScene();
-}
-void Renderer::EnableFilter(ImageFilter* imgfilter) {
-	if(!Contains(imgfilter)) {
-		filters.push_back(imgfilter);
-	}
-}
-void Renderer::DisableFilter(ImageFilter* imgfilter) {
-	if(Contains(imgfilter)) {
-		filters.erase(GetFilter(imgfilter));
-	}
-}
-// Draws the specified cells
-void Renderer::Draw(std::vector<Cell*>* cells) {
-	IDirect3DDevice9* device = vvd::GetDevice();
-	if(vvd::CheckDeviceState()) { // Check if we've lost the device
-		BeginScene(); // Begin rendering
-
-		std::vector<Mesh*> alphaMeshes;
-		std::vector<Mesh*> translucentMeshes;
-
-		// Render the cells
-		for(int i = 0; i < (int)cells->size(); i++) {
-			Cell* cell = (*cells)[i];
-
-			// Render all the meshes
-			std::vector<Mesh*>* meshes = cell->GetMeshes();
-			for(int j = 0; j < (int)meshes->size(); j++) {
-				Mesh* mesh = (*meshes)[j];
-				if(mesh->IsAlpha() && !mesh->IsTranslucent()) {
-					alphaMeshes.push_back(mesh);
-				} else if(mesh->IsTranslucent()) {
-					translucentMeshes.push_back(mesh);
-				} else {
-					DrawMesh(mesh);
-				}
-			}
-		}
-
-		for(int j = 0; j < (int)alphaMeshes.size(); j++) {
-			DrawMesh(alphaMeshes[j]);
-		}
-
-		if(renderTargets[0] == &(RenderTarget::defaultTarget))
-			RenderTarget::Update();
-
-		for(int j = 0; j < (int)translucentMeshes.size(); j++) {
-			DrawMesh(translucentMeshes[j]);
-		}
-
-		// Draw the render targets if we're rendering to the back buffer
-		if(renderTargets[0] == &(RenderTarget::defaultTarget) && !RenderTarget::targets.empty()) {
-			DrawRenderTargets();
-		}
-		EndScene(); // End rendering
-	}
-}
-// Initializes rendering; called before rendering the scene
-void Renderer::BeginScene() {
-	IDirect3DDevice9* device = vvd::GetDevice();
-
-	// Init view matrix
-	D3DXMatrixLookAtLH(&cameraMat, &cameraPos, &look, &up);
-
-	device->SetViewport(&view); // Set the viewport
-
-	device->SetRenderState(D3DRS_CULLMODE, cullMode); // Set cull mode
-	device->SetRenderState(D3DRS_FILLMODE, fillMode); // Set fill mode
-
-	device->BeginScene();
-
-	// Set the render targets
-	for(int i = 0; i < (int)renderTargets.size(); i++) {
-		IDirect3DSurface9* renderTarget = 0;
-		device->GetRenderTarget(i, &renderTarget);
-		if(renderTarget != (IDirect3DSurface9*)renderTargets[i]) {
-			if(renderTargets[i]) {
-				IDirect3DSurface9* surface = renderTargets[i]->GetSurface();
-				if(FAILED(device->SetRenderTarget(i, surface))) {
-					std::string msg = "Failed to set render target ";
-					msg += vvd::stringconv(i);
-					vvd::Log(msg.c_str());
-					exit(1);
-				}
-				vvd::Release<IDirect3DSurface9*>(surface);
-			} else {
-				if(FAILED(device->SetRenderTarget(i, 0))) {
-					std::string msg = "Failed to set render target ";
-					msg += vvd::stringconv(i);
-					vvd::Log(msg.c_str());
-					exit(1);
-				}
-			}
-		}
-	}
-
-	// Clear the render target to black
-	device->Clear(0, 0, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, backgroundColor, 1.0f, 0);
-
-	if(backgroundTex && renderTargets[0] == &(RenderTarget::defaultTarget)) {
-		// StretchRect the background texture onto the screen
-		IDirect3DSurface9* surface = 0;
-		backgroundTex->GetSurfaceLevel(0, &surface);
-		IDirect3DSurface9* surface2 = renderTargets[0]->GetSurface();
-		if(FAILED(device->StretchRect(surface, NULL, surface2, NULL, D3DTEXF_LINEAR))) {
-			vvd::Log("Vivid: StretchRect failed to copy background texture to back buffer");
-			exit(1);
-		}
-	}
-}
-// Ends rendering; called after rendering the scene
-void Renderer::EndScene() {
-	IDirect3DDevice9* device = vvd::GetDevice();
-
-	std::list<ImageFilter*>::iterator i = filters.begin();
-	while(i != filters.end()) {
-		RenderTarget::Update(renderTargets[0]);
-		(*i)->Filter(renderTargets[0]->GetSurface());
-		i++;
-	}
-
-	device->EndScene();
-
-	// Copy the back buffer to the screen only if the target is the back buffer
-	if(renderTargets[0] == &(RenderTarget::defaultTarget))
-		device->Present(0, 0, 0, 0);
-}
-// Gets the specified look vector for cube map rendering
-D3DXVECTOR3 Renderer::GetCubeMapLook(int i) {
-	switch(i) {
-		case 0:
-			return D3DXVECTOR3(1.0f, 0.0f, 0.0f);
-			break;
-		case 1:
-			return D3DXVECTOR3(-1.0f, 0.0f, 0.0f);
-			break;
-		case 2:
-			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
-			break;
-		case 3:
-			return D3DXVECTOR3(0.0f, -1.0f, 0.0f);
-			break;
-		case 4:
-			return D3DXVECTOR3(0.0f, 0.0f, 1.0f);
-			break;
-		case 5:
-			return D3DXVECTOR3(0.0f, 0.0f, -1.0f);
-			break;
-	}
-	return D3DXVECTOR3(1.0f, 0.0f, 0.0f);
-}
-// Gets the specified up vector for cube map rendering
-D3DXVECTOR3 Renderer::GetCubeMapUp(int i) {
-	switch(i) {
-		case 0:
-			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
-			break;
-		case 1:
-			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
-			break;
-		case 2:
-			return D3DXVECTOR3(0.0f, 0.0f, -1.0f);
-			break;
-		case 3:
-			return D3DXVECTOR3(0.0f, 0.0f, 1.0f);
-			break;
-		case 4:
-			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
-			break;
-		case 5:
-			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
-			break;
-	}
-	return D3DXVECTOR3(1.0f, 0.0f, 0.0f);
-}
-// Draws a single mesh
-void Renderer::DrawMesh(Mesh* mesh) {
-	IDirect3DDevice9* device = vvd::GetDevice();
-
-	DWORD index = 0;
-
-	std::vector<Material>* materials = mesh->GetMaterials();
-	for(int i = 0; i < (int)materials->size(); i++) {
-		Material* material = &((*materials)[i]); // Get the material from the mesh
-
-		// Get the number of passes from SetMaterial()
-		UINT numPasses = SetMaterial(material, mesh);
-
-		if(numPasses > 0) {
-			ID3DXEffect* effect = material->GetEffect();
-
-			// Draw the subset once for each pass
-			for(int j = 0; j < (int)numPasses; j++) {
-				// Start the pass
-				if(effect)
-					effect->BeginPass(j);
-
-				// Draw the subset
-				mesh->DrawSubset(index);
-
-				// End the pass
-				if(effect)
-					effect->EndPass();
-			}
-
-			// Disable the effect
-			if(effect)
-				effect->End();
-		}
-
-		index++;
-	}
-}
-// Draws the render targets on the right side of the screen
-void Renderer::DrawRenderTargets() {
-	IDirect3DDevice9* device = vvd::GetDevice();
-
-	std::list<RenderTarget*>::iterator i = RenderTarget::targets.begin();
-
-	int currentHeight = 0;
-
-	// Destination surface is the back buffer
-	IDirect3DSurface9* destSurface = RenderTarget::defaultTarget.GetSurface();
-
-	while(i != RenderTarget::targets.end() && currentHeight < (int)view.Height) {
-		RenderTarget* target = *i;
-
-		if(target->DrawToScreen()) {
-			// Scale to 1/4 the screen size
-			float scale = ((float)view.Width / 4.0f) / (float)target->GetWidth();
-
-			float width = (float)target->GetWidth() * scale; // Scale the width
-			float height = (float)target->GetHeight() * scale; // Scale the height
-
-			// Set up the rectangle to copy
-			RECT rect = {view.Width - (int)width, currentHeight, view.Width, currentHeight + (int)height};
-
-			// Copy the data to the back buffer
-			device->StretchRect(target->GetSurface(), NULL, destSurface, &rect, D3DTEXF_LINEAR);
-
-			// Add to the start height so the next render target renders below this one
-			currentHeight += (int)height;
-		}
-
-		i++;
-	}
-}
-// Sets the material handles; returns the number of passes required by the effect
-UINT Renderer::SetMaterial(Material* material, Mesh* mesh) {
-	IDirect3DDevice9* device = vvd::GetDevice();
-	// Default number of passes: 1
-	UINT numPasses = 1;
-
-	D3DXMATRIX worldMat = mesh->transform.GetMatrix();
-
-	ID3DXEffect* effect = material->GetEffect();
-
-	if(effect) {
-		if(technique) {
-			if(FAILED(effect->SetTechnique(technique)))
-				return 0;
-		} else {
-			D3DXHANDLE handle;
-			effect->FindNextValidTechnique(0, &handle);
-			effect->SetTechnique(handle);
-		}
-
-		// Set the view projection matrix
-		D3DXMATRIX viewProj = cameraMat * projectionMat;
-		effect->SetMatrix(material->GetViewProjHandle(), &viewProj);
-
-		// Set the projection matrix
-		effect->SetMatrix(material->GetProjectionHandle(), &projectionMat);
-
-		// Set the view matrix
-		effect->SetMatrix(material->GetViewMatHandle(), &cameraMat);
-
-		// Set the world matrix
-		effect->SetMatrix(material->GetWorldMatHandle(), &worldMat);
-
-		// Set the camera position
-		D3DXVECTOR4 nCameraPos;
-		nCameraPos.x = cameraPos.x; nCameraPos.y = cameraPos.y; nCameraPos.z = cameraPos.z; nCameraPos.w = 1.0f;
-		effect->SetVector(material->GetCameraPosHandle(), &nCameraPos);
-
-		// Set the near and far planes
-		effect->SetFloat(material->GetFarPlaneHandle(), nearPlane);
-		effect->SetFloat(material->GetNearPlaneHandle(), farPlane);
-
-		// Set the depth bias
-		effect->SetFloat(material->GetDepthBiasHandle(), depthBias);
-
-		// Setup all the lights affecting the mesh
-		if(material->RequiresLights(technique)) {
-			CompileLightArray(mesh->GetCells(), material);
-		}
-
-		// Now we can start rendering
-		effect->Begin(&numPasses, 0);
-	}
-
-	return numPasses;
-}
-// Compiles light data from the cells provided
-void Renderer::CompileLightArray(std::vector<Cell*>* cells, Material* material) {
-	float* lightRanges = Material::GetLightRanges();
-	D3DXVECTOR4* lightPositions = Material::GetLightPositions();
-	D3DXVECTOR4* lightColors = Material::GetLightColors();
-	D3DXVECTOR4* ambients = Material::GetAmbients();
-	IDirect3DTexture9** lightTextures = Material::GetLightTextures();
-	IDirect3DTexture9** shadowMaps = Material::GetShadowMaps();
-	D3DXMATRIX* lightTexMatrices = Material::GetLightTexMatrices();
-
-	// Clear the arrays
-	for(int i = 0; i < MAX_LIGHTS; i++) {
-		lightTextures[i] = 0;
-		shadowMaps[i] = 0;
-	}
-
-	int currentLight = 0;
-	int maxLights = min(material->MaxLights(), MAX_LIGHTS);
-	for(int i = 0; i < (int)cells->size(); i++) {
-		Cell* cell = (*cells)[i];
-		// For each cell, set all the lights and the ambient color
-		std::vector<Light*>* lights = cell->GetLights();
-		for(int j = 0; j < (int)lights->size() && currentLight < maxLights; j++) {
-			Light* light = (*lights)[j];
-			// For each light, copy the range, position, and color of the light to the output arrays
-			lightRanges[currentLight] = light->GetRange();
-			lightPositions[currentLight] = light->GetPosition();
-			D3DXVECTOR3 color = light->GetColor();
-			lightColors[currentLight].x = color.x; lightColors[currentLight].y = color.y; lightColors[currentLight].z = color.z; lightColors[currentLight].w = 1.0f;
-			lightTextures[currentLight] = light->GetTexture();
-			shadowMaps[currentLight] = light->GetShadowMap();
-			lightTexMatrices[currentLight] = light->GetTextureMatrix();
-			currentLight = min(currentLight + 1, maxLights);
-		}
-		// Set the ambient color of the cell
-		ambients[min(i, maxLights)] = cell->GetAmbientColor();
-	}
-	D3DXHANDLE lightNumHandle = material->GetLightNumHandle();
-	ID3DXEffect* effect = material->GetEffect();
-	effect->SetInt(lightNumHandle, currentLight);
-	material->UpdateLightArrays();
-}
-bool Renderer::Contains(ImageFilter* imgfilter) {
-	std::list<ImageFilter*>::iterator i = filters.begin();
-	while(i != filters.end()) {
-		ImageFilter* nImgFilter = *i;
-		if(nImgFilter == imgfilter)
-			return true;
-		i++;
-	}
-	return false;
-}
-std::list<ImageFilter*>::iterator Renderer::GetFilter(ImageFilter* imgfilter) {
-	std::list<ImageFilter*>::iterator i = filters.begin();
-	while(i != filters.end()) {
-		ImageFilter* nImgFilter = *i;
-		if(nImgFilter == imgfilter)
-			return i;
-		i++;
-	}
-	return i;
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "renderer.h"
+#include "jobs.h"
+
+Renderer::Renderer() {
+	SetCullMode(D3DCULL_CCW); // Default cull mode: counter clockwise culling
+	SetFillMode(D3DFILL_SOLID); // Default fill mode: solid fill
+	SetBackgroundColor(0x000000); // Default background color: black
+	SetBackgroundTexture(0); // Default background texture: none
+	SetCameraPosition(0.0f, 0.0f, 0.0f); // Default position: origin
+
+	D3DXVECTOR3 nLook(0.0f, 0.0f, 1.0f); // Default look direction: Z axis
+	D3DXVECTOR3 nUp(0.0f, 1.0f, 0.0f); // Default up direction: Y axis
+	SetCameraRotation(&nLook, &nUp); // Sets the camera rotation
+
+	// Set up to render to the back buffer by default
+	SetViewport(0, 0, vvd::GetWidth(), vvd::GetHeight(), 0.0f, 1.0f);
+
+	SetDepthBias(0.99f);
+
+	SetFrustumCulling(true);
+	SetShadowCaching(true);
+	SetOcclusionCulling(true);
+	SetInstancing(true);
+	occlusionBuffer = 0;
+	occlusionReady = false;
+	instanceBuffer = 0;
+	lightEffect = 0;
+	snapshot = 0;
+	mergeStep = 1;
+
+	renderTargets.resize(vvd::GetDeviceCaps()->NumSimultaneousRTs);
+	for(int i = 0; i < (int)renderTargets.size(); i++) {
+		renderTargets[i] = 0;
+	}
+
+	// Set the default render target to the back buffer
+	SetRenderTarget(0, &(RenderTarget::defaultTarget));
+
+	// No default technique
+	technique = 0;
+
+	// Set up the projection matrix
+	SetProjection(3.14159265358f * 0.5f, (float)vvd::GetWidth() / (float)vvd::GetHeight(), 1.0f, 10000.0f);
+}
+Renderer::~Renderer() {
+	vvd::Release<IDirect3DVertexBuffer9*>(instanceBuffer);
+	delete occlusionBuffer;
+}
+Renderer::Renderer(const Renderer& renderer) {
+	cameraPos = renderer.cameraPos;
+	cameraMat = renderer.cameraMat;
+	cullMode = renderer.cullMode;
+	fillMode = renderer.fillMode;
+	backgroundColor = renderer.backgroundColor;
+	backgroundTex = renderer.backgroundTex;
+	projectionMat = renderer.projectionMat;
+	view = renderer.view;
+	look = renderer.look;
+	up = renderer.up;
+	renderTargets = renderer.renderTargets;
+	technique = renderer.technique;
+	nearPlane = renderer.nearPlane;
+	farPlane = renderer.farPlane;
+	fovY = renderer.fovY;
+	filters = renderer.filters;
+	depthBias = renderer.depthBias;
+	frustumCulling = renderer.frustumCulling;
+	frustum = renderer.frustum;
+	shadowCaching = renderer.shadowCaching;
+	occlusionCulling = renderer.occlusionCulling;
+	occlusionBuffer = 0; // Each renderer creates its own occlusion buffer
+	occlusionReady = false;
+	instancing = renderer.instancing;
+	instanceBuffer = 0; // Each renderer creates its own instance buffer
+	lightEffect = 0;
+	snapshot = 0;
+	mergeStep = 1;
+}
+// Sets the position of the camera
+void Renderer::SetCameraPosition(D3DXVECTOR3* nCameraPos) {
+	cameraPos = *nCameraPos;
+}
+// Sets the position of the camera
+void Renderer::SetCameraPosition(float x, float y, float z) {
+	cameraPos.x = x; cameraPos.y = y; cameraPos.z = z;
+}
+// Sets the rotation of the camera;
+// Look defines where the camera points
+// Up defines the rotation on the Z axis
+void Renderer::SetCameraRotation(D3DXVECTOR3* nLook, D3DXVECTOR3* nUp) {
+	look = cameraPos + (*nLook);
+	up = *nUp;
+}
+// Three options: D3DCULL_NONE, D3DCULL_CW, and D3DCULL_CCW
+void Renderer::SetCullMode(DWORD nCullMode) {
+	cullMode = nCullMode;
+}
+// Three options: D3DFILL_POINT, D3DFILL_WIREFRAME, and D3DFILL_SOLID
+void Renderer::SetFillMode(DWORD nFillMode) {
+	fillMode = nFillMode;
+}
+// Sets the color of the background (in hex code)
+void Renderer::SetBackgroundColor(D3DCOLOR nBackgroundColor) {
+	backgroundColor = nBackgroundColor;
+}
+// Sets the background texture
+void Renderer::SetBackgroundTexture(IDirect3DTexture9* nBackgroundTex) {
+	backgroundTex = nBackgroundTex;
+}
+// Sets the projection matrix
+void Renderer::SetProjectionMatrix(D3DXMATRIX* nProjectionMat) {
+	projectionMat = *nProjectionMat;
+}
+// Generates the projection matrix based on the values given
+void Renderer::SetProjection(float nFovY, float aspect, float zn, float zf) {
+	D3DXMatrixPerspectiveFovLH(&projectionMat, nFovY, aspect, zn, zf);
+	fovY = nFovY;
+	nearPlane = zn;
+	farPlane = zf;
+}
+// Sets the viewport
+void Renderer::SetViewport(D3DVIEWPORT9* nView) {
+	view = *nView;
+}
+// Generates the viewport based on the values given
+// X and Y define the position of the upper left hand corner
+// width and height define the width and height of the rendering area
+// minZ and maxZ define the minimum and maximum values for the Z buffer
+void Renderer::SetViewport(DWORD x, DWORD y, DWORD width, DWORD height, float minZ, float maxZ) {
+	view.Height = height;
+	view.Width = width;
+	view.X = x;
+	view.Y = y;
+	view.MinZ = minZ;
+	view.MaxZ = maxZ;
+}
+// Points the camera at the target specified
+void Renderer::CameraLookAt(D3DXVECTOR3* target) {
+	look = *target - cameraPos;
+}
+// Points the camera at the target specified
+void Renderer::CameraLookAt(float x, float y, float z) {
+	look.x = x - cameraPos.x;
+	look.y = y - cameraPos.y;
+	look.z = z - cameraPos.z;
+}
+// Sets the render target
+void Renderer::SetRenderTarget(int index, RenderTarget* nTarget) {
+	if(index >= (int)renderTargets.size()) {
+		std::string msg = "Failed to set render target ";
+		msg += vvd::stringconv(index);
+		msg += "; device only supports ";
+		msg += vvd::stringconv((int)renderTargets.size());
+		msg += " render targets";
+		vvd::Log(msg.c_str());
+		exit(1);
+	}
+	renderTargets[index] = nTarget;
+	if(index == 0) {
+		view.Height = renderTargets[index]->GetHeight();
+		view.Width = renderTargets[index]->GetWidth();
+		SetProjection(fovY, (float)renderTargets[index]->GetWidth() / (float)renderTargets[index]->GetHeight(), nearPlane, farPlane);
+	}
+}
+// Sets the desired effect technique
+void Renderer::SetTechnique(LPCSTR nTechnique) {
+	technique = nTechnique;
+}
+// Sets the depth bias
+void Renderer::SetDepthBias(float nBias) {
+	depthBias = nBias;
+}
+// Enables or disables frustum culling
+void Renderer::SetFrustumCulling(bool nFrustumCulling) {
+	frustumCulling = nFrustumCulling;
+}
+// Enables or disables shadow map caching
+void Renderer::SetShadowCaching(bool nShadowCaching) {
+	shadowCaching = nShadowCaching;
+}
+// Enables or disables occlusion culling
+void Renderer::SetOcclusionCulling(bool nOcclusionCulling) {
+	occlusionCulling = nOcclusionCulling;
+}
+// Enables or disables hardware instancing
+void Renderer::SetInstancing(bool nInstancing) {
+	instancing = nInstancing;
+}
+// Draws the entire scene
+void Renderer::Draw() {
+	drawMeshes.clear();
+	std::list<SceneMesh*>::iterator i = Mesh::meshes.begin();
+	for(; i != Mesh::meshes.end(); i++)
+		drawMeshes.push_back((Mesh*)*i);
+	DrawMeshes();
+}
+// Draws the meshes of a snapshot instead of the live ones
+void Renderer::Draw(FrameSnapshot* nSnapshot) {
+	snapshot = nSnapshot;
+	DrawMeshes();
+	snapshot = 0;
+}
+// Draws drawMeshes, or the snapshot's meshes if there is one
+void Renderer::DrawMeshes() {
+	IDirect3DDevice9* device = vvd::GetDevice();
+	if(vvd::CheckDeviceState()) { // Check if we've lost the device
+		BeginScene();
+		DrawOccluders();
+
+		// Render all the meshes
+		QueueVisibleMeshes();
+
+		DrawQueue(&opaqueQueue);
+		DrawQueue(&alphaQueue);
+
+		if(renderTargets[0] == &(RenderTarget::defaultTarget))
+			RenderTarget::Update();
+
+		DrawQueue(&translucentQueue);
+
+		// Draw the render targets if we're rendering to the back buffer
+		if(renderTargets[0] == &(RenderTarget::defaultTarget) && !RenderTarget::targets.empty()) {
+			DrawRenderTargets();
+		}
+		EndScene();
+	}
+}
+// Draws the entire scene into the rasterizer's buffers on the CPU instead of the device
+void Renderer::DrawSoftware(Rasterizer* rasterizer) {
+	UpdateView();
+	Matrix viewProj = cameraMat * projectionMat;
+	rasterizer->SetViewProjection(&viewProj);
+	rasterizer->SetCullBackFaces(cullMode == D3DCULL_CCW);
+	rasterizer->Clear(backgroundColor);
+
+	Vector4 diffuse(1.0f, 1.0f, 1.0f, 1.0f); // Textures and material colors aren't sampled
+
+	std::list<SceneMesh*>::iterator i = Mesh::meshes.begin();
+	while(i != Mesh::meshes.end()) {
+		Mesh* mesh = (Mesh*)*i;
+		i++;
+		if(!mesh->IsLoaded())
+			continue;
+		MeshState state;
+		FrameSnapshot::CaptureMesh(mesh, &state, false);
+		if(!IsVisible(&state))
+			continue;
+		ID3DXMesh* d3dmesh = mesh->GetD3DMesh();
+
+		int positionOffset = FindVertexElement(d3dmesh, D3DDECLUSAGE_POSITION);
+		int normalOffset = FindVertexElement(d3dmesh, D3DDECLUSAGE_NORMAL);
+		if(positionOffset < 0)
+			continue;
+
+		// Light the mesh with the same lights the effects would get
+		std::vector<Cell*>* cells = mesh->GetCells();
+		Vector3 ambient(0.0f, 0.0f, 0.0f);
+		if(!cells->empty())
+			ambient = (*cells)[0]->GetAmbientColor().XYZ();
+		rasterizer->SetLights(mesh->GetLights(), &ambient);
+
+		BYTE* vertices = 0;
+		void* indices = 0;
+		if(FAILED(d3dmesh->LockVertexBuffer(D3DLOCK_READONLY, (void**)&vertices)))
+			continue;
+		if(FAILED(d3dmesh->LockIndexBuffer(D3DLOCK_READONLY, &indices))) {
+			d3dmesh->UnlockVertexBuffer();
+			continue;
+		}
+		rasterizer->DrawTriangles(&state.world, &diffuse, vertices + positionOffset, normalOffset < 0 ? 0 : vertices + normalOffset,
+			d3dmesh->GetNumBytesPerVertex(), d3dmesh->GetNumVertices(), indices,
+			(d3dmesh->GetOptions() & D3DXMESH_32BIT) != 0, d3dmesh->GetNumFaces());
+		d3dmesh->UnlockIndexBuffer();
+		d3dmesh->UnlockVertexBuffer();
+	}
+
+	rasterizer->Flush();
+}
+// Rasterizes the occluders inside the view frustum into the occlusion buffer
+void Renderer::DrawOccluders() {
+	occlusionReady = false;
+	if(!occlusionCulling)
+		return;
+
+	// Find the occluders in the frame being drawn
+	occluderStates.clear();
+	if(snapshot) {
+		for(int i = 0; i < (int)snapshot->meshes.size(); i++) {
+			if(snapshot->meshes[i].state.occluder)
+				occluderStates.push_back(snapshot->meshes[i].state);
+		}
+	} else {
+		std::list<Mesh*>::iterator i = Mesh::occluders.begin();
+		while(i != Mesh::occluders.end()) {
+			if((*i)->IsLoaded()) {
+				occluderStates.push_back(MeshState());
+				FrameSnapshot::CaptureMesh(*i, &occluderStates.back(), false);
+			}
+			i++;
+		}
+	}
+	if(occluderStates.empty())
+		return;
+
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	double start = vvd::GetTime();
+
+	// Keep the viewport's aspect ratio
+	int width = OCCLUSION_BUFFER_WIDTH;
+	int height = max(1, (int)(OCCLUSION_BUFFER_WIDTH * view.Height / max(view.Width, (DWORD)1)));
+	if(occlusionBuffer && occlusionBuffer->GetHeight() != height) {
+		delete occlusionBuffer;
+		occlusionBuffer = 0;
+	}
+	if(!occlusionBuffer)
+		occlusionBuffer = new OcclusionBuffer(width, height);
+
+	Matrix viewProj = cameraMat * projectionMat;
+	occlusionBuffer->Begin(&viewProj);
+	for(int i = 0; i < (int)occluderStates.size(); i++) {
+		MeshState* state = &occluderStates[i];
+		if(frustumCulling && !frustum.Intersects(&state->center, state->radius))
+			continue;
+		ID3DXMesh* d3dmesh = state->mesh->GetD3DMesh();
+		int positionOffset = FindVertexElement(d3dmesh, D3DDECLUSAGE_POSITION);
+		if(positionOffset < 0)
+			continue;
+
+		BYTE* vertices = 0;
+		void* indices = 0;
+		if(FAILED(d3dmesh->LockVertexBuffer(D3DLOCK_READONLY, (void**)&vertices)))
+			continue;
+		if(FAILED(d3dmesh->LockIndexBuffer(D3DLOCK_READONLY, &indices))) {
+			d3dmesh->UnlockVertexBuffer();
+			continue;
+		}
+		occlusionBuffer->DrawOccluder(&state->world, vertices + positionOffset, d3dmesh->GetNumBytesPerVertex(),
+			d3dmesh->GetNumVertices(), indices, (d3dmesh->GetOptions() & D3DXMESH_32BIT) != 0, d3dmesh->GetNumFaces());
+		d3dmesh->UnlockIndexBuffer();
+		d3dmesh->UnlockVertexBuffer();
+		stats->occluders++;
+	}
+	occlusionBuffer->End();
+	stats->occluderTriangles += occlusionBuffer->GetNumTriangles();
+	occlusionReady = true;
+
+	stats->occlusionTime += (float)((vvd::GetTime() - start) * 1000.0);
+}
+// Gets the offset of a float3 vertex element; -1 if there isn't one
+int Renderer::FindVertexElement(ID3DXMesh* d3dmesh, BYTE usage) {
+	D3DVERTEXELEMENT9 decl[MAX_FVF_DECL_SIZE];
+	if(FAILED(d3dmesh->GetDeclaration(decl)))
+		return -1;
+	for(int i = 0; decl[i].Stream != 0xFF; i++) {
+		if(decl[i].Stream == 0 && decl[i].UsageIndex == 0 && decl[i].Usage == usage && decl[i].Type == D3DDECLTYPE_FLOAT3)
+			return decl[i].Offset;
+	}
+	return -1;
+}
+// Draws the entire scene's shadows
+void Renderer::DrawShadows() {
+	IDirect3DDevice9* device = vvd::GetDevice();
+	if(vvd::CheckDeviceState()) { // Check if we've lost the device
+		D3DXVECTOR3 look;
+		D3DXVECTOR3 up;
+
+		vvd::FrameStats* stats = vvd::GetFrameStats();
+
+		SetTechnique("Shadow");
+		SetCullMode(D3DCULL_CW);
+
+		// Get the meshes and lights of the frame being drawn
+		if(snapshot) {
+			shadowStates.resize(snapshot->meshes.size());
+			for(int i = 0; i < (int)shadowStates.size(); i++)
+				shadowStates[i] = &snapshot->meshes[i].state;
+			shadowLights = snapshot->lights;
+		} else {
+			Transform::UpdateHierarchy(); // So the jobs only read the parents of their meshes
+			Light::UpdateLights();
+			shadowMeshes.clear();
+			std::list<SceneMesh*>::iterator m = Mesh::meshes.begin();
+			for(; m != Mesh::meshes.end(); m++)
+				shadowMeshes.push_back((Mesh*)*m);
+			shadowMeshStates.resize(shadowMeshes.size());
+			shadowStates.resize(shadowMeshes.size());
+			for(int i = 0; i < (int)shadowStates.size(); i++)
+				shadowStates[i] = &shadowMeshStates[i];
+			shadowLights.resize(Light::lights.size());
+			std::list<SceneLight*>::iterator j = Light::lights.begin();
+			for(int k = 0; j != Light::lights.end(); j++, k++)
+				FrameSnapshot::CaptureLight((Light*)*j, &shadowLights[k]);
+		}
+
+		// Get the world space bounding sphere of every mesh once for all the lights
+		shadowCenters.resize(shadowStates.size());
+		shadowRadii.resize(shadowStates.size());
+		vvd::ParallelFor((int)shadowStates.size(), 0, GetShadowBounds, this);
+
+		// Find the meshes inside each cube face, one light per job
+		shadowFaceCasters.resize(shadowLights.size() * 6);
+		shadowFaceQueues.resize(shadowLights.size() * 6);
+		shadowFaceCached.resize(shadowLights.size() * 6);
+		vvd::ParallelFor((int)shadowLights.size(), 1, FindShadowCasters, this);
+
+		for(int i = 0; i < (int)shadowLights.size(); i++) {
+			LightState* light = &shadowLights[i];
+			Vector3 lightPos = Vector4(light->position).XYZ();
+			float range = light->range;
+
+			SetProjection(D3DX_PI/2, 1.0f, 1.0f, range);
+			SetCameraPosition(lightPos.x, lightPos.y, lightPos.z);
+
+			for(int k = 0; k < 6; k++) {
+				look = GetCubeMapLook(k);
+				up = GetCubeMapUp(k);
+				SetCameraRotation(&look, &up);
+				SetCameraPosition(lightPos.x, lightPos.y, lightPos.z);
+				SetRenderTarget(0, light->light->GetShadowMapTarget(k));
+				int face = i * 6 + k;
+				if(shadowFaceCached[face]) {
+					stats->shadowFacesCached++;
+					continue;
+				}
+
+				// The jobs already built the face's draw items; replay them
+				UpdateView();
+				BeginScene();
+				stats->shadowFaces++;
+				stats->shadowCasters += (int)shadowFaceCasters[face].size();
+				DrawQueue(&shadowFaceQueues[face]);
+				EndScene();
+				light->light->SetShadowFaceCasters(k, light, &shadowFaceCasters[face]);
+			}
+		}
+
+	}
+}
+// Draws the shadows of a snapshot instead of the live scene
+void Renderer::DrawShadows(FrameSnapshot* nSnapshot) {
+	snapshot = nSnapshot;
+	DrawShadows();
+	snapshot = 0;
+}
+// Gets the bounding spheres of shadowStates[first, last)
+void Renderer::GetShadowBounds(void* nRenderer, int first, int last) {
+	Renderer* renderer = (Renderer*)nRenderer;
+	for(int i = first; i < last; i++) {
+		MeshState* state = renderer->shadowStates[i];
+		if(!renderer->snapshot)
+			FrameSnapshot::CaptureMesh(renderer->shadowMeshes[i], state, false);
+		renderer->shadowCenters[i] = state->center;
+		renderer->shadowRadii[i] = state->radius;
+	}
+}
+// Finds the meshes inside each cube face of shadowLights[first, last) and builds the queues of the faces to render
+void Renderer::FindShadowCasters(void* nRenderer, int first, int last) {
+	Renderer* renderer = (Renderer*)nRenderer;
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	std::vector<int> casters; // Meshes within range of the current light
+	for(int i = first; i < last; i++) {
+		LightState* light = &renderer->shadowLights[i];
+		Vector3 lightPos = Vector4(light->position).XYZ();
+		float range = light->range;
+
+		// Skip the meshes the light can't reach
+		casters.clear();
+		for(int k = 0; k < (int)renderer->shadowStates.size(); k++) {
+			Vector3 offset = renderer->shadowCenters[k] - lightPos;
+			float reach = range + renderer->shadowRadii[k];
+			if(offset.LengthSq() <= reach * reach) {
+				casters.push_back(k);
+			} else {
+				stats->shadowCastersCulled += 6;
+			}
+		}
+
+		// Build the 90 degree frustum of each face the way DrawShadows() sets up its camera
+		Matrix projection = Matrix::PerspectiveFovLH(D3DX_PI/2, 1.0f, 1.0f, range);
+		for(int k = 0; k < 6; k++) {
+			std::vector<MeshState*>* faceCasters = &renderer->shadowFaceCasters[i * 6 + k];
+			faceCasters->clear();
+			Vector3 look = renderer->GetCubeMapLook(k);
+			Vector3 up = renderer->GetCubeMapUp(k);
+			Matrix viewProj = Matrix::LookAtLH(lightPos, lightPos + look, up) * projection;
+			Frustum frustum;
+			frustum.Build(&viewProj);
+			for(int l = 0; l < (int)casters.size(); l++) {
+				int caster = casters[l];
+				if(renderer->frustumCulling && !frustum.Intersects(&renderer->shadowCenters[caster], renderer->shadowRadii[caster])) {
+					stats->shadowCastersCulled++;
+				} else {
+					faceCasters->push_back(renderer->shadowStates[caster]);
+				}
+			}
+
+			// The face still holds the right shadows if nothing inside it changed
+			int face = i * 6 + k;
+			std::vector<DrawItem>* queue = &renderer->shadowFaceQueues[face];
+			queue->clear();
+			renderer->shadowFaceCached[face] = renderer->shadowCaching && light->light->IsShadowFaceCurrent(k, light, faceCasters);
+			if(renderer->shadowFaceCached[face])
+				continue;
+			for(int l = 0; l < (int)faceCasters->size(); l++)
+				renderer->QueueMesh((*faceCasters)[l], queue);
+			SortQueue(queue);
+		}
+	}
+}
+// Clears the render target to the background color
+void Renderer::ClearScreen() {
+	BeginScene();
+	EndScene();
+}
+void Renderer::EnableFilter(ImageFilter* imgfilter) {
+	if(!Contains(imgfilter)) {
+		filters.push_back(imgfilter);
+	}
+}
+void Renderer::DisableFilter(ImageFilter* imgfilter) {
+	if(Contains(imgfilter)) {
+		filters.erase(GetFilter(imgfilter));
+	}
+}
+// Draws the specified cells
+void Renderer::Draw(std::vector<Cell*>* cells) {
+	// Gather the meshes in the cells; a mesh can be inside several of them, so remove the duplicates
+	drawMeshes.clear();
+	for(int i = 0; i < (int)cells->size(); i++) {
+		std::vector<SceneMesh*>* meshes = (*cells)[i]->GetMeshes();
+		for(int j = 0; j < (int)meshes->size(); j++)
+			drawMeshes.push_back((Mesh*)(*meshes)[j]);
+	}
+	std::sort(drawMeshes.begin(), drawMeshes.end());
+	drawMeshes.erase(std::unique(drawMeshes.begin(), drawMeshes.end()), drawMeshes.end());
+
+	DrawMeshes();
+}
+// Draws the cells of the world inside the view frustum
+void Renderer::Draw(World* world) {
+	UpdateView(); // Build the frustum before asking the world for the visible cells
+	if(frustumCulling) {
+		world->QueryFrustum(&frustum, &visibleCells);
+	} else {
+		world->GetCells(&visibleCells);
+	}
+	Draw(&visibleCells);
+}
+// Builds the view matrix and view frustum from the camera settings
+void Renderer::UpdateView() {
+	// Init view matrix
+	D3DXMatrixLookAtLH(&cameraMat, &cameraPos, &look, &up);
+
+	// Build the view frustum for culling
+	Matrix viewProj = cameraMat * projectionMat;
+	frustum.Build(&viewProj);
+}
+// Initializes rendering; called before rendering the scene
+void Renderer::BeginScene() {
+	IDirect3DDevice9* device = vvd::GetDevice();
+
+	UpdateView();
+
+	// Another renderer may have sent different lights to the effects since the last scene
+	lightEffect = 0;
+
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+
+	device->SetViewport(&view); // Set the viewport
+
+	device->SetRenderState(D3DRS_CULLMODE, cullMode); // Set cull mode
+	device->SetRenderState(D3DRS_FILLMODE, fillMode); // Set fill mode
+	stats->stateChanges += 3;
+
+	device->BeginScene();
+	stats->scenes++;
+
+	// Set the render targets
+	for(int i = 0; i < (int)renderTargets.size(); i++) {
+		IDirect3DSurface9* renderTarget = 0;
+		device->GetRenderTarget(i, &renderTarget);
+		if(renderTarget != (IDirect3DSurface9*)renderTargets[i]) {
+			if(renderTargets[i]) {
+				IDirect3DSurface9* surface = renderTargets[i]->GetSurface();
+				if(FAILED(device->SetRenderTarget(i, surface))) {
+					std::string msg = "Failed to set render target ";
+					msg += vvd::stringconv(i);
+					vvd::Log(msg.c_str());
+					exit(1);
+				}
+				vvd::Release<IDirect3DSurface9*>(surface);
+				stats->stateChanges++;
+			} else {
+				if(FAILED(device->SetRenderTarget(i, 0))) {
+					std::string msg = "Failed to set render target ";
+					msg += vvd::stringconv(i);
+					vvd::Log(msg.c_str());
+					exit(1);
+				}
+				stats->stateChanges++;
+			}
+		}
+	}
+
+	// Clear the render target to black
+	device->Clear(0, 0, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, backgroundColor, 1.0f, 0);
+
+	if(backgroundTex && renderTargets[0] == &(RenderTarget::defaultTarget)) {
+		// StretchRect the background texture onto the screen
+		IDirect3DSurface9* surface = 0;
+		backgroundTex->GetSurfaceLevel(0, &surface);
+		IDirect3DSurface9* surface2 = renderTargets[0]->GetSurface();
+		if(FAILED(device->StretchRect(surface, NULL, surface2, NULL, D3DTEXF_LINEAR))) {
+			vvd::Log("Vivid: StretchRect failed to copy background texture to back buffer");
+			exit(1);
+		}
+	}
+}
+// Ends rendering; called after rendering the scene
+void Renderer::EndScene() {
+	IDirect3DDevice9* device = vvd::GetDevice();
+
+	occlusionReady = false; // The next scene may be seen from somewhere else
+
+	std::list<ImageFilter*>::iterator i = filters.begin();
+	while(i != filters.end()) {
+		RenderTarget::Update(renderTargets[0]);
+		(*i)->Filter(renderTargets[0]->GetSurface());
+		i++;
+	}
+
+	device->EndScene();
+
+	// Copy the back buffer to the screen only if the target is the back buffer
+	if(renderTargets[0] == &(RenderTarget::defaultTarget))
+		device->Present(0, 0, 0, 0);
+}
+// Gets the specified look vector for cube map rendering
+D3DXVECTOR3 Renderer::GetCubeMapLook(int i) {
+	switch(i) {
+		case 0:
+			return D3DXVECTOR3(1.0f, 0.0f, 0.0f);
+			break;
+		case 1:
+			return D3DXVECTOR3(-1.0f, 0.0f, 0.0f);
+			break;
+		case 2:
+			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+			break;
+		case 3:
+			return D3DXVECTOR3(0.0f, -1.0f, 0.0f);
+			break;
+		case 4:
+			return D3DXVECTOR3(0.0f, 0.0f, 1.0f);
+			break;
+		case 5:
+			return D3DXVECTOR3(0.0f, 0.0f, -1.0f);
+			break;
+	}
+	return D3DXVECTOR3(1.0f, 0.0f, 0.0f);
+}
+// Gets the specified up vector for cube map rendering
+D3DXVECTOR3 Renderer::GetCubeMapUp(int i) {
+	switch(i) {
+		case 0:
+			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+			break;
+		case 1:
+			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+			break;
+		case 2:
+			return D3DXVECTOR3(0.0f, 0.0f, -1.0f);
+			break;
+		case 3:
+			return D3DXVECTOR3(0.0f, 0.0f, 1.0f);
+			break;
+		case 4:
+			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+			break;
+		case 5:
+			return D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+			break;
+	}
+	return D3DXVECTOR3(1.0f, 0.0f, 0.0f);
+}
+// Orders draw items by effect, then shared mesh data, then subset, then cells
+static bool CompareDrawItems(const DrawItem& a, const DrawItem& b) {
+	if(a.key != b.key)
+		return a.key < b.key;
+	// Pointers are folded into the key on 64 bit builds, so it can tie for different effects or mesh data
+	if(a.effect != b.effect)
+		return a.effect < b.effect;
+	if(a.d3dmesh != b.d3dmesh)
+		return a.d3dmesh < b.d3dmesh;
+	if(a.subset != b.subset)
+		return a.subset < b.subset;
+	// Copies in the same cells are lit by the same lights
+	std::vector<Cell*>* cellsA = a.state->cells;
+	std::vector<Cell*>* cellsB = b.state->cells;
+	if(*cellsA != *cellsB)
+		return *cellsA < *cellsB;
+	return a.mesh < b.mesh;
+}
+// Packs the effect, mesh data and subset into a sort key. Materials loaded from the same file share one effect,
+// and the textures live in the effect, so grouping by effect also groups by texture set; copies of the same
+// X file share their mesh data, and keeping them together lets them be instanced
+static UINT64 MakeSortKey(ID3DXEffect* effect, ID3DXMesh* d3dmesh, DWORD subset) {
+	UINT64 effectBits = (UINT64)(size_t)effect;
+	UINT64 meshBits = (UINT64)(size_t)d3dmesh >> 4; // Heap pointers are aligned
+	effectBits = (effectBits ^ (effectBits >> 32)) & 0xFFFFFFFF;
+	meshBits = (meshBits ^ (meshBits >> 24) ^ (meshBits >> 48)) & 0xFFFFFF;
+	return (effectBits << 32) | (meshBits << 8) | (subset & 0xFF);
+}
+// Gets the lights of a mesh state; the shadow jobs don't rank the lights of live meshes, so it's done when they're needed
+static std::vector<SceneLight*>* GetStateLights(MeshState* state) {
+	if(!state->lights)
+		state->lights = state->mesh->GetLights();
+	return state->lights;
+}
+// Returns true if the two items can be drawn by the same instanced draw call
+static bool CanInstance(const DrawItem& a, const DrawItem& b, bool lights) {
+	if(a.d3dmesh != b.d3dmesh || a.subset != b.subset)
+		return false;
+	if(!lights)
+		return true;
+	// Every copy in the batch gets the same light arrays
+	return *a.state->cells == *b.state->cells && *GetStateLights(a.state) == *GetStateLights(b.state);
+}
+// Adds every subset of the mesh to the queue
+void Renderer::QueueMesh(MeshState* state, std::vector<DrawItem>* queue) {
+	Mesh* mesh = state->mesh;
+	std::vector<Material>* materials = mesh->GetMaterials();
+	DrawItem item;
+	item.mesh = mesh;
+	item.d3dmesh = mesh->GetD3DMesh();
+	item.state = state;
+	for(int i = 0; i < (int)materials->size(); i++) {
+		item.subset = (DWORD)i;
+		item.material = &((*materials)[i]);
+		item.effect = item.material->GetEffect();
+		item.key = MakeSortKey(item.effect, item.d3dmesh, item.subset);
+		queue->push_back(item);
+	}
+}
+// Sorts the queue by effect, mesh data and subset
+void Renderer::SortQueue(std::vector<DrawItem>* queue) {
+	std::sort(queue->begin(), queue->end(), CompareDrawItems);
+}
+// Merges the sorted next list into the sorted list after its own items; scratch ends up holding the old list
+void Renderer::MergeQueue(std::vector<DrawItem>* list, std::vector<DrawItem>* next, std::vector<DrawItem>* scratch) {
+	if(next->empty())
+		return;
+	scratch->resize(list->size() + next->size());
+	// std::merge takes equal items from the first range first, so the order doesn't depend on the pairing
+	std::merge(list->begin(), list->end(), next->begin(), next->end(), scratch->begin(), CompareDrawItems);
+	list->swap(*scratch);
+}
+// Merges each pair of draw lists mergeStep apart into the first of the pair
+void Renderer::MergeDrawLists(void* nRenderer, int first, int last) {
+	Renderer* renderer = (Renderer*)nRenderer;
+	int step = renderer->mergeStep;
+	for(int i = first; i < last; i++) {
+		DrawList* list = &renderer->drawLists[i * step * 2];
+		DrawList* next = &renderer->drawLists[i * step * 2 + step];
+		MergeQueue(&list->opaque, &next->opaque, &list->scratch);
+		MergeQueue(&list->alpha, &next->alpha, &list->scratch);
+		MergeQueue(&list->translucent, &next->translucent, &list->scratch);
+	}
+}
+// Draws a sorted queue and empties it
+void Renderer::DrawQueue(std::vector<DrawItem>* queue) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+
+	// Instancing needs vertex shader 3.0 for stream frequency
+	bool hardwareInstancing = instancing && vvd::GetDeviceCaps()->VertexShaderVersion >= D3DVS_VERSION(3, 0);
+
+	int first = 0;
+	while(first < (int)queue->size()) {
+		Material* material = (*queue)[first].material;
+		ID3DXEffect* effect = (*queue)[first].effect;
+
+		// Find the end of the run of items sharing this effect
+		int last = first + 1;
+		while(last < (int)queue->size() && (*queue)[last].effect == effect)
+			last++;
+
+		if(!effect) {
+			// No effect; draw the subsets with the fixed function pipeline
+			for(int i = first; i < last; i++) {
+				(*queue)[i].mesh->DrawSubset((*queue)[i].subset);
+				stats->drawCalls++;
+			}
+		} else if(hardwareInstancing && material->GetInstancedTechnique(technique)) {
+			// Split the run into batches of copies that can be instanced and everything else
+			bool lights = material->RequiresLights(technique);
+			singleQueue.clear();
+			instanceBatches.clear();
+			int i = first;
+			while(i < last) {
+				int end = i + 1;
+				while(end < last && CanInstance((*queue)[i], (*queue)[end], lights))
+					end++;
+				if(end - i >= MIN_INSTANCES) {
+					instanceBatches.push_back(std::pair<int, int>(i, end));
+				} else {
+					for(int j = i; j < end; j++)
+						singleQueue.push_back((*queue)[j]);
+				}
+				i = end;
+			}
+			DrawItems(&singleQueue, 0, (int)singleQueue.size());
+			DrawInstanced(queue, &instanceBatches);
+		} else {
+			DrawItems(queue, first, last);
+		}
+
+		first = last;
+	}
+
+	queue->clear();
+}
+// Draws the items in [first, last) of the queue; all the items must share one effect
+void Renderer::DrawItems(std::vector<DrawItem>* queue, int first, int last) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+
+	if(first >= last)
+		return;
+
+	Material* material = (*queue)[first].material;
+	ID3DXEffect* effect = material->GetEffect();
+
+	// Set the per-frame constants once for the whole run
+	UINT numPasses = BeginEffect(material, false);
+
+	// Draw every subset once for each pass
+	for(int j = 0; j < (int)numPasses; j++) {
+		effect->BeginPass(j);
+		stats->passes++;
+
+		Mesh* currentMesh = 0;
+		for(int i = first; i < last; i++) {
+			DrawItem* item = &((*queue)[i]);
+			// Only upload the per-object constants when the mesh changes
+			if(item->mesh != currentMesh) {
+				currentMesh = item->mesh;
+				SetObject(item);
+				effect->CommitChanges();
+			}
+			currentMesh->DrawSubset(item->subset);
+			stats->drawCalls++;
+		}
+
+		effect->EndPass();
+	}
+
+	// Disable the effect
+	if(numPasses > 0)
+		effect->End();
+}
+// Draws each batch of the queue with one instanced draw call per pass; all the batches must share one effect
+void Renderer::DrawInstanced(std::vector<DrawItem>* queue, std::vector<std::pair<int, int> >* batches) {
+	IDirect3DDevice9* device = vvd::GetDevice();
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+
+	if(batches->empty())
+		return;
+
+	// Create the instance buffer the first time it's needed
+	if(!instanceBuffer) {
+		if(FAILED(device->CreateVertexBuffer(MAX_INSTANCES * sizeof(D3DXMATRIX), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, 0, D3DPOOL_DEFAULT, &instanceBuffer, 0))) {
+			vvd::Log("Vivid: Failed to create instance buffer; instancing disabled");
+			instanceBuffer = 0;
+			instancing = false;
+			for(int i = 0; i < (int)batches->size(); i++)
+				DrawItems(queue, (*batches)[i].first, (*batches)[i].second);
+			return;
+		}
+	}
+
+	Material* material = (*queue)[(*batches)[0].first].material;
+	ID3DXEffect* effect = material->GetEffect();
+	bool lights = material->RequiresLights(technique);
+
+	UINT numPasses = BeginEffect(material, true);
+
+	for(int j = 0; j < (int)numPasses; j++) {
+		effect->BeginPass(j);
+		stats->passes++;
+
+		for(int b = 0; b < (int)batches->size(); b++) {
+			int first = (*batches)[b].first;
+			int last = (*batches)[b].second;
+			Mesh* mesh = (*queue)[first].mesh;
+
+			// Every copy in the batch is lit by the same lights
+			if(lights) {
+				CompileLightArray((*queue)[first].state, (*queue)[first].material);
+				effect->CommitChanges();
+			}
+
+			// Draw the batch in chunks that fit in the instance buffer
+			for(int start = first; start < last; start += MAX_INSTANCES) {
+				int count = min(last - start, MAX_INSTANCES);
+
+				// Copy the world matrices into the instance buffer
+				D3DXMATRIX* matrices = 0;
+				if(FAILED(instanceBuffer->Lock(0, count * sizeof(D3DXMATRIX), (void**)&matrices, D3DLOCK_DISCARD)))
+					continue;
+				for(int k = 0; k < count; k++)
+					matrices[k] = (*queue)[start + k].state->world;
+				instanceBuffer->Unlock();
+				stats->matrixUploads++;
+
+				mesh->DrawSubsetInstanced((*queue)[start].subset, instanceBuffer, (UINT)count);
+				stats->drawCalls++;
+				stats->instancedDrawCalls++;
+				stats->instances += count;
+			}
+		}
+
+		effect->EndPass();
+	}
+
+	if(numPasses > 0)
+		effect->End();
+}
+// Culls drawStates and builds their draw lists on the job threads, then merges the lists into sorted queues
+void Renderer::QueueVisibleMeshes() {
+	if(snapshot) {
+		drawStates.resize(snapshot->meshes.size());
+		for(int i = 0; i < (int)drawStates.size(); i++)
+			drawStates[i] = &snapshot->meshes[i].state;
+	} else {
+		// Propagate parent transforms first, so the jobs only read the parents of their meshes
+		Transform::UpdateHierarchy();
+		Light::UpdateLights();
+		meshStates.resize(drawMeshes.size());
+		drawStates.resize(drawMeshes.size());
+		for(int i = 0; i < (int)drawStates.size(); i++)
+			drawStates[i] = &meshStates[i];
+	}
+	drawLists.resize((drawStates.size() + DRAW_LIST_GRAIN - 1) / DRAW_LIST_GRAIN);
+	vvd::ParallelFor((int)drawStates.size(), DRAW_LIST_GRAIN, BuildDrawList, this);
+
+	// Merge neighbouring lists in pairs, then pairs of pairs, so every item is copied log2(lists) times instead of
+	// once per list after it. Merging neighbours keeps the draw order the same whichever threads built them
+	int numLists = (int)drawLists.size();
+	for(mergeStep = 1; mergeStep < numLists; mergeStep *= 2)
+		vvd::ParallelFor((numLists + mergeStep - 1) / (mergeStep * 2), 1, MergeDrawLists, this);
+	if(numLists > 0) {
+		// DrawQueue() emptied the queues, so they can trade places with the merged lists
+		opaqueQueue.swap(drawLists[0].opaque);
+		alphaQueue.swap(drawLists[0].alpha);
+		translucentQueue.swap(drawLists[0].translucent);
+	}
+}
+// Culls drawStates[first, last), ranks the lights of the visible ones, and builds their sorted draw list
+void Renderer::BuildDrawList(void* nRenderer, int first, int last) {
+	Renderer* renderer = (Renderer*)nRenderer;
+	DrawList* list = &renderer->drawLists[first / DRAW_LIST_GRAIN];
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	list->opaque.clear();
+	list->alpha.clear();
+	list->translucent.clear();
+	list->spheres.Clear();
+	for(int i = first; i < last; i++) {
+		MeshState* state = renderer->drawStates[i];
+		if(!renderer->snapshot)
+			FrameSnapshot::CaptureMesh(renderer->drawMeshes[i], state, false);
+		list->spheres.AddSphere(&state->center, state->radius);
+	}
+
+	// Test the bounding spheres against the frustum four at a time
+	list->visible.resize(last - first);
+	int numVisible = last - first;
+	if(renderer->frustumCulling) {
+		numVisible = list->spheres.Cull(&renderer->frustum, &list->visible[0]);
+		stats->meshesCulled += last - first - numVisible;
+	} else {
+		for(int i = 0; i < numVisible; i++)
+			list->visible[i] = i;
+	}
+
+	for(int j = 0; j < numVisible; j++) {
+		MeshState* state = renderer->drawStates[first + list->visible[j]];
+		if(renderer->IsOccluded(state))
+			continue;
+		stats->meshesDrawn++;
+		// CompileLightArray() sends the lights to the effects on the render thread; ranking them can be done here.
+		// A snapshot's lights were already ranked on the game thread
+		GetStateLights(state);
+		Mesh* mesh = state->mesh;
+		if(mesh->IsAlpha() && !mesh->IsTranslucent()) {
+			renderer->QueueMesh(state, &list->alpha);
+		} else if(mesh->IsTranslucent()) {
+			renderer->QueueMesh(state, &list->translucent);
+		} else {
+			renderer->QueueMesh(state, &list->opaque);
+		}
+	}
+	SortQueue(&list->opaque);
+	SortQueue(&list->alpha);
+	SortQueue(&list->translucent);
+}
+// Returns true if the mesh's bounding sphere is inside the view frustum
+bool Renderer::IsVisible(MeshState* state) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	if(frustumCulling) {
+		if(!frustum.Intersects(&state->center, state->radius)) {
+			stats->meshesCulled++;
+			return false;
+		}
+	}
+	if(IsOccluded(state))
+		return false;
+	stats->meshesDrawn++;
+	return true;
+}
+// Returns true if the occluders hide the mesh's bounding sphere
+bool Renderer::IsOccluded(MeshState* state) {
+	// The occluders themselves are always drawn
+	if(!occlusionReady || state->occluder)
+		return false;
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	double start = vvd::GetTime();
+	bool occluded = occlusionBuffer->IsOccluded(&state->center, state->radius);
+	stats->occlusionTime += (float)((vvd::GetTime() - start) * 1000.0);
+	if(occluded) {
+		stats->meshesOccluded++;
+		return true;
+	}
+	return false;
+}
+// Draws the render targets on the right side of the screen
+void Renderer::DrawRenderTargets() {
+	IDirect3DDevice9* device = vvd::GetDevice();
+
+	std::list<RenderTarget*>::iterator i = RenderTarget::targets.begin();
+
+	int currentHeight = 0;
+
+	// Destination surface is the back buffer
+	IDirect3DSurface9* destSurface = RenderTarget::defaultTarget.GetSurface();
+
+	while(i != RenderTarget::targets.end() && currentHeight < (int)view.Height) {
+		RenderTarget* target = *i;
+
+		if(target->DrawToScreen()) {
+			// Scale to 1/4 the screen size
+			float scale = ((float)view.Width / 4.0f) / (float)target->GetWidth();
+
+			float width = (float)target->GetWidth() * scale; // Scale the width
+			float height = (float)target->GetHeight() * scale; // Scale the height
+
+			// Set up the rectangle to copy
+			RECT rect = {view.Width - (int)width, currentHeight, view.Width, currentHeight + (int)height};
+
+			// Copy the data to the back buffer
+			device->StretchRect(target->GetSurface(), NULL, destSurface, &rect, D3DTEXF_LINEAR);
+
+			// Add to the start height so the next render target renders below this one
+			currentHeight += (int)height;
+		}
+
+		i++;
+	}
+}
+// Sets the technique and per-frame constants and begins the effect; returns the number of passes required by the effect
+UINT Renderer::BeginEffect(Material* material, bool instanced) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	UINT numPasses = 0;
+
+	ID3DXEffect* effect = material->GetEffect();
+
+	if(instanced) {
+		if(FAILED(effect->SetTechnique(material->GetInstancedTechnique(technique))))
+			return 0;
+	} else if(technique) {
+		if(FAILED(effect->SetTechnique(technique)))
+			return 0;
+	} else {
+		D3DXHANDLE handle;
+		effect->FindNextValidTechnique(0, &handle);
+		effect->SetTechnique(handle);
+	}
+	stats->techniqueChanges++;
+
+	// Set the view projection matrix
+	D3DXMATRIX viewProj = cameraMat * projectionMat;
+	effect->SetMatrix(material->GetViewProjHandle(), &viewProj);
+
+	// Set the projection matrix
+	effect->SetMatrix(material->GetProjectionHandle(), &projectionMat);
+
+	// Set the view matrix
+	effect->SetMatrix(material->GetViewMatHandle(), &cameraMat);
+	stats->matrixUploads += 3;
+
+	// Set the camera position
+	D3DXVECTOR4 nCameraPos;
+	nCameraPos.x = cameraPos.x; nCameraPos.y = cameraPos.y; nCameraPos.z = cameraPos.z; nCameraPos.w = 1.0f;
+	effect->SetVector(material->GetCameraPosHandle(), &nCameraPos);
+	stats->vectorUploads++;
+
+	// Set the near and far planes
+	effect->SetFloat(material->GetFarPlaneHandle(), nearPlane);
+	effect->SetFloat(material->GetNearPlaneHandle(), farPlane);
+
+	// Set the depth bias
+	effect->SetFloat(material->GetDepthBiasHandle(), depthBias);
+	stats->scalarUploads += 3;
+
+	// Now we can start rendering
+	effect->Begin(&numPasses, 0);
+	stats->effectBegins++;
+
+	return numPasses;
+}
+// Sets the world matrix and lights of the item's mesh
+void Renderer::SetObject(DrawItem* item) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	Material* material = item->material;
+
+	// Set the world matrix
+	D3DXMATRIX worldMat = item->state->world;
+	item->effect->SetMatrix(material->GetWorldMatHandle(), &worldMat);
+	stats->matrixUploads++;
+
+	// Setup all the lights affecting the mesh
+	if(material->RequiresLights(technique)) {
+		CompileLightArray(item->state, material);
+	}
+}
+// Compiles the data of the strongest lights reaching the mesh and sends it to the material's effect
+void Renderer::CompileLightArray(MeshState* state, Material* material) {
+	vvd::FrameStats* stats = vvd::GetFrameStats();
+	float* lightRanges = Material::GetLightRanges();
+	D3DXVECTOR4* lightPositions = Material::GetLightPositions();
+	D3DXVECTOR4* lightColors = Material::GetLightColors();
+	D3DXVECTOR4* ambients = Material::GetAmbients();
+	IDirect3DTexture9** lightTextures = Material::GetLightTextures();
+	IDirect3DTexture9** shadowMaps = Material::GetShadowMaps();
+	D3DXMATRIX* lightTexMatrices = Material::GetLightTexMatrices();
+
+	std::vector<SceneLight*>* lights = GetStateLights(state); // Strongest first
+	std::vector<Cell*>* cells = state->cells;
+	int maxLights = min(material->MaxLights(), MAX_LIGHTS);
+	int numLights = min((int)lights->size(), maxLights);
+	ID3DXEffect* effect = material->GetEffect();
+
+	// Nothing to send if the effect already has these lights; meshes are sorted, so neighbours often share them
+	if(effect == lightEffect && *cells == effectCells && numLights == effectLightCount
+		&& GetLightingRevision() == effectLightingRevision
+		&& std::equal(lights->begin(), lights->begin() + numLights, effectLights.begin())) {
+		stats->lightArraysSkipped++;
+		return;
+	}
+
+	// Clear the arrays
+	for(int i = 0; i < MAX_LIGHTS; i++) {
+		lightTextures[i] = 0;
+		shadowMaps[i] = 0;
+	}
+
+	// This runs on the render thread for every item whose lights differ from the previous item's. The lights were
+	// ranked by the draw list jobs (or the game thread for a snapshot); only the lookup and the upload are left here
+	for(int i = 0; i < numLights; i++) {
+		LightState light;
+		GetLightState((Light*)(*lights)[i], &light);
+		// For each light, copy the range, position, and color of the light to the output arrays
+		lightRanges[i] = light.range;
+		lightPositions[i] = light.position;
+		lightColors[i].x = light.color.x; lightColors[i].y = light.color.y; lightColors[i].z = light.color.z; lightColors[i].w = 1.0f;
+		lightTextures[i] = light.light->GetTexture();
+		shadowMaps[i] = light.light->GetShadowMap();
+		lightTexMatrices[i] = light.textureMatrix;
+	}
+
+	// Set the ambient color of each cell
+	for(int i = 0; i < (int)cells->size() && i < maxLights; i++)
+		ambients[i] = (*cells)[i]->GetAmbientColor();
+
+	D3DXHANDLE lightNumHandle = material->GetLightNumHandle();
+	effect->SetInt(lightNumHandle, numLights);
+	stats->scalarUploads++;
+	material->UpdateLightArrays();
+	stats->lightArrays++;
+
+	// Remember what the effect has now
+	lightEffect = effect;
+	effectCells = *cells;
+	effectLightCount = numLights;
+	effectLightingRevision = GetLightingRevision();
+	effectLights.assign(lights->begin(), lights->begin() + numLights);
+}
+// Gets the parameters of the light in the frame being drawn
+void Renderer::GetLightState(Light* light, LightState* state) {
+	LightState* copy = snapshot ? snapshot->FindLight(light) : 0;
+	if(copy) {
+		*state = *copy;
+	} else {
+		FrameSnapshot::CaptureLight(light, state);
+	}
+}
+// Gets Light::GetLightingRevision() in the frame being drawn
+int Renderer::GetLightingRevision() {
+	if(snapshot)
+		return snapshot->lightingRevision;
+	return Light::GetLightingRevision();
+}
+bool Renderer::Contains(ImageFilter* imgfilter) {
+	std::list<ImageFilter*>::iterator i = filters.begin();
+	while(i != filters.end()) {
+		ImageFilter* nImgFilter = *i;
+		if(nImgFilter == imgfilter)
+			return true;
+		i++;
+	}
+	return false;
+}
+std::list<ImageFilter*>::iterator Renderer::GetFilter(ImageFilter* imgfilter) {
+	std::list<ImageFilter*>::iterator i = filters.begin();
+	while(i != filters.end()) {
+		ImageFilter* nImgFilter = *i;
+		if(nImgFilter == imgfilter)
+			return i;
+		i++;
+	}
+	return i;
 }
\ No newline at end of file
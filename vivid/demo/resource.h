@@ -0,0 +1,67 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef resource_h
+#define resource_h
+#include "vivid.h"
+#include <vector>
+
+#define MIN_RESOURCE_BUCKETS 64 // Starting size of the hash tables; doubled whenever they fill up
+
+enum ResourceType {
+	RESOURCE_MESH, // data is a Mesh the other meshes copy
+	RESOURCE_MATERIAL, // data is a Material the other materials copy
+	RESOURCE_EFFECT // data is a compiled ID3DXEffect the materials clone
+};
+
+// Something loaded from a file; later loads of the same file copy it instead of reading the file again
+struct Resource {
+	ResourceType type;
+	unsigned int hash; // Hash of the interned name
+	LPCSTR name; // Interned file name
+	void* data; // Owned by the cache
+	int refs; // Objects using the resource; it's freed when the last one lets go
+	Resource* next; // Next resource in the same hash bucket
+};
+
+// Finds loaded resources by file name in constant time. File names are normalized (lower case,
+// backslashes) and interned, so objects can keep the interned pointer instead of the caller's string
+class ResourceCache {
+public:
+	static LPCSTR Intern(LPCSTR name); // Gets the cache's copy of the normalized name; the same name always gets the same pointer
+	static Resource* Find(ResourceType type, LPCSTR name); // Gets the resource loaded from the file; 0 if there isn't one
+	static Resource* Add(ResourceType type, LPCSTR name, void* data); // Caches data loaded from the file, with one reference
+	static void AddRef(Resource* resource); // Adds a reference to the resource
+	static void Release(Resource* resource); // Releases a reference; frees the resource when there are none left
+	static int GetNumResources(); // Gets the number of cached resources
+	static unsigned int Hash(LPCSTR name); // FNV-1a hash of a name
+protected:
+	// Interned name; names are never freed, since objects keep pointers to them
+	struct Name {
+		unsigned int hash;
+		char* name;
+		Name* next; // Next name in the same hash bucket
+	};
+	static std::vector<Name*> names; // Hash table of interned names
+	static int numNames;
+	static std::vector<Resource*> resources; // Hash table of resources
+	static int numResources;
+	static unsigned int GetBucket(unsigned int hash, ResourceType type, size_t numBuckets); // Mixes the type into the hash
+	static void GrowNames(); // Doubles the name table
+	static void GrowResources(); // Doubles the resource table
+	static void Free(Resource* resource); // Frees the resource's data
+};
+
+#endif
\ No newline at end of file
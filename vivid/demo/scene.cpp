@@ -0,0 +1,314 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "scene.h"
+#include "cell.h"
+#include <algorithm>
+
+// Static lists of meshes and lights; used in World
+std::list<SceneMesh*> SceneMesh::meshes;
+std::list<SceneLight*> SceneLight::lights;
+int SceneLight::lightingRevision = 0;
+
+SceneMesh::SceneMesh() {
+	center = Vector3(0.0f, 0.0f, 0.0f);
+	radius = 0.0f;
+	cellRevision = -1;
+	lightsRevision = -1;
+	lightingRevision = -1;
+}
+SceneMesh::SceneMesh(const SceneMesh& mesh) {
+	transform = mesh.transform;
+	center = mesh.center;
+	radius = mesh.radius;
+	cellRevision = -1; // The copy isn't in any cell until the World assigns it
+	lightsRevision = -1;
+	lightingRevision = -1;
+}
+SceneMesh::~SceneMesh() {
+	// Take this mesh out of its cells so they don't hold a stray pointer
+	std::vector<Cell*> oldCells = cells;
+	for(int i = 0; i < (int)oldCells.size(); i++)
+		oldCells[i]->RemoveMesh(this);
+	cells.clear();
+	meshes.remove(this); // Erase this object from the list so we don't have a stray pointer in the mesh list
+}
+// Sets the bounding sphere, relative to the transform
+void SceneMesh::SetBounds(Vector3 nCenter, float nRadius) {
+	center = nCenter;
+	radius = nRadius;
+	cellRevision = -1; // The World has to find its cells again
+	lightsRevision = -1;
+}
+// Gets the list of cells this mesh is inside
+std::vector<Cell*>* SceneMesh::GetCells() {
+	return &cells;
+}
+// Gets the lights reaching the mesh from its cells, strongest first; at most MAX_LIGHTS
+std::vector<SceneLight*>* SceneMesh::GetLights() {
+	if(LightsChanged())
+		SelectLights();
+	return &lights;
+}
+// Returns true if the lights have to be selected again
+bool SceneMesh::LightsChanged() {
+	if(lightsRevision != transform.GetRevision())
+		return true;
+	// Only the lights in the mesh's own cells matter; changes anywhere else leave the selection alone
+	for(int i = 0; i < (int)cells.size(); i++) {
+		if(cells[i]->GetLightsRevision() > lightingRevision)
+			return true;
+	}
+	return false;
+}
+// Returns how much the light lights the mesh's bounding sphere; 0 if it doesn't reach it
+static float GetLightInfluence(SceneLight* light, Vector3* center, float radius) {
+	// Brightness of the light color
+	Vector3 color = light->GetColor();
+	float intensity = color.Dot(Vector3(0.299f, 0.587f, 0.114f));
+
+	Vector4 pos = light->GetPosition();
+	if(pos.w == 0.0f)
+		return intensity; // Directional lights don't fall off
+
+	// Attenuate by the distance to the nearest point of the bounding sphere, the same way the shaders do
+	float range = light->GetRange();
+	float distance = Max((pos.XYZ() - *center).Length() - radius, 0.0f);
+	if(range <= 0.0f || distance >= range)
+		return 0.0f;
+	return intensity * (1.0f - (distance / range));
+}
+// Orders lights by influence, strongest first
+static bool CompareInfluence(const std::pair<float, SceneLight*>& a, const std::pair<float, SceneLight*>& b) {
+	if(a.first != b.first)
+		return a.first > b.first;
+	return a.second < b.second; // Keep the order stable between frames
+}
+// Ranks the lights in the mesh's cells by how much they light the mesh and keeps the strongest
+void SceneMesh::SelectLights() {
+	Vector3 worldCenter = GetWorldCenter();
+	float worldRadius = GetRadius();
+
+	// Gather every light in the cells once
+	std::vector<std::pair<float, SceneLight*> > candidates;
+	for(int i = 0; i < (int)cells.size(); i++) {
+		std::vector<SceneLight*>* cellLights = cells[i]->GetLights();
+		for(int j = 0; j < (int)cellLights->size(); j++) {
+			SceneLight* light = (*cellLights)[j];
+			bool found = false;
+			for(int k = 0; k < (int)candidates.size(); k++) {
+				if(candidates[k].second == light) {
+					found = true;
+					break;
+				}
+			}
+			if(found)
+				continue;
+			float influence = GetLightInfluence(light, &worldCenter, worldRadius);
+			if(influence > 0.0f)
+				candidates.push_back(std::pair<float, SceneLight*>(influence, light));
+		}
+	}
+
+	// Keep the strongest
+	int count = Min((int)candidates.size(), MAX_LIGHTS);
+	std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), CompareInfluence);
+	lights.clear();
+	for(int i = 0; i < count; i++)
+		lights.push_back(candidates[i].second);
+
+	lightsRevision = transform.GetRevision();
+	lightingRevision = SceneLight::GetLightingRevision();
+	vvd::GetFrameStats()->lightSelections++;
+}
+// Adds a cell to the list of cells this mesh is inside
+void SceneMesh::AddCell(Cell* cell) {
+	cells.push_back(cell);
+	lightsRevision = -1;
+}
+// Clears the list of cells this mesh is inside
+void SceneMesh::ClearCells() {
+	cells.clear();
+	lightsRevision = -1;
+}
+// Removes a cell from the list of cells this mesh is inside
+void SceneMesh::RemoveCell(Cell* cell) {
+	for(int i = 0; i < (int)cells.size(); i++) {
+		if(cells[i] == cell) {
+			cells.erase(cells.begin() + i);
+			lightsRevision = -1;
+			return;
+		}
+	}
+}
+// Gets the transform revision the mesh was last assigned to a cell with
+int SceneMesh::GetCellRevision() {
+	return cellRevision;
+}
+// Sets the transform revision the mesh was last assigned to a cell with
+void SceneMesh::SetCellRevision(int revision) {
+	cellRevision = revision;
+}
+// Gets the center of the mesh
+Vector3 SceneMesh::GetCenter() {
+	return center;
+}
+// Gets the center of the mesh in world space
+Vector3 SceneMesh::GetWorldCenter() {
+	return transform.GetMatrix().TransformCoord(center);
+}
+// Gets the distance from the center to the outermost vertex of the mesh
+float SceneMesh::GetRadius() {
+	// The row lengths of the world matrix include the scaling of any parents
+	Matrix worldMat = transform.GetMatrix();
+	return radius * Max(Max(worldMat.GetRow(0).Length(), worldMat.GetRow(1).Length()), worldMat.GetRow(2).Length());
+}
+
+SceneLight::SceneLight() {
+	range = 0.0f;
+	position = Vector4(0.0f, 0.0f, 0.0f, 1.0f);
+	positionW = 1.0f;
+	positionRevision = transform.GetRevision();
+	color = Vector3(1.0f, 1.0f, 1.0f);
+	revision = 0;
+	cellRevision = -1;
+	shadowRevision = 0;
+	lights.push_back(this);
+	lightingRevision++;
+}
+SceneLight::SceneLight(const SceneLight& light) {
+	color = light.color;
+	position = light.position;
+	positionW = light.positionW;
+	range = light.range;
+	transform = light.transform;
+	positionRevision = transform.GetRevision();
+	revision = 0;
+	cellRevision = -1; // The copy isn't in any cell
+	shadowRevision = light.shadowRevision;
+}
+SceneLight::~SceneLight() {
+	// Take this light out of its cells so they don't hold a stray pointer
+	std::vector<Cell*> oldCells = cells;
+	for(int i = 0; i < (int)oldCells.size(); i++)
+		oldCells[i]->RemoveLight(this);
+	cells.clear();
+	lights.remove(this); // Erase this light from the static light list
+	lightingRevision++;
+}
+// Sets the range of the light
+void SceneLight::SetRange(float nRange) {
+	if(range != nRange) {
+		shadowRevision++;
+		range = nRange;
+		Changed();
+	}
+}
+// Gets the range
+float SceneLight::GetRange() {
+	return range;
+}
+// Sets the color of the light
+void SceneLight::SetColor(float r, float g, float b) {
+	if(color.x != r || color.y != g || color.z != b) {
+		color.x = r; color.y = g; color.z = b;
+		Changed();
+	}
+}
+// Gets the color
+Vector3 SceneLight::GetColor() {
+	return color;
+}
+// Sets the position of the light relative to the parent of its transform; make W 0.0f if you want the light to be directional
+void SceneLight::SetPosition(float x, float y, float z, float w) {
+	transform.SetPosition(x, y, z);
+	positionW = w;
+	UpdatePosition();
+}
+// Gets the position in world space
+Vector4 SceneLight::GetPosition() {
+	return position;
+}
+// Computes the position from the transform; a change moves the light
+void SceneLight::UpdatePosition() {
+	// A directional light's position is a direction, so the parent doesn't move it
+	Vector3 pos = positionW == 0.0f ? transform.GetPosition() : transform.GetWorldPosition();
+	positionRevision = transform.GetRevision();
+	if(position.x != pos.x || position.y != pos.y || position.z != pos.z || position.w != positionW) {
+		position.x = pos.x; position.y = pos.y; position.z = pos.z; position.w = positionW;
+		shadowRevision++;
+		Changed();
+	}
+}
+// Bumps the revisions and tells the light's cells after it moved, changed range or was recolored
+void SceneLight::Changed() {
+	revision++;
+	lightingRevision++;
+	for(int i = 0; i < (int)cells.size(); i++)
+		cells[i]->LightChanged();
+}
+// Picks up the lights that moved through their transforms or the parents of their transforms
+void SceneLight::UpdateLights() {
+	std::list<SceneLight*>::iterator i = lights.begin();
+	while(i != lights.end()) {
+		// Rotating the texture changes the revision too, but UpdatePosition() only moves the light if the position changed
+		if((*i)->transform.GetRevision() != (*i)->positionRevision)
+			(*i)->UpdatePosition();
+		i++;
+	}
+}
+// Clears the list of cells this light affects
+void SceneLight::ClearCells() {
+	cells.clear();
+	lightingRevision++;
+}
+// Adds the specified cell to the list of cells this light affects
+void SceneLight::AddCell(Cell* cell) {
+	cells.push_back(cell);
+	lightingRevision++;
+}
+// Removes a cell from the list of cells this light affects
+void SceneLight::RemoveCell(Cell* cell) {
+	for(int i = 0; i < (int)cells.size(); i++) {
+		if(cells[i] == cell) {
+			cells.erase(cells.begin() + i);
+			lightingRevision++;
+			return;
+		}
+	}
+}
+// Gets the list of cells this light affects
+std::vector<Cell*>* SceneLight::GetCells() {
+	return &cells;
+}
+// Gets a number that changes whenever the light moves, changes range or is recolored
+int SceneLight::GetRevision() {
+	return revision;
+}
+// Gets the revision the light was last assigned to cells with
+int SceneLight::GetCellRevision() {
+	return cellRevision;
+}
+// Sets the revision the light was last assigned to cells with
+void SceneLight::SetCellRevision(int nRevision) {
+	cellRevision = nRevision;
+}
+// Gets a number that changes whenever the light moves, changes range or its shadow map is invalidated
+int SceneLight::GetShadowRevision() {
+	return shadowRevision;
+}
+// Gets a number that changes whenever any light changes
+int SceneLight::GetLightingRevision() {
+	return lightingRevision;
+}
\ No newline at end of file
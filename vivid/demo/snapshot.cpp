@@ -0,0 +1,107 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "snapshot.h"
+#include "jobs.h"
+#include <algorithm>
+#include <functional>
+
+FrameSnapshot::FrameSnapshot() {
+	lightingRevision = 0;
+	cameraPos = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	cameraLook = D3DXVECTOR3(0.0f, 0.0f, 1.0f);
+	cameraUp = D3DXVECTOR3(0.0f, 1.0f, 0.0f);
+	frame = -1;
+	inputTime = 0.0;
+	presentTime = 0.0;
+	latencyFrames = 0;
+	memset(&stats, 0, sizeof(stats));
+}
+// Copies the scene out of the live meshes and lights
+void FrameSnapshot::Capture() {
+	// Propagate parent transforms first, so the jobs only read the parents of their meshes
+	Transform::UpdateHierarchy();
+	Light::UpdateLights();
+
+	// Meshes still being loaded aren't drawn
+	sourceMeshes.clear();
+	std::list<SceneMesh*>::iterator i = Mesh::meshes.begin();
+	while(i != Mesh::meshes.end()) {
+		Mesh* mesh = (Mesh*)*i;
+		if(mesh->IsLoaded())
+			sourceMeshes.push_back(mesh);
+		i++;
+	}
+	meshes.resize(sourceMeshes.size());
+	vvd::ParallelFor((int)sourceMeshes.size(), 0, CaptureMeshes, this);
+
+	lights.resize(Light::lights.size());
+	std::list<SceneLight*>::iterator j = Light::lights.begin();
+	for(int k = 0; j != Light::lights.end(); j++, k++)
+		CaptureLight((Light*)*j, &lights[k]);
+	std::sort(lights.begin(), lights.end(), CompareLightStates); // For FindLight()
+	lightingRevision = Light::GetLightingRevision();
+}
+// Copies sourceMeshes[first, last)
+void FrameSnapshot::CaptureMeshes(void* nSnapshot, int first, int last) {
+	FrameSnapshot* snapshot = (FrameSnapshot*)nSnapshot;
+	for(int i = first; i < last; i++) {
+		MeshSnapshot* copy = &snapshot->meshes[i];
+		// The mesh's lights are ranked here, on the game thread, so the render thread only sends them
+		CaptureMesh(snapshot->sourceMeshes[i], &copy->state, true);
+		copy->cells = *copy->state.cells;
+		copy->lights = *copy->state.lights;
+		copy->state.cells = &copy->cells;
+		copy->state.lights = &copy->lights;
+	}
+}
+// Sets the camera the frame is drawn from
+void FrameSnapshot::SetCamera(D3DXVECTOR3* nCameraPos, D3DXVECTOR3* nCameraLook, D3DXVECTOR3* nCameraUp) {
+	cameraPos = *nCameraPos;
+	cameraLook = *nCameraLook;
+	cameraUp = *nCameraUp;
+}
+// Orders light states by the address of their light
+bool FrameSnapshot::CompareLightStates(const LightState& a, const LightState& b) {
+	return std::less<Light*>()(a.light, b.light);
+}
+// Gets the state of a light; the render thread looks up every light it sends, so the sorted lights are searched by halves
+LightState* FrameSnapshot::FindLight(Light* light) {
+	LightState key;
+	key.light = light;
+	std::vector<LightState>::iterator i = std::lower_bound(lights.begin(), lights.end(), key, CompareLightStates);
+	if(i == lights.end() || i->light != light)
+		return 0;
+	return &(*i);
+}
+// Copies the state of a live mesh
+void FrameSnapshot::CaptureMesh(Mesh* mesh, MeshState* state, bool getLights) {
+	state->mesh = mesh;
+	state->world = mesh->transform.GetMatrix();
+	state->center = mesh->GetWorldCenter();
+	state->radius = mesh->GetRadius();
+	state->revision = mesh->transform.GetRevision();
+	state->occluder = mesh->IsOccluder();
+	state->cells = mesh->GetCells();
+	state->lights = getLights ? mesh->GetLights() : 0;
+}
+// Copies the state of a live light
+void FrameSnapshot::CaptureLight(Light* light, LightState* state) {
+	state->light = light;
+	state->position = light->GetPosition();
+	state->color = light->GetColor();
+	state->range = light->GetRange();
+	state->textureMatrix = light->GetTextureMatrix();
+	state->shadowRevision = light->GetShadowRevision();
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef snapshot_h
+#define snapshot_h
+#include "mesh.h"
+#include "light.h"
+
+// Everything the Renderer reads about a mesh while drawing it. The Renderer copies it out of the live meshes
+// as it draws them; a FrameSnapshot keeps its own copies, so one frame can be drawn while the next one is simulated
+struct MeshState {
+	Mesh* mesh;
+	Matrix world; // World matrix
+	Vector3 center; // Center of the bounding sphere in world space
+	float radius; // Radius of the bounding sphere
+	int revision; // Revision of the mesh's transform; for shadow caching
+	bool occluder; // True if the mesh is drawn into the occlusion buffer
+	std::vector<Cell*>* cells; // The cells the mesh is inside
+	std::vector<SceneLight*>* lights; // The strongest lights reaching the mesh, strongest first
+};
+
+// Everything the Renderer reads about a light while drawing it
+struct LightState {
+	Light* light;
+	D3DXVECTOR4 position; // W is 0 for directional lights
+	D3DXVECTOR3 color;
+	float range;
+	D3DXMATRIX textureMatrix; // Texture rotation
+	int shadowRevision; // Light::GetShadowRevision()
+};
+
+// A mesh state with its own copies of the cell and light lists
+struct MeshSnapshot {
+	MeshState state; // Points at the lists below
+	std::vector<Cell*> cells;
+	std::vector<SceneLight*> lights;
+};
+
+// Immutable copy of a frame's scene for a render thread: the transforms, the light parameters and the cell
+// assignments of every loaded mesh and light, and the camera. It's captured on the game thread once the frame
+// has been simulated; the meshes, materials and lights it points at must stay alive until it's drawn
+class FrameSnapshot {
+public:
+	FrameSnapshot();
+	// Copies the scene out of the live meshes and lights; call it after World::Update(). Uses the job threads
+	void Capture();
+	// Sets the camera the frame is drawn from; look is a direction, like Renderer::SetCameraRotation()
+	void SetCamera(D3DXVECTOR3* nCameraPos, D3DXVECTOR3* nCameraLook, D3DXVECTOR3* nCameraUp);
+	LightState* FindLight(Light* light); // Gets the state of a light; 0 if it isn't in the snapshot
+	// Copies the state of a live mesh; lights are left 0 unless getLights is true, since ranking them isn't free
+	static void CaptureMesh(Mesh* mesh, MeshState* state, bool getLights);
+	static void CaptureLight(Light* light, LightState* state); // Copies the state of a live light
+	std::vector<MeshSnapshot> meshes; // Every loaded mesh
+	std::vector<LightState> lights; // Every light, sorted by the address of the Light
+	int lightingRevision; // Light::GetLightingRevision()
+	D3DXVECTOR3 cameraPos; // Position of the camera
+	D3DXVECTOR3 cameraLook; // Direction the camera points in
+	D3DXVECTOR3 cameraUp; // Up direction of the camera
+	int frame; // Number of the game frame that captured it; -1 if it hasn't been captured
+	double inputTime; // vvd::GetInputTime() when it was captured
+	double presentTime; // vvd::GetTime() when the render thread finished drawing it
+	int latencyFrames; // Frames submitted from this one to when it was drawn, this one included
+	vvd::FrameStats stats; // Counted by the render thread while drawing it
+protected:
+	static void CaptureMeshes(void* snapshot, int first, int last); // Copies sourceMeshes[first, last); a job
+	static bool CompareLightStates(const LightState& a, const LightState& b); // Orders light states by the address of their light
+	std::vector<Mesh*> sourceMeshes; // The meshes being captured
+private:
+	FrameSnapshot(const FrameSnapshot&); // Snapshots point into themselves
+	FrameSnapshot& operator=(const FrameSnapshot&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "spatialindex.h"
+
+SpatialIndex::~SpatialIndex() {}
+// Returns true if the sphere overlaps the axis aligned box
+bool SpatialIndex::SphereIntersectsBox(Vector3* center, float radius, Vector3* boxMin, Vector3* boxMax) {
+	// Find the point in the box closest to the center of the sphere
+	Vector3 closest;
+	closest.x = Max(boxMin->x, Min(center->x, boxMax->x));
+	closest.y = Max(boxMin->y, Min(center->y, boxMax->y));
+	closest.z = Max(boxMin->z, Min(center->z, boxMax->z));
+	Vector3 diff = closest - *center;
+	return diff.LengthSq() <= radius * radius;
+}
+// Returns true if the ray hits the box before it has traveled the specified length
+bool SpatialIndex::RayIntersectsBox(Vector3* origin, Vector3* direction, float length, Vector3* boxMin, Vector3* boxMax) {
+	// Slab test; clip the segment against each pair of planes
+	float nearT = 0.0f;
+	float farT = length;
+	float o[3] = {origin->x, origin->y, origin->z};
+	float d[3] = {direction->x, direction->y, direction->z};
+	float bmin[3] = {boxMin->x, boxMin->y, boxMin->z};
+	float bmax[3] = {boxMax->x, boxMax->y, boxMax->z};
+	for(int i = 0; i < 3; i++) {
+		if(fabs(d[i]) < 1e-6f) {
+			// Parallel to the slab; miss unless the origin is between the planes
+			if(o[i] < bmin[i] || o[i] > bmax[i])
+				return false;
+		} else {
+			float t1 = (bmin[i] - o[i]) / d[i];
+			float t2 = (bmax[i] - o[i]) / d[i];
+			if(t1 > t2) {
+				float t = t1; t1 = t2; t2 = t;
+			}
+			nearT = Max(nearT, t1);
+			farT = Min(farT, t2);
+			if(nearT > farT)
+				return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
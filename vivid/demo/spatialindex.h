@@ -0,0 +1,47 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef spatialindex_h
+#define spatialindex_h
+#include "vmath.h"
+#include "frustum.h"
+#include <vector>
+#include <float.h>
+
+struct Cell;
+
+// Divides space into Cells for the World; the World asks it which cells each mesh and light is inside
+// Implemented by UniformGrid and Octree
+class SpatialIndex {
+public:
+	virtual ~SpatialIndex();
+	// Gets every cell overlapped by the bounding box of the sphere; creates cells that don't exist yet
+	// Anything outside the indexed space goes in the cells along the edge
+	virtual void GetCells(Vector3 center, float radius, std::vector<Cell*>* cells) = 0;
+	virtual Cell* GetCell(Vector3 pos) = 0; // Gets the cell at the position specified; creates it if it doesn't exist yet
+	virtual void GetAllCells(std::vector<Cell*>* cells) = 0; // Gets every cell that exists
+	virtual int GetNumCells() = 0; // Gets the number of cells that exist; cells are never removed, so it only grows
+	// The queries only return cells that already exist
+	virtual void QuerySphere(Vector3 center, float radius, std::vector<Cell*>* cells) = 0; // Gets the cells touching the sphere
+	virtual void QueryFrustum(Frustum* frustum, std::vector<Cell*>* cells) = 0; // Gets the cells at least partially inside the frustum
+	// Gets the cells the ray passes through before it has traveled the specified length; the direction must be normalized
+	virtual void QueryRay(Vector3 origin, Vector3 direction, float length, std::vector<Cell*>* cells) = 0;
+protected:
+	static bool SphereIntersectsBox(Vector3* center, float radius, Vector3* boxMin, Vector3* boxMax); // Sphere/box overlap test
+	// Returns true if the ray hits the box before it has traveled the specified length
+	static bool RayIntersectsBox(Vector3* origin, Vector3* direction, float length, Vector3* boxMin, Vector3* boxMax);
+};
+
+#endif
\ No newline at end of file
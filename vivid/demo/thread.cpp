@@ -0,0 +1,180 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "thread.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#include <sched.h>
+#endif
+
+// Adds to the value in one step no other thread can interrupt; returns the new value
+long AtomicAdd(volatile long* value, long amount) {
+#ifdef _WIN32
+	return InterlockedExchangeAdd(value, amount) + amount;
+#else
+	return __sync_add_and_fetch(value, amount);
+#endif
+}
+Mutex::Mutex() {
+#ifdef _WIN32
+	InitializeCriticalSection(&section);
+#else
+	pthread_mutex_init(&mutex, 0);
+#endif
+}
+Mutex::~Mutex() {
+#ifdef _WIN32
+	DeleteCriticalSection(&section);
+#else
+	pthread_mutex_destroy(&mutex);
+#endif
+}
+// Waits until no other thread holds the lock, then takes it
+void Mutex::Lock() {
+#ifdef _WIN32
+	EnterCriticalSection(&section);
+#else
+	pthread_mutex_lock(&mutex);
+#endif
+}
+// Releases the lock
+void Mutex::Unlock() {
+#ifdef _WIN32
+	LeaveCriticalSection(&section);
+#else
+	pthread_mutex_unlock(&mutex);
+#endif
+}
+Semaphore::Semaphore() {
+#ifdef _WIN32
+	semaphore = CreateSemaphore(0, 0, 0x7FFFFFFF, 0);
+#else
+	pthread_mutex_init(&mutex, 0);
+	pthread_cond_init(&condition, 0);
+	count = 0;
+#endif
+}
+Semaphore::~Semaphore() {
+#ifdef _WIN32
+	CloseHandle(semaphore);
+#else
+	pthread_cond_destroy(&condition);
+	pthread_mutex_destroy(&mutex);
+#endif
+}
+// Wakes up to count waiting threads
+void Semaphore::Signal(int nCount) {
+#ifdef _WIN32
+	ReleaseSemaphore(semaphore, nCount, 0);
+#else
+	pthread_mutex_lock(&mutex);
+	count += nCount;
+	if(nCount == 1)
+		pthread_cond_signal(&condition);
+	else
+		pthread_cond_broadcast(&condition);
+	pthread_mutex_unlock(&mutex);
+#endif
+}
+// Sleeps until the count is above zero, then decrements it
+void Semaphore::Wait() {
+#ifdef _WIN32
+	WaitForSingleObject(semaphore, INFINITE);
+#else
+	pthread_mutex_lock(&mutex);
+	while(count == 0)
+		pthread_cond_wait(&condition, &mutex);
+	count--;
+	pthread_mutex_unlock(&mutex);
+#endif
+}
+Thread::Thread() {
+	function = 0;
+	data = 0;
+	running = false;
+#ifdef _WIN32
+	thread = 0;
+#endif
+}
+Thread::~Thread() {
+	Join();
+}
+// Runs function(data) on a new thread; returns false if it can't be created
+bool Thread::Start(ThreadFunction nFunction, void* nData) {
+	if(running)
+		return false;
+	function = nFunction;
+	data = nData;
+#ifdef _WIN32
+	// _beginthreadex rather than CreateThread so the C runtime is set up for the thread
+	thread = (HANDLE)_beginthreadex(0, 0, Run, this, 0, 0);
+	running = thread != 0;
+#else
+	running = pthread_create(&thread, 0, Run, this) == 0;
+#endif
+	return running;
+}
+// Waits for the thread to finish
+void Thread::Join() {
+	if(!running)
+		return;
+#ifdef _WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+	thread = 0;
+#else
+	pthread_join(thread, 0);
+#endif
+	running = false;
+}
+// Returns true if the thread was started and hasn't been joined
+bool Thread::IsRunning() {
+	return running;
+}
+// Gets the number of hardware threads
+int Thread::GetNumProcessors() {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+#endif
+}
+// Lets another thread run on this processor
+void Thread::YieldTimeSlice() {
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+// Calls the entry point
+#ifdef _WIN32
+unsigned __stdcall Thread::Run(void* nThread) {
+	Thread* thread = (Thread*)nThread;
+	thread->function(thread->data);
+	return 0;
+}
+#else
+void* Thread::Run(void* nThread) {
+	Thread* thread = (Thread*)nThread;
+	thread->function(thread->data);
+	return 0;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef thread_h
+#define thread_h
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef _WIN32
+#define VVD_THREAD_LOCAL __declspec(thread) // Gives every thread its own copy of a static variable
+#else
+#define VVD_THREAD_LOCAL __thread
+#endif
+
+typedef void (*ThreadFunction)(void* data); // Entry point of a thread
+
+long AtomicAdd(volatile long* value, long amount); // Adds to the value in one step no other thread can interrupt; returns the new value
+
+// Lock for data shared between threads
+class Mutex {
+public:
+	Mutex();
+	~Mutex();
+	void Lock(); // Waits until no other thread holds the lock, then takes it
+	void Unlock(); // Releases the lock
+protected:
+#ifdef _WIN32
+	CRITICAL_SECTION section;
+#else
+	pthread_mutex_t mutex;
+#endif
+private:
+	Mutex(const Mutex&); // Locks can't be copied
+	Mutex& operator=(const Mutex&);
+};
+
+// Holds a mutex until it goes out of scope
+class ScopedLock {
+public:
+	ScopedLock(Mutex* nMutex) { mutex = nMutex; mutex->Lock(); }
+	~ScopedLock() { mutex->Unlock(); }
+protected:
+	Mutex* mutex;
+private:
+	ScopedLock(const ScopedLock&);
+	ScopedLock& operator=(const ScopedLock&);
+};
+
+// Counter threads can sleep on until another thread signals it
+class Semaphore {
+public:
+	Semaphore();
+	~Semaphore();
+	void Signal(int count = 1); // Wakes up to count waiting threads
+	void Wait(); // Sleeps until the count is above zero, then decrements it
+protected:
+#ifdef _WIN32
+	HANDLE semaphore;
+#else
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+	int count;
+#endif
+private:
+	Semaphore(const Semaphore&);
+	Semaphore& operator=(const Semaphore&);
+};
+
+// Operating system thread
+class Thread {
+public:
+	Thread();
+	~Thread(); // Waits for the thread to finish
+	bool Start(ThreadFunction function, void* data); // Runs function(data) on a new thread; returns false if it can't be created
+	void Join(); // Waits for the thread to finish
+	bool IsRunning(); // Returns true if the thread was started and hasn't been joined
+	static int GetNumProcessors(); // Gets the number of hardware threads
+	static void YieldTimeSlice(); // Lets another thread run on this processor; for spin waits
+protected:
+	ThreadFunction function; // Entry point
+	void* data; // Passed to the entry point
+	bool running; // True between Start() and Join()
+#ifdef _WIN32
+	HANDLE thread;
+	static unsigned __stdcall Run(void* thread); // Calls the entry point
+#else
+	pthread_t thread;
+	static void* Run(void* thread); // Calls the entry point
+#endif
+private:
+	Thread(const Thread&);
+	Thread& operator=(const Thread&);
+};
+
+#endif
\ No newline at end of file
@@ -1,156 +1,398 @@
-// Vivid Engine v0.01
-// Copyright (C) 2006 Evan Todd
-
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// version 2 as published by the Free Software Foundation.
-
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-// GNU General Public License (included in README.txt) for more details.
-
-// You can contact the author at evanofsky@sbcglobal.net.
-
-#include "transform.h"
-
-Transform::Transform() {
-	position.x = 0.0f; position.y = 0.0f; position.z = 0.0f;
-	rotation.x = 0.0f; rotation.y = 0.0f; rotation.z = 0.0f;
-	scale.x = 1.0f; scale.y = 1.0f; scale.z = 1.0f;
-}
-Transform::Transform(float x, float y, float z) {
-	position.x = x; position.y = y; position.z = z;
-	rotation.x = 0.0f; rotation.y = 0.0f; rotation.z = 0.0f;
-	scale.x = 1.0f; scale.y = 1.0f; scale.z = 1.0f;
-}
-Transform::Transform(float x, float y, float z, float rx, float ry, float rz) {
-	position.x = x; position.y = y; position.z = z;
-	rotation.x = rx; rotation.y = ry; rotation.z = rz;
-	scale.x = 1.0f; scale.y = 1.0f; scale.z = 1.0f;
-}
-Transform::Transform(const Transform& transform) {
-	position = transform.position;
-	rotation = transform.rotation;
-	scale = transform.scale;
-}
-Transform::~Transform() {}
-// Gets the position of the transform
-D3DXVECTOR3 Transform::GetPosition() {
-	return position;
-}
-// Gets the rotation of the transform
-D3DXVECTOR3 Transform::GetRotation() {
-	return rotation;
-}
-// Gets the scaling of the transform
-D3DXVECTOR3 Transform::GetScale() {
-	return scale;
-}
-// Sets the position of the transform
-void Transform::SetPosition(D3DXVECTOR3* nPosition) {
-	position = *nPosition;
-}
-// Sets the rotation of the transform
-void Transform::SetRotation(D3DXVECTOR3* nRotation) {
-	rotation = *nRotation;
-}
-// Sets the scaling of the transform
-void Transform::SetScale(D3DXVECTOR3* nScale) {
-	scale = *nScale;
-}
-// Sets the position of the transform
-void Transform::SetPosition(float x, float y, float z) {
-	position.x = x; position.y = y; position.z = z;
-}
-// Sets the rotation of the transform
-void Transform::SetRotation(float rx, float ry, float rz) {
-	rotation.x = rx; rotation.y = ry; rotation.z = rz;
-}
-// Sets the scaling of the transform
-void Transform::SetScale(float sx, float sy, float sz) {
-	scale.x = sx; scale.y = sy; scale.z = sz;
-}
-// Adds the specified vector to the position
-void Transform::AddPosition(D3DXVECTOR3* nPosition) {
-	position += *nPosition;
-}
-// Adds the specified vector to the position relative to the transform's rotation
-void Transform::AddPositionRelative(D3DXVECTOR3* nPosition) {
-	position += GetRightVector() * nPosition->x; position += GetUpVector() * nPosition->y; position += GetLookVector() * nPosition->z;
-}
-// Adds the specified vector to the rotation
-void Transform::AddRotation(D3DXVECTOR3* nRotation) {
-	rotation += *nRotation;
-}
-// Adds the specified vector to the scaling
-void Transform::AddScale(D3DXVECTOR3* nScale) {
-	scale += *nScale;
-}
-// Adds the specified values to the position
-void Transform::AddPosition(float x, float y, float z) {
-	position.x += x; position.y += y; position.z += z;
-}
-// Adds the specified values to the position relative to the transform's rotation
-void Transform::AddPositionRelative(float x, float y, float z) {
-	position += GetRightVector() * x; position += GetUpVector() * y; position += GetLookVector() * z;
-}
-// Adds the specified values to the rotation
-void Transform::AddRotation(float rx, float ry, float rz) {
-	rotation.x += rx; rotation.y += ry; rotation.z += rz;
-}
-// Adds the specified values to the scaling
-void Transform::AddScale(float sx, float sy, float sz) {
-	scale.x += sx; scale.y += sy; scale.z += sz;
-}
-// Gets the look vector of the transform for view matrix generation
-D3DXVECTOR3 Transform::GetLookVector() {
-	D3DXVECTOR3 look(0.0f, 0.0f, 1.0f);
-	D3DXMATRIX rotation = GetRotationMatrix();
-	D3DXVec3TransformCoord(&look, &look, &rotation);
-	return look;
-}
-// Gets the up vector of the transform for view matrix generation
-D3DXVECTOR3 Transform::GetUpVector() {
-	D3DXVECTOR3 up(0.0f, 1.0f, 0.0f);
-	D3DXMATRIX rotation = GetRotationMatrix();
-	D3DXVec3TransformCoord(&up, &up, &rotation);
-	return up;
-}
-// Gets the right vector of the transform for view matrix generation
-D3DXVECTOR3 Transform::GetRightVector() {
-	D3DXVECTOR3 right(1.0f, 0.0f, 0.0f);
-	D3DXMATRIX rotation = GetRotationMatrix();
-	D3DXVec3TransformCoord(&right, &right, &rotation);
-	return right;
-}
-// Gets the rotation matrix of the transform
-D3DXMATRIX Transform::GetRotationMatrix() {
-	D3DXMATRIX rot, mrz, mrx, mry;
-	D3DXMatrixRotationZ(&mrz, rotation.z);
-	D3DXMatrixRotationX(&mrx, rotation.x);
-	D3DXMatrixRotationY(&mry, rotation.y);
-	rot = mrz * mrx * mry;
-	return rot;
-}
-// Gets the matrix of the transform
-D3DXMATRIX Transform::GetMatrix() {
-	D3DXMATRIX mat, sca, rot, trans;
-
-	D3DXMatrixIdentity(&sca);
-	D3DXMatrixIdentity(&rot);
-	D3DXMatrixIdentity(&trans);
-
-	D3DXMatrixScaling(&sca, scale.x, scale.y, scale.z);
-
-	D3DXMATRIX mrz, mrx, mry;
-	D3DXMatrixRotationZ(&mrz, rotation.z);
-	D3DXMatrixRotationX(&mrx, rotation.x);
-	D3DXMatrixRotationY(&mry, rotation.y);
-	rot = mrz * mrx * mry;
-
-	D3DXMatrixTranslation(&trans, position.x, position.y, position.z);
-
-	mat = rot * sca * trans;
-	return mat;
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "transform.h"
+#include <algorithm>
+
+int Transform::lastRevision = 0;
+std::vector<Transform*> Transform::hierarchy;
+bool Transform::hierarchySorted = true;
+
+Transform::Transform() {
+	position.x = 0.0f; position.y = 0.0f; position.z = 0.0f;
+	rotation.x = 0.0f; rotation.y = 0.0f; rotation.z = 0.0f;
+	scale.x = 1.0f; scale.y = 1.0f; scale.z = 1.0f;
+	parent = 0; parentRevision = 0; depth = 0; inHierarchy = false;
+	orientation = Quaternion::Identity(); quaternion = false; eulerDirty = false;
+	RotationModified();
+}
+Transform::Transform(float x, float y, float z) {
+	position.x = x; position.y = y; position.z = z;
+	rotation.x = 0.0f; rotation.y = 0.0f; rotation.z = 0.0f;
+	scale.x = 1.0f; scale.y = 1.0f; scale.z = 1.0f;
+	parent = 0; parentRevision = 0; depth = 0; inHierarchy = false;
+	orientation = Quaternion::Identity(); quaternion = false; eulerDirty = false;
+	RotationModified();
+}
+Transform::Transform(float x, float y, float z, float rx, float ry, float rz) {
+	position.x = x; position.y = y; position.z = z;
+	rotation.x = rx; rotation.y = ry; rotation.z = rz;
+	scale.x = 1.0f; scale.y = 1.0f; scale.z = 1.0f;
+	parent = 0; parentRevision = 0; depth = 0; inHierarchy = false;
+	orientation = Quaternion::Identity(); quaternion = false; eulerDirty = false;
+	RotationModified();
+}
+Transform::Transform(const Transform& transform) {
+	parent = 0; parentRevision = 0; depth = 0; inHierarchy = false;
+	*this = transform;
+}
+Transform::~Transform() {
+	if(parent) {
+		std::vector<Transform*>::iterator i = std::find(parent->children.begin(), parent->children.end(), this);
+		if(i != parent->children.end())
+			parent->children.erase(i);
+	}
+	// Orphaned children keep their local values, which are now relative to the world
+	for(unsigned int i = 0; i < children.size(); i++) {
+		children[i]->parent = 0;
+		children[i]->UpdateDepth();
+		children[i]->ParentModified();
+	}
+	if(inHierarchy) {
+		std::vector<Transform*>::iterator i = std::find(hierarchy.begin(), hierarchy.end(), this);
+		if(i != hierarchy.end())
+			hierarchy.erase(i);
+	}
+}
+// Copies the local values; parent and children are kept
+Transform& Transform::operator=(const Transform& transform) {
+	if(&transform == this)
+		return *this;
+	position = transform.position;
+	rotation = transform.rotation;
+	orientation = transform.orientation;
+	quaternion = transform.quaternion;
+	eulerDirty = transform.eulerDirty;
+	scale = transform.scale;
+	localMatrix = transform.localMatrix;
+	rotationMatrix = transform.rotationMatrix;
+	look = transform.look;
+	up = transform.up;
+	right = transform.right;
+	rotationDirty = transform.rotationDirty;
+
+	// The world matrix depends on our own parent, not the other transform's
+	Modified();
+	localDirty = transform.localDirty;
+	return *this;
+}
+// Gets the position of the transform
+Vector3 Transform::GetPosition() {
+	return position;
+}
+// Gets the rotation of the transform as Euler angles
+Vector3 Transform::GetRotation() {
+	if(eulerDirty) {
+		// The rotation matrix is Z * X * Y, so the angles can be read back from it
+		UpdateRotation();
+		rotation.x = asinf(Max(-1.0f, Min(1.0f, -rotationMatrix._32)));
+		rotation.y = atan2f(rotationMatrix._31, rotationMatrix._33);
+		rotation.z = atan2f(rotationMatrix._12, rotationMatrix._22);
+		eulerDirty = false;
+	}
+	return rotation;
+}
+// Gets the scaling of the transform
+Vector3 Transform::GetScale() {
+	return scale;
+}
+// Sets the position of the transform
+void Transform::SetPosition(Vector3* nPosition) {
+	position = *nPosition;
+	Modified();
+}
+// Sets the rotation of the transform
+void Transform::SetRotation(Vector3* nRotation) {
+	quaternion = false; eulerDirty = false;
+	rotation = *nRotation;
+	RotationModified();
+}
+// Sets the scaling of the transform
+void Transform::SetScale(Vector3* nScale) {
+	scale = *nScale;
+	Modified();
+}
+// Sets the position of the transform
+void Transform::SetPosition(float x, float y, float z) {
+	position.x = x; position.y = y; position.z = z;
+	Modified();
+}
+// Sets the rotation of the transform
+void Transform::SetRotation(float rx, float ry, float rz) {
+	quaternion = false; eulerDirty = false;
+	rotation.x = rx; rotation.y = ry; rotation.z = rz;
+	RotationModified();
+}
+// Sets the scaling of the transform
+void Transform::SetScale(float sx, float sy, float sz) {
+	scale.x = sx; scale.y = sy; scale.z = sz;
+	Modified();
+}
+// Adds the specified vector to the position
+void Transform::AddPosition(Vector3* nPosition) {
+	position += *nPosition;
+	Modified();
+}
+// Adds the specified vector to the position relative to the transform's rotation
+void Transform::AddPositionRelative(Vector3* nPosition) {
+	position += GetRightVector() * nPosition->x; position += GetUpVector() * nPosition->y; position += GetLookVector() * nPosition->z;
+	Modified();
+}
+// Adds the specified vector to the rotation
+void Transform::AddRotation(Vector3* nRotation) {
+	AddRotation(nRotation->x, nRotation->y, nRotation->z);
+}
+// Adds the specified vector to the scaling
+void Transform::AddScale(Vector3* nScale) {
+	scale += *nScale;
+	Modified();
+}
+// Adds the specified values to the position
+void Transform::AddPosition(float x, float y, float z) {
+	position.x += x; position.y += y; position.z += z;
+	Modified();
+}
+// Adds the specified values to the position relative to the transform's rotation
+void Transform::AddPositionRelative(float x, float y, float z) {
+	position += GetRightVector() * x; position += GetUpVector() * y; position += GetLookVector() * z;
+	Modified();
+}
+// Adds the specified values to the rotation
+void Transform::AddRotation(float rx, float ry, float rz) {
+	if(quaternion) {
+		// Add to the angles recovered from the quaternion, so the result is the same as in Euler mode.
+		// Keep the summed angles instead of recovering them again next time, so they don't drift
+		Vector3 angles = GetRotation();
+		angles.x += rx; angles.y += ry; angles.z += rz;
+		Quaternion q = Quaternion::RotationYawPitchRoll(angles.y, angles.x, angles.z);
+		SetOrientation(&q);
+		rotation = angles;
+		eulerDirty = false;
+		return;
+	}
+	rotation.x += rx; rotation.y += ry; rotation.z += rz;
+	RotationModified();
+}
+// Sets the rotation as a quaternion and switches to quaternion mode
+void Transform::SetOrientation(Quaternion* nOrientation) {
+	orientation = nOrientation->Normalized();
+	quaternion = true;
+	eulerDirty = true;
+	RotationModified();
+}
+// Gets the rotation as a quaternion
+Quaternion Transform::GetOrientation() {
+	if(quaternion)
+		return orientation;
+	return Quaternion::RotationYawPitchRoll(rotation.y, rotation.x, rotation.z);
+}
+// Applies the rotation after the current one; switches to quaternion mode
+void Transform::Rotate(Quaternion* nRotation) {
+	// Renormalize every time so rounding errors can't build up over many frames
+	Quaternion current = GetOrientation();
+	Quaternion composed = current * *nRotation;
+	SetOrientation(&composed);
+}
+// Rotates around the axis by the angle; switches to quaternion mode
+void Transform::Rotate(Vector3* axis, float angle) {
+	Quaternion q = Quaternion::RotationAxis(*axis, angle);
+	Rotate(&q);
+}
+// Returns true if the transform is in quaternion mode
+bool Transform::IsQuaternion() {
+	return quaternion;
+}
+// Sets the transform between a and b; switches to quaternion mode
+void Transform::SetInterpolated(Transform* a, Transform* b, float t) {
+	position = Vector3::Lerp(a->position, b->position, t);
+	scale = Vector3::Lerp(a->scale, b->scale, t);
+	Quaternion q = Quaternion::Nlerp(a->GetOrientation(), b->GetOrientation(), t);
+	SetOrientation(&q); // Marks everything modified
+}
+// Adds the specified values to the scaling
+void Transform::AddScale(float sx, float sy, float sz) {
+	scale.x += sx; scale.y += sy; scale.z += sz;
+	Modified();
+}
+// Gets the look vector of the transform for view matrix generation
+Vector3 Transform::GetLookVector() {
+	UpdateRotation();
+	return look;
+}
+// Gets the up vector of the transform for view matrix generation
+Vector3 Transform::GetUpVector() {
+	UpdateRotation();
+	return up;
+}
+// Gets the right vector of the transform for view matrix generation
+Vector3 Transform::GetRightVector() {
+	UpdateRotation();
+	return right;
+}
+// Gets the rotation matrix of the transform
+Matrix Transform::GetRotationMatrix() {
+	UpdateRotation();
+	return rotationMatrix;
+}
+// Rebuilds the rotation matrix and vectors if they're out of date
+void Transform::UpdateRotation() {
+	if(!rotationDirty)
+		return;
+
+	if(quaternion)
+		rotationMatrix = Matrix::RotationQuaternion(orientation);
+	else
+		rotationMatrix = Matrix::RotationZ(rotation.z) * Matrix::RotationX(rotation.x) * Matrix::RotationY(rotation.y);
+
+	// The basis vectors are the rows of the rotation matrix
+	right = rotationMatrix.GetRow(0);
+	up = rotationMatrix.GetRow(1);
+	look = rotationMatrix.GetRow(2);
+
+	rotationDirty = false;
+}
+// Gets a number that changes every time the transform or one of its parents is modified
+int Transform::GetRevision() {
+	SyncParent();
+	return revision;
+}
+// Gives the transform a new revision number and marks the matrix out of date
+void Transform::Modified() {
+	lastRevision++;
+	revision = lastRevision;
+	matrixDirty = true;
+	localDirty = true;
+}
+// Gives the transform a new revision number after one of its parents changed
+void Transform::ParentModified() {
+	lastRevision++;
+	revision = lastRevision;
+	matrixDirty = true;
+}
+// Picks up changes made to the parents since the last call
+void Transform::SyncParent() {
+	if(!parent)
+		return;
+	parent->SyncParent();
+	if(parent->revision != parentRevision) {
+		parentRevision = parent->revision;
+		ParentModified();
+	}
+}
+// Same as Modified(), but also marks the rotation matrix and vectors out of date
+void Transform::RotationModified() {
+	Modified();
+	rotationDirty = true;
+}
+// Gets the matrix of the transform relative to its parent
+Matrix Transform::GetLocalMatrix() {
+	if(localDirty) {
+		UpdateRotation();
+		localMatrix = rotationMatrix * Matrix::Scaling(scale.x, scale.y, scale.z) * Matrix::Translation(position.x, position.y, position.z);
+		localDirty = false;
+		vvd::GetFrameStats()->matrixBuilds++;
+	}
+	return localMatrix;
+}
+// Gets the world matrix of the transform; only rebuilt after the transform or one of its parents changes
+Matrix Transform::GetMatrix() {
+	SyncParent();
+	if(matrixDirty) {
+		if(parent)
+			matrix = GetLocalMatrix() * parent->GetMatrix();
+		else
+			matrix = GetLocalMatrix();
+		matrixDirty = false;
+	}
+	return matrix;
+}
+// Gets the position of the transform in world space
+Vector3 Transform::GetWorldPosition() {
+	if(!parent)
+		return position;
+	return GetMatrix().GetRow(3);
+}
+// Attaches the transform to a parent; the position, rotation and scaling become relative to it
+void Transform::SetParent(Transform* nParent) {
+	if(nParent == parent)
+		return;
+	for(Transform* ancestor = nParent; ancestor; ancestor = ancestor->parent) {
+		if(ancestor == this) {
+			vvd::Log("Vivid: Cannot parent a transform to one of its own children");
+			return;
+		}
+	}
+
+	if(parent) {
+		std::vector<Transform*>::iterator i = std::find(parent->children.begin(), parent->children.end(), this);
+		if(i != parent->children.end())
+			parent->children.erase(i);
+	}
+	parent = nParent;
+	if(parent) {
+		parent->children.push_back(this);
+		parent->AddToHierarchy();
+		AddToHierarchy();
+		parentRevision = parent->revision;
+	}
+	UpdateDepth();
+	ParentModified();
+}
+// Gets the parent of the transform, or 0 if it has none
+Transform* Transform::GetParent() {
+	return parent;
+}
+// Recomputes the depth of the transform and its children
+void Transform::UpdateDepth() {
+	depth = parent ? parent->depth + 1 : 0;
+	hierarchySorted = false;
+	for(unsigned int i = 0; i < children.size(); i++)
+		children[i]->UpdateDepth();
+}
+// Adds the transform to the hierarchy list if it isn't there already
+void Transform::AddToHierarchy() {
+	if(inHierarchy)
+		return;
+	hierarchy.push_back(this);
+	inHierarchy = true;
+	hierarchySorted = false;
+}
+// Sorts transforms by depth
+bool Transform::CompareDepth(Transform* a, Transform* b) {
+	return a->depth < b->depth;
+}
+// Brings the world matrices of every parented transform up to date in one pass, parents before children
+void Transform::UpdateHierarchy() {
+	if(!hierarchySorted) {
+		std::stable_sort(hierarchy.begin(), hierarchy.end(), CompareDepth);
+		hierarchySorted = true;
+	}
+
+	// Parents come before their children, so each parent is already up to date
+	// when its children are visited and only changed subtrees get rebuilt
+	for(unsigned int i = 0; i < hierarchy.size(); i++) {
+		Transform* t = hierarchy[i];
+		if(t->parent && t->parent->revision != t->parentRevision) {
+			t->parentRevision = t->parent->revision;
+			t->ParentModified();
+		}
+		if(t->matrixDirty) {
+			if(t->parent)
+				t->matrix = t->GetLocalMatrix() * t->parent->matrix;
+			else
+				t->matrix = t->GetLocalMatrix();
+			t->matrixDirty = false;
+		}
+	}
 }
\ No newline at end of file
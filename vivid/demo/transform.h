@@ -1,56 +1,108 @@
-// Vivid Engine v0.01
-// Copyright (C) 2006 Evan Todd
-
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// version 2 as published by the Free Software Foundation.
-
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-// GNU General Public License (included in README.txt) for more details.
-
-// You can contact the author at evanofsky@sbcglobal.net.
-
-#ifndef transform_h
-#define transform_h
-#include "vivid.h"
-
-class Transform {
-public:
-	Transform();
-	Transform(float x, float y, float z);
-	Transform(float x, float y, float z, float rx, float ry, float rz);
-	Transform(const Transform& transform);
-	~Transform();
-	D3DXVECTOR3 GetPosition(); // Gets the position of the transform
-	D3DXVECTOR3 GetRotation(); // Gets the rotation of the transform
-	D3DXVECTOR3 GetScale(); // Gets the scaling of the transform
-	void SetPosition(D3DXVECTOR3* nPosition); // Sets the position
-	void SetRotation(D3DXVECTOR3* nRotation); // Sets the rotation
-	void SetScale(D3DXVECTOR3* nScale); // Sets the scaling
-	void SetPosition(float x, float y, float z); // Sets the position
-	void SetRotation(float rx, float ry, float rz); // Sets the rotation
-	void SetScale(float sx, float sy, float sz); // Sets the scaling
-	void AddPosition(D3DXVECTOR3* nPosition); // Adds the specified vector to the position
-	void AddPositionRelative(D3DXVECTOR3* nPosition); // Adds the specified vector to the position
-													  // relative to the transform's rotation
-	void AddRotation(D3DXVECTOR3* nRotation); // Adds the specified vector to the rotation
-	void AddScale(D3DXVECTOR3* nScale);  // Adds the specified vector to the scaling
-	void AddPosition(float x, float y, float z); // Adds the specified values to the position
-	void AddPositionRelative(float x, float y, float z); // Adds the specified values to the position
-														 // relative to the transform's rotation
-	void AddRotation(float rx, float ry, float rz); // Adds the specified values to the rotation
-	void AddScale(float sx, float sy, float sz); // Adds the specified valeus to the scaling
-	D3DXVECTOR3 GetLookVector(); // Gets the look vector of the transform for view matrix generation
-	D3DXVECTOR3 GetUpVector(); // Gets the up vector of the transform for view matrix generation
-	D3DXVECTOR3 GetRightVector(); // Gets the right vector of the transform for view matrix generation
-	D3DXMATRIX GetRotationMatrix(); // Gets the rotation matrix of the transform
-	D3DXMATRIX GetMatrix(); // Gets the matrix of the transform
-protected:
-	D3DXVECTOR3 position;
-	D3DXVECTOR3 rotation;
-	D3DXVECTOR3 scale;
-};
-
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#ifndef transform_h
+#define transform_h
+#include "vividcore.h"
+#include "vmath.h"
+#include <vector>
+
+class Transform {
+public:
+	Transform();
+	Transform(float x, float y, float z);
+	Transform(float x, float y, float z, float rx, float ry, float rz);
+	Transform(const Transform& transform);
+	~Transform();
+	Transform& operator=(const Transform& transform); // Copies the local values; parent and children are kept
+	Vector3 GetPosition(); // Gets the position of the transform
+	Vector3 GetRotation(); // Gets the rotation of the transform as Euler angles
+	Vector3 GetScale(); // Gets the scaling of the transform
+	void SetPosition(Vector3* nPosition); // Sets the position
+	void SetRotation(Vector3* nRotation); // Sets the rotation
+	void SetScale(Vector3* nScale); // Sets the scaling
+	void SetPosition(float x, float y, float z); // Sets the position
+	void SetRotation(float rx, float ry, float rz); // Sets the rotation
+	void SetScale(float sx, float sy, float sz); // Sets the scaling
+	void AddPosition(Vector3* nPosition); // Adds the specified vector to the position
+	void AddPositionRelative(Vector3* nPosition); // Adds the specified vector to the position
+													  // relative to the transform's rotation
+	void AddRotation(Vector3* nRotation); // Adds the specified vector to the rotation
+	void AddScale(Vector3* nScale);  // Adds the specified vector to the scaling
+	void AddPosition(float x, float y, float z); // Adds the specified values to the position
+	void AddPositionRelative(float x, float y, float z); // Adds the specified values to the position
+														 // relative to the transform's rotation
+	void AddRotation(float rx, float ry, float rz); // Adds the specified values to the rotation
+	// Quaternion rotation mode; the rotation matrix is built without any trig, and Rotate() composes
+	// rotations. AddRotation() still adds Euler angles. SetRotation() goes back to Euler angles
+	void SetOrientation(Quaternion* nOrientation); // Sets the rotation as a quaternion and switches to quaternion mode
+	Quaternion GetOrientation(); // Gets the rotation as a quaternion
+	void Rotate(Quaternion* nRotation); // Applies the rotation after the current one; switches to quaternion mode
+	void Rotate(Vector3* axis, float angle); // Rotates around the axis by the angle; switches to quaternion mode
+	bool IsQuaternion(); // Returns true if the transform is in quaternion mode
+	// Sets the transform between a and b; positions and scalings are lerped and rotations are
+	// interpolated with Quaternion::Nlerp. Switches to quaternion mode
+	void SetInterpolated(Transform* a, Transform* b, float t);
+	void AddScale(float sx, float sy, float sz); // Adds the specified valeus to the scaling
+	Vector3 GetLookVector(); // Gets the look vector of the transform for view matrix generation
+	Vector3 GetUpVector(); // Gets the up vector of the transform for view matrix generation
+	Vector3 GetRightVector(); // Gets the right vector of the transform for view matrix generation
+	Matrix GetRotationMatrix(); // Gets the rotation matrix of the transform
+	Matrix GetLocalMatrix(); // Gets the matrix of the transform relative to its parent
+	Matrix GetMatrix(); // Gets the world matrix of the transform, including its parents;
+							// only rebuilt after the transform or one of its parents changes
+	Vector3 GetWorldPosition(); // Gets the position of the transform in world space
+	void SetParent(Transform* nParent); // Attaches the transform to a parent; the position, rotation
+										// and scaling become relative to it. Pass 0 to detach
+	Transform* GetParent(); // Gets the parent of the transform, or 0 if it has none
+	int GetRevision(); // Gets a number that changes every time the transform or one of its parents is modified
+	static void UpdateHierarchy(); // Brings the world matrices of every parented transform up to date in one
+								   // pass, parents before children; call once per frame
+protected:
+	Vector3 position;
+	Vector3 rotation; // Euler angles; only up to date in quaternion mode after GetRotation()
+	Quaternion orientation; // Rotation in quaternion mode
+	bool quaternion; // True in quaternion mode
+	bool eulerDirty; // True if the Euler angles need to be recovered from the quaternion
+	Vector3 scale;
+	int revision; // Changes every time the transform is modified; unique across all transforms
+	static int lastRevision; // The last revision number handed out
+	void Modified(); // Gives the transform a new revision number and marks the matrix out of date
+	void RotationModified(); // Same as Modified(), but also marks the rotation matrix and vectors out of date
+	Matrix matrix; // Cached matrix of the transform
+	Matrix rotationMatrix; // Cached rotation matrix
+	Vector3 look; // Cached look vector
+	Vector3 up; // Cached up vector
+	Vector3 right; // Cached right vector
+	Matrix localMatrix; // Cached matrix relative to the parent
+	bool matrixDirty; // True if the world matrix needs to be rebuilt
+	bool localDirty; // True if the local matrix needs to be rebuilt
+	bool rotationDirty; // True if the rotation matrix and vectors need to be rebuilt
+	void UpdateRotation(); // Rebuilds the rotation matrix and vectors if they're out of date
+	void ParentModified(); // Gives the transform a new revision number after one of its parents changed
+	void SyncParent(); // Picks up changes made to the parents since the last call
+	void UpdateDepth(); // Recomputes the depth of the transform and its children
+	void AddToHierarchy(); // Adds the transform to the hierarchy list if it isn't there already
+	Transform* parent; // The transform this one is relative to, or 0
+	std::vector<Transform*> children; // Transforms relative to this one
+	int parentRevision; // Revision of the parent the world matrix was built against
+	int depth; // Number of parents above the transform
+	bool inHierarchy; // True if the transform is in the hierarchy list
+	static std::vector<Transform*> hierarchy; // Every transform with a parent or children, sorted by depth
+											  // when hierarchySorted is true
+	static bool hierarchySorted; // False after a depth changes until the list is sorted again
+	static bool CompareDepth(Transform* a, Transform* b); // Sorts transforms by depth
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,295 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "transformbatch.h"
+#include <xmmintrin.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+TransformBatch::TransformBatch() {
+	count = 0;
+	capacity = 0;
+	for(int i = 0; i < BATCH_ARRAY_COUNT; i++)
+		arrays[i] = 0;
+	matrices = 0;
+}
+TransformBatch::TransformBatch(const TransformBatch& batch) {
+	count = 0;
+	capacity = 0;
+	for(int i = 0; i < BATCH_ARRAY_COUNT; i++)
+		arrays[i] = 0;
+	matrices = 0;
+	*this = batch;
+}
+TransformBatch::~TransformBatch() {
+	for(int i = 0; i < BATCH_ARRAY_COUNT; i++) {
+		if(arrays[i])
+			_mm_free(arrays[i]);
+	}
+	if(matrices)
+		_mm_free(matrices);
+}
+// Copies the arrays
+TransformBatch& TransformBatch::operator=(const TransformBatch& batch) {
+	if(this == &batch)
+		return *this;
+	Reserve(batch.count);
+	count = batch.count;
+	for(int i = 0; i < BATCH_ARRAY_COUNT; i++) {
+		if(count > 0)
+			memcpy(arrays[i], batch.arrays[i], count * sizeof(float));
+	}
+	if(count > 0)
+		memcpy(matrices, batch.matrices, count * sizeof(Matrix));
+	return *this;
+}
+// Removes every object from the batch
+void TransformBatch::Clear() {
+	count = 0;
+}
+// Grows the arrays to hold at least the specified number of objects
+void TransformBatch::Reserve(int nCapacity) {
+	if(nCapacity <= capacity)
+		return;
+	int newCapacity = capacity * 2 > nCapacity ? capacity * 2 : nCapacity;
+	newCapacity = (newCapacity + 3) & ~3; // The kernels work on four objects at a time
+
+	for(int i = 0; i < BATCH_ARRAY_COUNT; i++) {
+		float* array = (float*)_mm_malloc(newCapacity * sizeof(float), 16);
+		if(!array) {
+			vvd::Log("Failed to allocate transform batch");
+			exit(1);
+		}
+		// The padding has to hold valid numbers; zeroes give zero scaled matrices
+		memset(array, 0, newCapacity * sizeof(float));
+		if(arrays[i]) {
+			memcpy(array, arrays[i], capacity * sizeof(float));
+			_mm_free(arrays[i]);
+		}
+		arrays[i] = array;
+	}
+
+	Matrix* newMatrices = (Matrix*)_mm_malloc(newCapacity * sizeof(Matrix), 16);
+	if(!newMatrices) {
+		vvd::Log("Failed to allocate transform batch");
+		exit(1);
+	}
+	if(matrices) {
+		memcpy(newMatrices, matrices, capacity * sizeof(Matrix));
+		_mm_free(matrices);
+	}
+	matrices = newMatrices;
+	capacity = newCapacity;
+}
+// Adds an object with the specified local bounding sphere; returns its index
+int TransformBatch::Add(Transform* transform, Vector3* center, float radius) {
+	Reserve(count + 1);
+	int index = count;
+	count++;
+	Set(index, transform);
+	arrays[BATCH_CENTER_X][index] = center->x;
+	arrays[BATCH_CENTER_Y][index] = center->y;
+	arrays[BATCH_CENTER_Z][index] = center->z;
+	arrays[BATCH_RADIUS][index] = radius;
+	return index;
+}
+// Adds a bounding sphere that's already in world space, with an identity transform; returns its index
+int TransformBatch::AddSphere(Vector3* center, float radius) {
+	Reserve(count + 1);
+	int index = count;
+	count++;
+	arrays[BATCH_POSITION_X][index] = 0.0f;
+	arrays[BATCH_POSITION_Y][index] = 0.0f;
+	arrays[BATCH_POSITION_Z][index] = 0.0f;
+	arrays[BATCH_ROTATION_X][index] = 0.0f;
+	arrays[BATCH_ROTATION_Y][index] = 0.0f;
+	arrays[BATCH_ROTATION_Z][index] = 0.0f;
+	arrays[BATCH_SCALE_X][index] = 1.0f;
+	arrays[BATCH_SCALE_Y][index] = 1.0f;
+	arrays[BATCH_SCALE_Z][index] = 1.0f;
+	arrays[BATCH_CENTER_X][index] = arrays[BATCH_WORLD_X][index] = center->x;
+	arrays[BATCH_CENTER_Y][index] = arrays[BATCH_WORLD_Y][index] = center->y;
+	arrays[BATCH_CENTER_Z][index] = arrays[BATCH_WORLD_Z][index] = center->z;
+	arrays[BATCH_RADIUS][index] = arrays[BATCH_WORLD_RADIUS][index] = radius;
+	return index;
+}
+// Copies the position, rotation and scaling of the transform into the batch
+void TransformBatch::Set(int index, Transform* transform) {
+	Vector3 position = transform->GetPosition();
+	Vector3 rotation = transform->GetRotation();
+	Vector3 scale = transform->GetScale();
+	arrays[BATCH_POSITION_X][index] = position.x;
+	arrays[BATCH_POSITION_Y][index] = position.y;
+	arrays[BATCH_POSITION_Z][index] = position.z;
+	arrays[BATCH_ROTATION_X][index] = rotation.x;
+	arrays[BATCH_ROTATION_Y][index] = rotation.y;
+	arrays[BATCH_ROTATION_Z][index] = rotation.z;
+	arrays[BATCH_SCALE_X][index] = scale.x;
+	arrays[BATCH_SCALE_Y][index] = scale.y;
+	arrays[BATCH_SCALE_Z][index] = scale.z;
+}
+// Gets the number of objects in the batch
+int TransformBatch::GetCount() {
+	return count;
+}
+// Gets one of the arrays for direct access; padded to a multiple of four
+float* TransformBatch::GetArray(BatchArray array) {
+	return arrays[array];
+}
+// Gets the world matrices built by Compute()
+Matrix* TransformBatch::GetMatrices() {
+	return matrices;
+}
+// Gets the world bounding sphere of an object; w is the radius
+Vector4 TransformBatch::GetSphere(int index) {
+	return Vector4(arrays[BATCH_WORLD_X][index], arrays[BATCH_WORLD_Y][index],
+		arrays[BATCH_WORLD_Z][index], arrays[BATCH_WORLD_RADIUS][index]);
+}
+// Builds the world matrices and bounding spheres with SSE
+void TransformBatch::Compute() {
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	for(int i = 0; i < count; i += 4) {
+		// SSE has no sine or cosine, so those are taken one value at a time
+		float* rx = arrays[BATCH_ROTATION_X] + i;
+		float* ry = arrays[BATCH_ROTATION_Y] + i;
+		float* rz = arrays[BATCH_ROTATION_Z] + i;
+		__m128 sx = _mm_set_ps(sinf(rx[3]), sinf(rx[2]), sinf(rx[1]), sinf(rx[0]));
+		__m128 cx = _mm_set_ps(cosf(rx[3]), cosf(rx[2]), cosf(rx[1]), cosf(rx[0]));
+		__m128 sy = _mm_set_ps(sinf(ry[3]), sinf(ry[2]), sinf(ry[1]), sinf(ry[0]));
+		__m128 cy = _mm_set_ps(cosf(ry[3]), cosf(ry[2]), cosf(ry[1]), cosf(ry[0]));
+		__m128 sz = _mm_set_ps(sinf(rz[3]), sinf(rz[2]), sinf(rz[1]), sinf(rz[0]));
+		__m128 cz = _mm_set_ps(cosf(rz[3]), cosf(rz[2]), cosf(rz[1]), cosf(rz[0]));
+
+		// Rotation Z * X * Y, matching Transform
+		__m128 sxsy = _mm_mul_ps(sx, sy);
+		__m128 sxcy = _mm_mul_ps(sx, cy);
+		__m128 r11 = _mm_add_ps(_mm_mul_ps(cz, cy), _mm_mul_ps(sz, sxsy));
+		__m128 r12 = _mm_mul_ps(sz, cx);
+		__m128 r13 = _mm_sub_ps(_mm_mul_ps(sz, sxcy), _mm_mul_ps(cz, sy));
+		__m128 r21 = _mm_sub_ps(_mm_mul_ps(cz, sxsy), _mm_mul_ps(sz, cy));
+		__m128 r22 = _mm_mul_ps(cz, cx);
+		__m128 r23 = _mm_add_ps(_mm_mul_ps(sz, sy), _mm_mul_ps(cz, sxcy));
+		__m128 r31 = _mm_mul_ps(cx, sy);
+		__m128 r32 = _mm_sub_ps(zero, sx);
+		__m128 r33 = _mm_mul_ps(cx, cy);
+
+		// Then the scaling, which scales the columns
+		__m128 scaleX = _mm_load_ps(arrays[BATCH_SCALE_X] + i);
+		__m128 scaleY = _mm_load_ps(arrays[BATCH_SCALE_Y] + i);
+		__m128 scaleZ = _mm_load_ps(arrays[BATCH_SCALE_Z] + i);
+		r11 = _mm_mul_ps(r11, scaleX); r12 = _mm_mul_ps(r12, scaleY); r13 = _mm_mul_ps(r13, scaleZ);
+		r21 = _mm_mul_ps(r21, scaleX); r22 = _mm_mul_ps(r22, scaleY); r23 = _mm_mul_ps(r23, scaleZ);
+		r31 = _mm_mul_ps(r31, scaleX); r32 = _mm_mul_ps(r32, scaleY); r33 = _mm_mul_ps(r33, scaleZ);
+
+		// And the translation, which is the last row
+		__m128 px = _mm_load_ps(arrays[BATCH_POSITION_X] + i);
+		__m128 py = _mm_load_ps(arrays[BATCH_POSITION_Y] + i);
+		__m128 pz = _mm_load_ps(arrays[BATCH_POSITION_Z] + i);
+
+		// Each register holds one element of four matrices; transpose them into rows
+		float* out = (float*)(matrices + i);
+		__m128 a, b, c, d;
+		a = r11; b = r12; c = r13; d = zero;
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_store_ps(out, a); _mm_store_ps(out + 16, b); _mm_store_ps(out + 32, c); _mm_store_ps(out + 48, d);
+		a = r21; b = r22; c = r23; d = zero;
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_store_ps(out + 4, a); _mm_store_ps(out + 20, b); _mm_store_ps(out + 36, c); _mm_store_ps(out + 52, d);
+		a = r31; b = r32; c = r33; d = zero;
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_store_ps(out + 8, a); _mm_store_ps(out + 24, b); _mm_store_ps(out + 40, c); _mm_store_ps(out + 56, d);
+		a = px; b = py; c = pz; d = one;
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_store_ps(out + 12, a); _mm_store_ps(out + 28, b); _mm_store_ps(out + 44, c); _mm_store_ps(out + 60, d);
+
+		// Move the bounding sphere centers into world space
+		__m128 lx = _mm_load_ps(arrays[BATCH_CENTER_X] + i);
+		__m128 ly = _mm_load_ps(arrays[BATCH_CENTER_Y] + i);
+		__m128 lz = _mm_load_ps(arrays[BATCH_CENTER_Z] + i);
+		__m128 wx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, r11), _mm_mul_ps(ly, r21)), _mm_add_ps(_mm_mul_ps(lz, r31), px));
+		__m128 wy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, r12), _mm_mul_ps(ly, r22)), _mm_add_ps(_mm_mul_ps(lz, r32), py));
+		__m128 wz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, r13), _mm_mul_ps(ly, r23)), _mm_add_ps(_mm_mul_ps(lz, r33), pz));
+		_mm_store_ps(arrays[BATCH_WORLD_X] + i, wx);
+		_mm_store_ps(arrays[BATCH_WORLD_Y] + i, wy);
+		_mm_store_ps(arrays[BATCH_WORLD_Z] + i, wz);
+
+		// The radius grows with the longest row, the same as SceneMesh::GetRadius
+		__m128 len1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r11, r11), _mm_mul_ps(r12, r12)), _mm_mul_ps(r13, r13));
+		__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r21, r21), _mm_mul_ps(r22, r22)), _mm_mul_ps(r23, r23));
+		__m128 len3 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r31, r31), _mm_mul_ps(r32, r32)), _mm_mul_ps(r33, r33));
+		__m128 maxScale = _mm_sqrt_ps(_mm_max_ps(_mm_max_ps(len1, len2), len3));
+		_mm_store_ps(arrays[BATCH_WORLD_RADIUS] + i, _mm_mul_ps(_mm_load_ps(arrays[BATCH_RADIUS] + i), maxScale));
+	}
+	vvd::GetFrameStats()->matrixBuilds += count;
+}
+// Builds the world matrices and bounding spheres one object at a time, without SSE
+void TransformBatch::ComputeReference() {
+	for(int i = 0; i < count; i++) {
+		Matrix& m = matrices[i];
+		m = Matrix::RotationZ(arrays[BATCH_ROTATION_Z][i]) * Matrix::RotationX(arrays[BATCH_ROTATION_X][i]) *
+			Matrix::RotationY(arrays[BATCH_ROTATION_Y][i]) *
+			Matrix::Scaling(arrays[BATCH_SCALE_X][i], arrays[BATCH_SCALE_Y][i], arrays[BATCH_SCALE_Z][i]) *
+			Matrix::Translation(arrays[BATCH_POSITION_X][i], arrays[BATCH_POSITION_Y][i], arrays[BATCH_POSITION_Z][i]);
+
+		Vector3 center(arrays[BATCH_CENTER_X][i], arrays[BATCH_CENTER_Y][i], arrays[BATCH_CENTER_Z][i]);
+		Vector3 worldCenter = m.TransformCoord(center);
+		arrays[BATCH_WORLD_X][i] = worldCenter.x;
+		arrays[BATCH_WORLD_Y][i] = worldCenter.y;
+		arrays[BATCH_WORLD_Z][i] = worldCenter.z;
+
+		float maxScale = Max(Max(m.GetRow(0).Length(), m.GetRow(1).Length()), m.GetRow(2).Length());
+		arrays[BATCH_WORLD_RADIUS][i] = arrays[BATCH_RADIUS][i] * maxScale;
+	}
+	vvd::GetFrameStats()->matrixBuilds += count;
+}
+// Writes the indices of the objects whose spheres touch the frustum to visible; returns how many there are
+int TransformBatch::Cull(Frustum* frustum, int* visible) {
+	__m128 planeA[6], planeB[6], planeC[6], planeD[6];
+	for(int j = 0; j < 6; j++) {
+		Plane* plane = frustum->GetPlane(j);
+		planeA[j] = _mm_set1_ps(plane->a);
+		planeB[j] = _mm_set1_ps(plane->b);
+		planeC[j] = _mm_set1_ps(plane->c);
+		planeD[j] = _mm_set1_ps(plane->d);
+	}
+
+	int numVisible = 0;
+	__m128 zero = _mm_setzero_ps();
+	for(int i = 0; i < count; i += 4) {
+		__m128 x = _mm_load_ps(arrays[BATCH_WORLD_X] + i);
+		__m128 y = _mm_load_ps(arrays[BATCH_WORLD_Y] + i);
+		__m128 z = _mm_load_ps(arrays[BATCH_WORLD_Z] + i);
+		__m128 negRadius = _mm_sub_ps(zero, _mm_load_ps(arrays[BATCH_WORLD_RADIUS] + i));
+
+		// A sphere is outside if it's completely behind any plane
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for(int j = 0; j < 6; j++) {
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeA[j], x), _mm_mul_ps(planeB[j], y)),
+				_mm_add_ps(_mm_mul_ps(planeC[j], z), planeD[j]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for(int k = 0; k < 4 && i + k < count; k++) {
+			if(mask & (1 << k)) {
+				visible[numVisible] = i + k;
+				numVisible++;
+			}
+		}
+	}
+	return numVisible;
+}
\ No newline at end of file
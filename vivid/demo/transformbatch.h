@@ -0,0 +1,64 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef transformbatch_h
+#define transformbatch_h
+#include "vividcore.h"
+#include "vmath.h"
+#include "transform.h"
+#include "frustum.h"
+
+// Inputs and outputs of a TransformBatch, each stored as its own array
+enum BatchArray {
+	BATCH_POSITION_X, BATCH_POSITION_Y, BATCH_POSITION_Z,
+	BATCH_ROTATION_X, BATCH_ROTATION_Y, BATCH_ROTATION_Z,
+	BATCH_SCALE_X, BATCH_SCALE_Y, BATCH_SCALE_Z,
+	BATCH_CENTER_X, BATCH_CENTER_Y, BATCH_CENTER_Z, BATCH_RADIUS, // Local bounding spheres
+	BATCH_WORLD_X, BATCH_WORLD_Y, BATCH_WORLD_Z, BATCH_WORLD_RADIUS, // World bounding spheres; filled by Compute()
+	BATCH_ARRAY_COUNT
+};
+
+// Positions, rotations and scalings of many objects stored as structure-of-arrays, so world
+// matrices and bounding spheres can be built and culled four objects at a time with SSE.
+// Transforms are read as they are; parents are not applied. It doesn't need Direct3D
+class TransformBatch {
+public:
+	TransformBatch();
+	TransformBatch(const TransformBatch& batch); // Copies the arrays
+	~TransformBatch();
+	TransformBatch& operator=(const TransformBatch& batch); // Copies the arrays
+	void Clear(); // Removes every object from the batch
+	int Add(Transform* transform, Vector3* center, float radius); // Adds an object with the specified local bounding
+																  // sphere; returns its index
+	int AddSphere(Vector3* center, float radius); // Adds a bounding sphere that's already in world space, with an identity
+												  // transform, so it can be culled without Compute(); returns its index
+	void Set(int index, Transform* transform); // Copies the position, rotation and scaling of the transform into the batch
+	int GetCount(); // Gets the number of objects in the batch
+	float* GetArray(BatchArray array); // Gets one of the arrays for direct access; padded to a multiple of four
+	void Compute(); // Builds the world matrices and bounding spheres with SSE
+	void ComputeReference(); // Builds the world matrices and bounding spheres one object at a time, without SSE
+	Matrix* GetMatrices(); // Gets the world matrices built by Compute()
+	Vector4 GetSphere(int index); // Gets the world bounding sphere of an object; w is the radius
+	int Cull(Frustum* frustum, int* visible); // Writes the indices of the objects whose spheres touch the frustum
+											  // to visible; returns how many there are
+protected:
+	void Reserve(int nCapacity); // Grows the arrays to hold at least the specified number of objects
+	int count; // Number of objects in the batch
+	int capacity; // Number of objects the arrays can hold; always a multiple of four
+	float* arrays[BATCH_ARRAY_COUNT]; // 16 byte aligned arrays
+	Matrix* matrices; // 16 byte aligned world matrices
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,156 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "uniformgrid.h"
+
+UniformGrid::UniformGrid(float nWorldSizeX, float nWorldSizeY, float nWorldSizeZ, float nCellSizeX, float nCellSizeY, float nCellSizeZ) {
+	// Set the world and cell sizes
+	worldSizeX = nWorldSizeX; worldSizeY = nWorldSizeY; worldSizeZ = nWorldSizeZ;
+	cellSizeX = nCellSizeX; cellSizeY = nCellSizeY; cellSizeZ = nCellSizeZ;
+
+	// Calculate the number of cells along the X, Y, and Z axes
+	numCellsX = Max((int)(worldSizeX / cellSizeX), 1);
+	numCellsY = Max((int)(worldSizeY / cellSizeY), 1);
+	numCellsZ = Max((int)(worldSizeZ / cellSizeZ), 1);
+
+	// Calculate the total number of cells
+	numCells = numCellsX * numCellsZ * numCellsY;
+
+	// Initialize the cell list
+	cells.resize(numCells);
+}
+// Gets every cell overlapped by the bounding box of the sphere
+void UniformGrid::GetCells(Vector3 center, float radius, std::vector<Cell*>* nCells) {
+	Vector3 boxMin(center.x - radius, center.y - radius, center.z - radius);
+	Vector3 boxMax(center.x + radius, center.y + radius, center.z + radius);
+	CellRange range = GetCellRange(&boxMin, &boxMax);
+
+	nCells->clear();
+	for(int y = range.minY; y <= range.maxY; y++) {
+		for(int z = range.minZ; z <= range.maxZ; z++) {
+			for(int x = range.minX; x <= range.maxX; x++) {
+				nCells->push_back(&cells[GetIndex(x, y, z)]);
+			}
+		}
+	}
+}
+// Gets the cell at the position specified
+Cell* UniformGrid::GetCell(Vector3 pos) {
+	CellRange range = GetCellRange(&pos, &pos);
+	return &cells[GetIndex(range.minX, range.minY, range.minZ)];
+}
+// Gets every cell
+void UniformGrid::GetAllCells(std::vector<Cell*>* nCells) {
+	nCells->clear();
+	for(int i = 0; i < (int)cells.size(); i++) {
+		nCells->push_back(&cells[i]);
+	}
+}
+// Gets the number of cells
+int UniformGrid::GetNumCells() {
+	return numCells;
+}
+// Gets the cells touching the sphere
+void UniformGrid::QuerySphere(Vector3 center, float radius, std::vector<Cell*>* nCells) {
+	Vector3 boxMin(center.x - radius, center.y - radius, center.z - radius);
+	Vector3 boxMax(center.x + radius, center.y + radius, center.z + radius);
+	CellRange range = GetCellRange(&boxMin, &boxMax);
+
+	nCells->clear();
+	for(int y = range.minY; y <= range.maxY; y++) {
+		for(int z = range.minZ; z <= range.maxZ; z++) {
+			for(int x = range.minX; x <= range.maxX; x++) {
+				Vector3 cellMin, cellMax;
+				GetCellBox(x, y, z, &cellMin, &cellMax);
+				if(SphereIntersectsBox(&center, radius, &cellMin, &cellMax))
+					nCells->push_back(&cells[GetIndex(x, y, z)]);
+			}
+		}
+	}
+}
+// Gets the cells at least partially inside the frustum
+void UniformGrid::QueryFrustum(Frustum* frustum, std::vector<Cell*>* nCells) {
+	nCells->clear();
+	for(int y = 0; y < numCellsY; y++) {
+		for(int z = 0; z < numCellsZ; z++) {
+			for(int x = 0; x < numCellsX; x++) {
+				Vector3 cellMin, cellMax;
+				GetCellBox(x, y, z, &cellMin, &cellMax);
+				if(frustum->IntersectsBox(&cellMin, &cellMax))
+					nCells->push_back(&cells[GetIndex(x, y, z)]);
+			}
+		}
+	}
+}
+// Gets the cells the ray passes through before it has traveled the specified length
+void UniformGrid::QueryRay(Vector3 origin, Vector3 direction, float length, std::vector<Cell*>* nCells) {
+	// Only test the cells inside the bounding box of the ray
+	Vector3 end = origin + direction * length;
+	Vector3 boxMin(Min(origin.x, end.x), Min(origin.y, end.y), Min(origin.z, end.z));
+	Vector3 boxMax(Max(origin.x, end.x), Max(origin.y, end.y), Max(origin.z, end.z));
+	CellRange range = GetCellRange(&boxMin, &boxMax);
+
+	nCells->clear();
+	for(int y = range.minY; y <= range.maxY; y++) {
+		for(int z = range.minZ; z <= range.maxZ; z++) {
+			for(int x = range.minX; x <= range.maxX; x++) {
+				Vector3 cellMin, cellMax;
+				GetCellBox(x, y, z, &cellMin, &cellMax);
+				if(RayIntersectsBox(&origin, &direction, length, &cellMin, &cellMax))
+					nCells->push_back(&cells[GetIndex(x, y, z)]);
+			}
+		}
+	}
+}
+// Gets the cells overlapped by the box; clamped to the grid
+CellRange UniformGrid::GetCellRange(Vector3* boxMin, Vector3* boxMax) {
+	CellRange range;
+
+	// Cell coordinates grow along +X, +Y, and -Z from the corner of the world
+	range.minX = (int)floorf(((worldSizeX / 2.0f) + boxMin->x) / cellSizeX);
+	range.maxX = (int)floorf(((worldSizeX / 2.0f) + boxMax->x) / cellSizeX);
+	range.minY = (int)floorf(((worldSizeY / 2.0f) + boxMin->y) / cellSizeY);
+	range.maxY = (int)floorf(((worldSizeY / 2.0f) + boxMax->y) / cellSizeY);
+	range.minZ = (int)floorf(((worldSizeZ / 2.0f) - boxMax->z) / cellSizeZ);
+	range.maxZ = (int)floorf(((worldSizeZ / 2.0f) - boxMin->z) / cellSizeZ);
+
+	// Anything outside the world goes in the cells along the edge
+	range.minX = Min(Max(range.minX, 0), numCellsX - 1); range.maxX = Min(Max(range.maxX, 0), numCellsX - 1);
+	range.minY = Min(Max(range.minY, 0), numCellsY - 1); range.maxY = Min(Max(range.maxY, 0), numCellsY - 1);
+	range.minZ = Min(Max(range.minZ, 0), numCellsZ - 1); range.maxZ = Min(Max(range.maxZ, 0), numCellsZ - 1);
+
+	return range;
+}
+// Gets the index of the specified cell in the cell list
+int UniformGrid::GetIndex(int x, int y, int z) {
+	return (z * numCellsX) + x + (y * numCellsX * numCellsZ);
+}
+// Gets the bounding box of the specified cell
+void UniformGrid::GetCellBox(int x, int y, int z, Vector3* boxMin, Vector3* boxMax) {
+	boxMin->x = -(worldSizeX / 2.0f) + x * cellSizeX;
+	boxMin->y = -(worldSizeY / 2.0f) + y * cellSizeY;
+	boxMin->z = (worldSizeZ / 2.0f) - (z + 1) * cellSizeZ;
+	boxMax->x = boxMin->x + cellSizeX;
+	boxMax->y = boxMin->y + cellSizeY;
+	boxMax->z = boxMin->z + cellSizeZ;
+
+	// The cells along the edge also hold everything outside the world, so they reach out forever
+	if(x == 0) boxMin->x = -FLT_MAX;
+	if(x == numCellsX - 1) boxMax->x = FLT_MAX;
+	if(y == 0) boxMin->y = -FLT_MAX;
+	if(y == numCellsY - 1) boxMax->y = FLT_MAX;
+	if(z == 0) boxMax->z = FLT_MAX;
+	if(z == numCellsZ - 1) boxMin->z = -FLT_MAX;
+}
\ No newline at end of file
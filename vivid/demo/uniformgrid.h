@@ -0,0 +1,59 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef uniformgrid_h
+#define uniformgrid_h
+#include "vmath.h"
+#include "cell.h"
+#include "spatialindex.h"
+
+// A box of cells along the X, Y, and Z axes; the min and max cells are included
+struct CellRange {
+	int minX, minY, minZ; // First cell along each axis
+	int maxX, maxY, maxZ; // Last cell along each axis
+};
+
+// Divides the world into equally sized cells; every cell is allocated up front
+// Good for small, densely filled worlds
+class UniformGrid : public SpatialIndex {
+public:
+	UniformGrid(float nWorldSizeX, float nWorldSizeY, float nWorldSizeZ, float nCellSizeX, float nCellSizeY, float nCellSizeZ);
+	void GetCells(Vector3 center, float radius, std::vector<Cell*>* cells); // Gets every cell overlapped by the bounding box of the sphere
+	Cell* GetCell(Vector3 pos); // Gets the cell at the position specified
+	void GetAllCells(std::vector<Cell*>* cells); // Gets every cell
+	int GetNumCells(); // Gets the number of cells
+	void QuerySphere(Vector3 center, float radius, std::vector<Cell*>* cells); // Gets the cells touching the sphere
+	void QueryFrustum(Frustum* frustum, std::vector<Cell*>* cells); // Gets the cells at least partially inside the frustum
+	// Gets the cells the ray passes through before it has traveled the specified length
+	void QueryRay(Vector3 origin, Vector3 direction, float length, std::vector<Cell*>* cells);
+protected:
+	CellRange GetCellRange(Vector3* boxMin, Vector3* boxMax); // Gets the cells overlapped by the box; clamped to the grid
+	int GetIndex(int x, int y, int z); // Gets the index of the specified cell in the cell list
+	// Gets the bounding box of the specified cell; the cells along the edge reach out forever
+	void GetCellBox(int x, int y, int z, Vector3* boxMin, Vector3* boxMax);
+	float worldSizeX; // World size along the X axis
+	float worldSizeY; // World size along the Y axis
+	float worldSizeZ; // World size along the Z axis
+	float cellSizeX; // Cell size along the X axis
+	float cellSizeY; // Cell size along the Y axis
+	float cellSizeZ; // Cell size along the Z axis
+	int numCellsX; // Number of cells along the X axis
+	int numCellsY; // Number of cells along the Y axis
+	int numCellsZ; // Number of cells along the Z axis
+	int numCells; // Total number of cells
+	std::vector<Cell> cells; // List of cells in the world; never resized, so pointers to cells stay valid
+};
+
+#endif
\ No newline at end of file
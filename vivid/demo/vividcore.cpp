@@ -0,0 +1,95 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "vividcore.h"
+#include "thread.h"
+#include <fstream>
+#include <string.h>
+
+vvd::FrameStats vvd::frameStats;
+std::ofstream* vvd::logFile = 0;
+static VVD_THREAD_LOCAL vvd::FrameStats* threadFrameStats = 0; // Statistics the calling thread counts into; 0 for frameStats
+
+// Gets the statistics for the current frame
+vvd::FrameStats* vvd::GetFrameStats() {
+	if(threadFrameStats)
+		return threadFrameStats;
+	return &frameStats;
+}
+// Makes GetFrameStats() return stats on the calling thread; returns the previous stats
+vvd::FrameStats* vvd::SetThreadFrameStats(FrameStats* stats) {
+	FrameStats* previous = threadFrameStats;
+	threadFrameStats = stats;
+	return previous;
+}
+// Adds stats to total
+void vvd::AddFrameStats(FrameStats* total, const FrameStats* stats) {
+	total->scenes += stats->scenes;
+	total->stateChanges += stats->stateChanges;
+	total->techniqueChanges += stats->techniqueChanges;
+	total->matrixUploads += stats->matrixUploads;
+	total->vectorUploads += stats->vectorUploads;
+	total->scalarUploads += stats->scalarUploads;
+	total->textureUploads += stats->textureUploads;
+	total->effectBegins += stats->effectBegins;
+	total->passes += stats->passes;
+	total->drawCalls += stats->drawCalls;
+	total->instancedDrawCalls += stats->instancedDrawCalls;
+	total->instances += stats->instances;
+	total->deviceStateChanges += stats->deviceStateChanges;
+	total->deviceConstantUploads += stats->deviceConstantUploads;
+	total->deviceConstants += stats->deviceConstants;
+	total->deviceDrawCalls += stats->deviceDrawCalls;
+	total->devicePrimitives += stats->devicePrimitives;
+	total->meshesDrawn += stats->meshesDrawn;
+	total->meshesCulled += stats->meshesCulled;
+	total->meshesOccluded += stats->meshesOccluded;
+	total->occluders += stats->occluders;
+	total->occluderTriangles += stats->occluderTriangles;
+	total->occlusionTime += stats->occlusionTime;
+	total->shadowFaces += stats->shadowFaces;
+	total->shadowFacesCached += stats->shadowFacesCached;
+	total->shadowCasters += stats->shadowCasters;
+	total->shadowCastersCulled += stats->shadowCastersCulled;
+	total->matrixBuilds += stats->matrixBuilds;
+	total->lightSelections += stats->lightSelections;
+	total->lightArrays += stats->lightArrays;
+	total->lightArraysSkipped += stats->lightArraysSkipped;
+	total->inputLatency += stats->inputLatency;
+	total->inputLatencyFrames += stats->inputLatencyFrames;
+}
+// Zeroes the frame statistics; called by Update()
+void vvd::ResetFrameStats() {
+	memset(&frameStats, 0, sizeof(frameStats));
+}
+// Writes a line in the log file if logging is #defined; does nothing if the log file isn't open
+void vvd::Log(const char* msg) {
+#ifdef logging
+	if(logFile)
+		*logFile << msg << "\n";
+#endif
+}
+// Writes a number to the log file if logging is #defined; does nothing if the log file isn't open
+void vvd::Log(float num) {
+#ifdef logging
+	if(logFile)
+		*logFile << num << "\n";
+#endif
+}
+void vvd::Log(int num) {
+#ifdef logging
+	if(logFile)
+		*logFile << num << "\n";
+#endif
+}
\ No newline at end of file
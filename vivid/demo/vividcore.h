@@ -0,0 +1,81 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef vividcore_h
+#define vividcore_h
+#define logging
+#include <iosfwd>
+
+// The parts of Vivid that don't need Windows or Direct3D; the math, transforms and spatial
+// indexing only include this and vmath.h, so they build on other platforms too
+namespace vvd {
+	//
+	// Statistics functionality
+	//
+	// Counts of the calls made to the graphics card during a frame
+	struct FrameStats {
+		int scenes; // BeginScene()/EndScene() pairs
+		int stateChanges; // Viewports, render states and render targets the Renderer set on the device
+		int techniqueChanges; // Effect techniques set
+		int matrixUploads; // Effect SetMatrix()/SetMatrixArray() calls
+		int vectorUploads; // Effect SetVector()/SetVectorArray() calls
+		int scalarUploads; // Effect SetFloat()/SetFloatArray()/SetInt() calls
+		int textureUploads; // Effect SetTexture() calls
+		int effectBegins; // Effect Begin() calls
+		int passes; // Effect BeginPass() calls
+		int drawCalls; // Subsets drawn
+		int instancedDrawCalls; // Subsets drawn with hardware instancing; included in drawCalls
+		int instances; // Mesh copies drawn by instanced draw calls
+		// Counted by the CountingDevice on the null device; they include the calls D3DX meshes and effects make
+		int deviceStateChanges; // Render states, sampler states, textures, shaders, streams and targets set
+		int deviceConstantUploads; // SetVertexShaderConstant*()/SetPixelShaderConstant*() calls
+		int deviceConstants; // Shader constant registers uploaded by those calls
+		int deviceDrawCalls; // DrawPrimitive*() and DrawIndexedPrimitive*() calls
+		int devicePrimitives; // Primitives drawn by those calls
+		int meshesDrawn; // Meshes that passed frustum culling
+		int meshesCulled; // Meshes skipped by frustum culling
+		int meshesOccluded; // Meshes skipped because the occluders hide them
+		int occluders; // Occluder meshes drawn into the occlusion buffer
+		int occluderTriangles; // Occluder triangles rasterized
+		float occlusionTime; // Milliseconds spent drawing occluders and testing meshes against them
+		int shadowFaces; // Shadow map cube faces rendered
+		int shadowFacesCached; // Shadow map cube faces skipped because nothing inside them changed
+		int shadowCasters; // Meshes rendered into shadow map faces
+		int shadowCastersCulled; // Meshes skipped for shadow map faces; out of range or outside the face
+		int matrixBuilds; // Transform matrices rebuilt because the transform changed
+		int lightSelections; // Meshes whose lights were ranked again because something moved
+		int lightArrays; // Light arrays compiled and sent to an effect
+		int lightArraysSkipped; // Light arrays not sent because the effect already had the same lights
+		float inputLatency; // Milliseconds from reading the input to presenting the frame drawn from it; RenderPipeline only
+		int inputLatencyFrames; // Frames submitted from reading the input to presenting it, that one included; RenderPipeline only
+	};
+	extern FrameStats frameStats; // Statistics for the current frame
+	void ResetFrameStats(); // Zeroes the frame statistics; called by Update()
+	FrameStats* GetFrameStats(); // Gets the statistics for the current frame; jobs and the render thread count into their own
+	// Makes GetFrameStats() return stats on the calling thread; 0 goes back to the frame's. Returns the previous stats
+	FrameStats* SetThreadFrameStats(FrameStats* stats);
+	void AddFrameStats(FrameStats* total, const FrameStats* stats); // Adds stats to total
+	//
+	// Logging functionality
+	//
+	extern std::ofstream* logFile; // Log file for logging; 0 until OpenLog() opens it
+	// Writes a line in the log file if logging is #defined; does nothing if the log file isn't open
+	void Log(const char* msg);
+	// Writes a number to the log file if logging is #defined; does nothing if the log file isn't open
+	void Log(float num);
+	void Log(int num);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,296 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef vmath_h
+#define vmath_h
+#include <math.h>
+
+// The math types don't need Windows; on Windows they convert to and from the D3DX types,
+// which have the same memory layout. Define VVD_NO_D3DX to leave D3DX out there too
+#if !defined(_WIN32) && !defined(VVD_NO_D3DX)
+#define VVD_NO_D3DX
+#endif
+#ifndef VVD_NO_D3DX
+#include <d3dx9.h>
+#endif
+
+// Lets the constructors run at compile time on compilers that support it
+#if __cplusplus >= 201103L
+#define VVD_CONSTEXPR constexpr
+#else
+#define VVD_CONSTEXPR
+#endif
+
+#define VVD_PI 3.141592654f
+
+// Smaller of two values; the windows.h macros aren't available everywhere
+template<class T> inline T Min(T a, T b) {
+	return a < b ? a : b;
+}
+// Larger of two values
+template<class T> inline T Max(T a, T b) {
+	return a > b ? a : b;
+}
+
+// Three component vector; same layout as D3DXVECTOR3
+struct Vector3 {
+	float x, y, z;
+	Vector3() {}
+	VVD_CONSTEXPR Vector3(float nx, float ny, float nz) : x(nx), y(ny), z(nz) {}
+	Vector3 operator+(const Vector3& v) const { return Vector3(x + v.x, y + v.y, z + v.z); }
+	Vector3 operator-(const Vector3& v) const { return Vector3(x - v.x, y - v.y, z - v.z); }
+	Vector3 operator*(float f) const { return Vector3(x * f, y * f, z * f); }
+	Vector3 operator/(float f) const { return Vector3(x / f, y / f, z / f); }
+	Vector3 operator-() const { return Vector3(-x, -y, -z); }
+	Vector3& operator+=(const Vector3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+	Vector3& operator-=(const Vector3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+	Vector3& operator*=(float f) { x *= f; y *= f; z *= f; return *this; }
+	bool operator==(const Vector3& v) const { return x == v.x && y == v.y && z == v.z; }
+	bool operator!=(const Vector3& v) const { return !(*this == v); }
+	float Dot(const Vector3& v) const { return x * v.x + y * v.y + z * v.z; } // Dot product
+	Vector3 Cross(const Vector3& v) const { return Vector3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); } // Cross product
+	float LengthSq() const { return Dot(*this); } // Squared length
+	float Length() const { return sqrtf(LengthSq()); } // Length
+	Vector3 Normalized() const { float l = Length(); return l > 0.0f ? *this / l : *this; } // Unit length copy; zero stays zero
+	static Vector3 Lerp(const Vector3& a, const Vector3& b, float t) { return a + (b - a) * t; } // Linear interpolation
+#ifndef VVD_NO_D3DX
+	Vector3(const D3DXVECTOR3& v) : x(v.x), y(v.y), z(v.z) {}
+	operator D3DXVECTOR3() const { return D3DXVECTOR3(x, y, z); }
+#endif
+};
+
+// Four component vector; same layout as D3DXVECTOR4
+struct Vector4 {
+	float x, y, z, w;
+	Vector4() {}
+	VVD_CONSTEXPR Vector4(float nx, float ny, float nz, float nw) : x(nx), y(ny), z(nz), w(nw) {}
+	VVD_CONSTEXPR Vector4(const Vector3& v, float nw) : x(v.x), y(v.y), z(v.z), w(nw) {}
+	Vector4 operator+(const Vector4& v) const { return Vector4(x + v.x, y + v.y, z + v.z, w + v.w); }
+	Vector4 operator-(const Vector4& v) const { return Vector4(x - v.x, y - v.y, z - v.z, w - v.w); }
+	Vector4 operator*(float f) const { return Vector4(x * f, y * f, z * f, w * f); }
+	bool operator==(const Vector4& v) const { return x == v.x && y == v.y && z == v.z && w == v.w; }
+	bool operator!=(const Vector4& v) const { return !(*this == v); }
+	Vector3 XYZ() const { return Vector3(x, y, z); } // The first three components
+#ifndef VVD_NO_D3DX
+	Vector4(const D3DXVECTOR4& v) : x(v.x), y(v.y), z(v.z), w(v.w) {}
+	operator D3DXVECTOR4() const { return D3DXVECTOR4(x, y, z, w); }
+#endif
+};
+
+// Rotation quaternion; same layout and multiplication order as D3DXQUATERNION
+struct Quaternion {
+	float x, y, z, w;
+	Quaternion() {}
+	VVD_CONSTEXPR Quaternion(float nx, float ny, float nz, float nw) : x(nx), y(ny), z(nz), w(nw) {}
+	// Rotates by this quaternion, then by q
+	Quaternion operator*(const Quaternion& q) const {
+		return Quaternion(q.w * x + q.x * w + q.y * z - q.z * y,
+						  q.w * y - q.x * z + q.y * w + q.z * x,
+						  q.w * z + q.x * y - q.y * x + q.z * w,
+						  q.w * w - q.x * x - q.y * y - q.z * z);
+	}
+	bool operator==(const Quaternion& q) const { return x == q.x && y == q.y && z == q.z && w == q.w; }
+	bool operator!=(const Quaternion& q) const { return !(*this == q); }
+	float Dot(const Quaternion& q) const { return x * q.x + y * q.y + z * q.z + w * q.w; } // Dot product
+	Quaternion Conjugate() const { return Quaternion(-x, -y, -z, w); } // The opposite rotation of a unit quaternion
+	// Unit length copy
+	Quaternion Normalized() const {
+		float l = sqrtf(Dot(*this));
+		return l > 0.0f ? Quaternion(x / l, y / l, z / l, w / l) : Identity();
+	}
+	static Quaternion Identity() { return Quaternion(0.0f, 0.0f, 0.0f, 1.0f); } // No rotation
+	// Rotation around the axis by the angle in radians
+	static Quaternion RotationAxis(const Vector3& axis, float angle) {
+		Vector3 a = axis.Normalized() * sinf(angle * 0.5f);
+		return Quaternion(a.x, a.y, a.z, cosf(angle * 0.5f));
+	}
+	// Rotation around Z (roll), then X (pitch), then Y (yaw); the same order as Transform's Euler angles
+	static Quaternion RotationYawPitchRoll(float yaw, float pitch, float roll) {
+		float sy = sinf(yaw * 0.5f), cy = cosf(yaw * 0.5f);
+		float sp = sinf(pitch * 0.5f), cp = cosf(pitch * 0.5f);
+		float sr = sinf(roll * 0.5f), cr = cosf(roll * 0.5f);
+		return Quaternion(cy * sp * cr + sy * cp * sr,
+						  sy * cp * cr - cy * sp * sr,
+						  cy * cp * sr - sy * sp * cr,
+						  cy * cp * cr + sy * sp * sr);
+	}
+	// Normalized linear interpolation along the shortest arc; no trig, but the speed isn't constant
+	static Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t) {
+		float sign = a.Dot(b) < 0.0f ? -1.0f : 1.0f;
+		float s = 1.0f - t;
+		t *= sign;
+		return Quaternion(a.x * s + b.x * t, a.y * s + b.y * t, a.z * s + b.z * t, a.w * s + b.w * t).Normalized();
+	}
+	// Spherical interpolation along the shortest arc at constant speed; falls back to Nlerp
+	// when the rotations are so close that the two give the same result
+	static Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t) {
+		float cosAngle = a.Dot(b);
+		float sign = 1.0f;
+		if(cosAngle < 0.0f) {
+			cosAngle = -cosAngle;
+			sign = -1.0f;
+		}
+		if(cosAngle > 0.9995f)
+			return Nlerp(a, b, t);
+		float angle = acosf(cosAngle);
+		float invSin = 1.0f / sinf(angle);
+		float s = sinf((1.0f - t) * angle) * invSin;
+		t = sinf(t * angle) * invSin * sign;
+		return Quaternion(a.x * s + b.x * t, a.y * s + b.y * t, a.z * s + b.z * t, a.w * s + b.w * t);
+	}
+#ifndef VVD_NO_D3DX
+	Quaternion(const D3DXQUATERNION& q) : x(q.x), y(q.y), z(q.z), w(q.w) {}
+	operator D3DXQUATERNION() const { return D3DXQUATERNION(x, y, z, w); }
+#endif
+};
+
+// Plane ax + by + cz + d = 0; same layout as D3DXPLANE
+struct Plane {
+	float a, b, c, d;
+	Plane() {}
+	VVD_CONSTEXPR Plane(float na, float nb, float nc, float nd) : a(na), b(nb), c(nc), d(nd) {}
+	float DotCoord(const Vector3& v) const { return a * v.x + b * v.y + c * v.z + d; } // Signed distance to a point if normalized
+	float DotNormal(const Vector3& v) const { return a * v.x + b * v.y + c * v.z; } // Dot product with the normal
+	// Copy with a unit length normal
+	Plane Normalized() const {
+		float l = sqrtf(a * a + b * b + c * c);
+		return l > 0.0f ? Plane(a / l, b / l, c / l, d / l) : *this;
+	}
+#ifndef VVD_NO_D3DX
+	Plane(const D3DXPLANE& p) : a(p.a), b(p.b), c(p.c), d(p.d) {}
+	operator D3DXPLANE() const { return D3DXPLANE(a, b, c, d); }
+#endif
+};
+
+// Row major 4x4 matrix for row vectors; same layout and conventions as D3DXMATRIX, so it can be
+// handed straight to effects. The rows are contiguous, so four floats load into one SSE register
+struct Matrix {
+	union {
+		struct {
+			float _11, _12, _13, _14;
+			float _21, _22, _23, _24;
+			float _31, _32, _33, _34;
+			float _41, _42, _43, _44;
+		};
+		float m[4][4];
+	};
+	Matrix() {}
+	Matrix(float n11, float n12, float n13, float n14,
+		   float n21, float n22, float n23, float n24,
+		   float n31, float n32, float n33, float n34,
+		   float n41, float n42, float n43, float n44) {
+		_11 = n11; _12 = n12; _13 = n13; _14 = n14;
+		_21 = n21; _22 = n22; _23 = n23; _24 = n24;
+		_31 = n31; _32 = n32; _33 = n33; _34 = n34;
+		_41 = n41; _42 = n42; _43 = n43; _44 = n44;
+	}
+	// Applies this matrix, then mat
+	Matrix operator*(const Matrix& mat) const {
+		Matrix r;
+		for(int i = 0; i < 4; i++) {
+			for(int j = 0; j < 4; j++)
+				r.m[i][j] = m[i][0] * mat.m[0][j] + m[i][1] * mat.m[1][j] + m[i][2] * mat.m[2][j] + m[i][3] * mat.m[3][j];
+		}
+		return r;
+	}
+	bool operator==(const Matrix& mat) const {
+		for(int i = 0; i < 4; i++) {
+			for(int j = 0; j < 4; j++) {
+				if(m[i][j] != mat.m[i][j])
+					return false;
+			}
+		}
+		return true;
+	}
+	bool operator!=(const Matrix& mat) const { return !(*this == mat); }
+	Vector3 GetRow(int row) const { return Vector3(m[row][0], m[row][1], m[row][2]); } // The first three elements of a row
+	// Transforms a point, dividing by w
+	Vector3 TransformCoord(const Vector3& v) const {
+		float x = v.x * _11 + v.y * _21 + v.z * _31 + _41;
+		float y = v.x * _12 + v.y * _22 + v.z * _32 + _42;
+		float z = v.x * _13 + v.y * _23 + v.z * _33 + _43;
+		float w = v.x * _14 + v.y * _24 + v.z * _34 + _44;
+		return w != 0.0f ? Vector3(x / w, y / w, z / w) : Vector3(x, y, z);
+	}
+	// Transforms a point without dividing by w; for clip space
+	Vector4 Transform(const Vector3& v) const {
+		return Vector4(v.x * _11 + v.y * _21 + v.z * _31 + _41, v.x * _12 + v.y * _22 + v.z * _32 + _42,
+					   v.x * _13 + v.y * _23 + v.z * _33 + _43, v.x * _14 + v.y * _24 + v.z * _34 + _44);
+	}
+	// Transforms a direction; ignores the translation
+	Vector3 TransformNormal(const Vector3& v) const {
+		return Vector3(v.x * _11 + v.y * _21 + v.z * _31, v.x * _12 + v.y * _22 + v.z * _32, v.x * _13 + v.y * _23 + v.z * _33);
+	}
+	// Swaps the rows and columns
+	Matrix Transposed() const {
+		return Matrix(_11, _21, _31, _41, _12, _22, _32, _42, _13, _23, _33, _43, _14, _24, _34, _44);
+	}
+	static Matrix Identity() { return Scaling(1.0f, 1.0f, 1.0f); } // Does nothing
+	static Matrix Scaling(float x, float y, float z) { // Scales along the axes
+		return Matrix(x, 0.0f, 0.0f, 0.0f, 0.0f, y, 0.0f, 0.0f, 0.0f, 0.0f, z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	static Matrix Translation(float x, float y, float z) { // Moves by the offset
+		return Matrix(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y, z, 1.0f);
+	}
+	static Matrix RotationX(float angle) { // Rotates around the X axis
+		float c = cosf(angle), s = sinf(angle);
+		return Matrix(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, c, s, 0.0f, 0.0f, -s, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	static Matrix RotationY(float angle) { // Rotates around the Y axis
+		float c = cosf(angle), s = sinf(angle);
+		return Matrix(c, 0.0f, -s, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, s, 0.0f, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	static Matrix RotationZ(float angle) { // Rotates around the Z axis
+		float c = cosf(angle), s = sinf(angle);
+		return Matrix(c, s, 0.0f, 0.0f, -s, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	static Matrix RotationQuaternion(const Quaternion& q) { // Rotates by a unit quaternion
+		float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+		return Matrix(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f,
+					  2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f,
+					  2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f,
+					  0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	static Matrix LookAtLH(const Vector3& eye, const Vector3& at, const Vector3& up) { // View matrix; same as D3DXMatrixLookAtLH
+		Vector3 zAxis = (at - eye).Normalized();
+		Vector3 xAxis = up.Cross(zAxis).Normalized();
+		Vector3 yAxis = zAxis.Cross(xAxis);
+		return Matrix(xAxis.x, yAxis.x, zAxis.x, 0.0f, xAxis.y, yAxis.y, zAxis.y, 0.0f, xAxis.z, yAxis.z, zAxis.z, 0.0f,
+					  -xAxis.Dot(eye), -yAxis.Dot(eye), -zAxis.Dot(eye), 1.0f);
+	}
+	static Matrix PerspectiveFovLH(float fovY, float aspect, float zn, float zf) { // Projection matrix; same as D3DXMatrixPerspectiveFovLH
+		float yScale = 1.0f / tanf(fovY * 0.5f);
+		float xScale = yScale / aspect;
+		return Matrix(xScale, 0.0f, 0.0f, 0.0f, 0.0f, yScale, 0.0f, 0.0f, 0.0f, 0.0f, zf / (zf - zn), 1.0f,
+					  0.0f, 0.0f, -zn * zf / (zf - zn), 0.0f);
+	}
+#ifndef VVD_NO_D3DX
+	Matrix(const D3DXMATRIX& mat) { *this = *(const Matrix*)&mat; }
+	operator D3DXMATRIX() const { return D3DXMATRIX(&_11); }
+#endif
+};
+
+#ifndef VVD_NO_D3DX
+// The types are passed to D3DX and effects by pointer, so the layouts have to match exactly
+typedef char vmath_vector3_check[sizeof(Vector3) == sizeof(D3DXVECTOR3) ? 1 : -1];
+typedef char vmath_vector4_check[sizeof(Vector4) == sizeof(D3DXVECTOR4) ? 1 : -1];
+typedef char vmath_quaternion_check[sizeof(Quaternion) == sizeof(D3DXQUATERNION) ? 1 : -1];
+typedef char vmath_plane_check[sizeof(Plane) == sizeof(D3DXPLANE) ? 1 : -1];
+typedef char vmath_matrix_check[sizeof(Matrix) == sizeof(D3DXMATRIX) ? 1 : -1];
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef xfile_h
+#define xfile_h
+#include "vmath.h"
+#include "mappedfile.h"
+#include <vector>
+#include <string>
+#include <map>
+
+// A material read from an X file
+struct XMaterial {
+	Vector4 diffuse; // Face color
+	float power; // Specular exponent
+	Vector3 specular; // Specular color
+	Vector3 emissive; // Emissive color
+	std::string textureFilename; // Empty if the material has no texture
+};
+
+// Every mesh in an X file merged into flat arrays, with the frame transforms applied; the same thing
+// D3DXLoadMeshFromX builds. Vertices are split wherever a position has more than one normal
+struct XMeshData {
+	std::vector<Vector3> positions; // One per vertex
+	std::vector<Vector3> normals; // One per vertex; empty if the file has no normals
+	std::vector<float> texcoords; // Two per vertex; empty if the file has no texture coordinates
+	std::vector<unsigned int> indices; // Three per triangle
+	std::vector<unsigned int> attributes; // Material of each triangle
+	std::vector<XMaterial> materials; // Materials used by the triangles
+};
+
+// Kinds of tokens handed to the parser; the text and binary formats produce the same stream
+enum XTokenType {
+	XTOKEN_END, // End of the file
+	XTOKEN_ERROR, // Malformed token
+	XTOKEN_NAME, // Identifier
+	XTOKEN_STRING, // Quoted string
+	XTOKEN_NUMBER, // Integer or float
+	XTOKEN_OBRACE, // {
+	XTOKEN_CBRACE, // }
+	XTOKEN_OTHER // GUIDs, brackets and template keywords; only seen while skipping
+};
+
+// A token; text points into the file, so nothing is copied
+struct XToken {
+	XTokenType type;
+	const char* text; // Names and strings; not null terminated
+	size_t length; // Length of text
+	double number; // Numbers
+};
+
+// Parses DirectX .x files (xof 0302/0303, txt and uncompressed bin) without D3DX. Reads the Header, Frame,
+// FrameTransformMatrix, Mesh, MeshNormals, MeshTextureCoords, MeshMaterialList, Material and TextureFilename
+// objects and skips everything else. An XFile holds no shared state, so separate ones can parse in parallel
+class XFile {
+public:
+	XFile();
+	bool Load(const char* file, XMeshData* mesh); // Maps and parses the file; returns false on errors
+	bool Parse(const char* data, size_t size, XMeshData* mesh); // Parses a file already in memory
+	const char* GetError(); // Describes the last error
+protected:
+	bool ParseObject(XToken* type, Matrix* parentMatrix); // Parses a data object whose type token was just read
+	bool ParseFrame(Matrix* parentMatrix); // Parses the body of a Frame
+	bool ParseMesh(Matrix* worldMatrix); // Parses the body of a Mesh and adds it to the output
+	bool ParseFaces(std::vector<unsigned int>* faces); // Reads a face count and the faces as count, index, index...
+	bool ParseMaterialList(std::vector<unsigned int>* faceMaterials, std::vector<XMaterial>* materials);
+	bool ParseMaterial(XMaterial* material); // Parses the body of a Material
+	bool ParseTextureFilename(std::string* filename); // Parses the body of a TextureFilename
+	bool SkipObject(); // Skips the rest of an object whose opening brace was just read
+	bool OpenObject(); // Skips the optional name and GUID of an object and reads its opening brace
+	bool ReadNumber(double* number); // Reads the next token as a number
+	bool ReadCount(unsigned int* count); // Reads the next token as an element count
+	// Fails unless the rest of the file could hold count elements made of the specified number of numbers;
+	// call it before allocating anything from a count the file gave
+	bool CheckCount(unsigned int count, unsigned int numbers);
+	bool ReadFloat(float* number); // Reads the next token as a float
+	bool ReadString(std::string* string); // Reads the next token as a string
+	bool Expect(XTokenType type); // Reads the next token and fails unless it has the type specified
+	bool Fail(const char* message); // Sets the error message and returns false
+	bool IsName(XToken* token, const char* name); // Returns true if the token is the name specified
+	XToken Next(); // Reads the next token
+	XToken NextText(); // Reads the next token of a text file
+	XToken NextBinary(); // Reads the next token of a binary file
+
+	const char* data; // File contents
+	const char* pos; // Read position
+	const char* end; // End of the contents
+	bool binary; // True for the binary format
+	bool doubles; // True if binary float lists hold doubles
+	unsigned int listCount; // Numbers left in the current binary list
+	bool listFloats; // True if the current binary list holds floats
+	int line; // Current line of a text file; for error messages
+	std::string error; // Description of the last error
+	XMeshData* output; // Mesh being built
+	std::map<std::string, XMaterial> namedMaterials; // Top level materials that meshes refer to by name
+	MappedFile file; // The file being parsed by Load()
+};
+
+#endif
\ No newline at end of file
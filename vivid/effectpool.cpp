@@ -0,0 +1,158 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "effectpool.h"
+
+int EffectPool::numCompiled = 0;
+
+// Gets a clone of the effect in the file, and a reference to the compiled effect's cache entry
+ID3DXEffect* EffectPool::CreateEffect(LPCSTR file, Resource** resource) {
+	Resource* cached = ResourceCache::Find(RESOURCE_EFFECT, file);
+	if(cached)
+		ResourceCache::AddRef(cached);
+	else
+		cached = ResourceCache::Add(RESOURCE_EFFECT, file, Load(file));
+	*resource = cached;
+
+	// Clones share the compiled shaders; only the parameters are copied
+	ID3DXEffect* effect = 0;
+	if(FAILED(((ID3DXEffect*)cached->data)->CloneEffect(vvd::GetDevice(), &effect))) {
+		std::string msg = "Vivid: Failed to clone effect: ";
+		msg += file;
+		vvd::Log(msg.c_str());
+		exit(1);
+	}
+	return effect;
+}
+// Gets the number of effects compiled from source this run
+int EffectPool::GetNumCompiled() {
+	return numCompiled;
+}
+// Creates the effect from the compiled effect file if it matches the source, otherwise compiles
+// the source and writes the compiled effect file
+ID3DXEffect* EffectPool::Load(LPCSTR file) {
+	std::string msg;
+	IDirect3DDevice9* device = vvd::GetDevice();
+	ID3DXEffect* effect = 0;
+	ID3DXBuffer* errorBuffer = 0;
+
+	std::vector<BYTE> source;
+	if(!ReadFile(file, &source)) {
+		msg = "Vivid: Failed to load effect file: ";
+		msg += file;
+		vvd::Log(msg.c_str());
+		exit(1);
+	}
+	DWORD sourceHash = Hash(&source[0], source.size());
+
+	// Use the compiled effect if it was compiled from the same source with the same flags
+	std::string compiledFile = file;
+	compiledFile += COMPILED_EFFECT_EXTENSION;
+	std::vector<BYTE> compiled;
+	if(ReadFile(compiledFile.c_str(), &compiled) && compiled.size() >= sizeof(CompiledEffectHeader)) {
+		CompiledEffectHeader* header = (CompiledEffectHeader*)&compiled[0];
+		if(header->magic == COMPILED_EFFECT_MAGIC && header->version == COMPILED_EFFECT_VERSION &&
+			header->sourceHash == sourceHash && header->sourceSize == (DWORD)source.size() &&
+			header->flags == EFFECT_COMPILE_FLAGS && sizeof(CompiledEffectHeader) + header->size <= compiled.size()) {
+			if(SUCCEEDED(D3DXCreateEffect(device, &compiled[sizeof(CompiledEffectHeader)], header->size,
+				0, 0, EFFECT_CREATE_FLAGS, 0, &effect, &errorBuffer))) {
+				msg = "Vivid: Loaded compiled effect: ";
+				msg += compiledFile;
+				vvd::Log(msg.c_str());
+				return effect;
+			}
+			vvd::Release<ID3DXBuffer*>(errorBuffer); // Stale; compile it again
+		}
+	}
+
+	// Compile the source
+	ID3DXEffectCompiler* compiler = 0;
+	if(FAILED(D3DXCreateEffectCompiler((LPCSTR)&source[0], (UINT)source.size(), 0, 0,
+		EFFECT_COMPILE_FLAGS, &compiler, &errorBuffer))) {
+		LogErrors(file, errorBuffer);
+	}
+	ID3DXBuffer* bytecode = 0;
+	if(FAILED(compiler->CompileEffect(EFFECT_COMPILE_FLAGS, &bytecode, &errorBuffer))) {
+		vvd::Release<ID3DXEffectCompiler*>(compiler);
+		LogErrors(file, errorBuffer);
+	}
+	vvd::Release<ID3DXEffectCompiler*>(compiler);
+	numCompiled++;
+
+	if(FAILED(D3DXCreateEffect(device, bytecode->GetBufferPointer(), bytecode->GetBufferSize(),
+		0, 0, EFFECT_CREATE_FLAGS, 0, &effect, &errorBuffer))) {
+		vvd::Release<ID3DXBuffer*>(bytecode);
+		LogErrors(file, errorBuffer);
+	}
+
+	// Save the bytecode for next time
+	CompiledEffectHeader header;
+	header.magic = COMPILED_EFFECT_MAGIC;
+	header.version = COMPILED_EFFECT_VERSION;
+	header.sourceHash = sourceHash;
+	header.sourceSize = (DWORD)source.size();
+	header.flags = EFFECT_COMPILE_FLAGS;
+	header.size = bytecode->GetBufferSize();
+	std::ofstream out(compiledFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(out.is_open()) {
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)bytecode->GetBufferPointer(), header.size);
+	} else {
+		msg = "Vivid: Couldn't write compiled effect: ";
+		msg += compiledFile;
+		vvd::Log(msg.c_str());
+	}
+	vvd::Release<ID3DXBuffer*>(bytecode);
+
+	msg = "Vivid: Compiled effect: ";
+	msg += file;
+	vvd::Log(msg.c_str());
+	return effect;
+}
+// Reads a whole file; returns false if it can't be read
+bool EffectPool::ReadFile(LPCSTR file, std::vector<BYTE>* data) {
+	std::ifstream in(file, std::ios::in | std::ios::binary);
+	if(!in.is_open())
+		return false;
+	in.seekg(0, std::ios::end);
+	size_t size = (size_t)in.tellg();
+	in.seekg(0, std::ios::beg);
+	if(size == 0)
+		return false;
+	data->resize(size);
+	in.read((char*)&(*data)[0], (std::streamsize)size);
+	return !in.fail();
+}
+// FNV-1a hash of some bytes
+DWORD EffectPool::Hash(const BYTE* data, size_t size) {
+	DWORD hash = 2166136261u;
+	for(size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+// Logs the compile errors and exits
+void EffectPool::LogErrors(LPCSTR file, ID3DXBuffer* errors) {
+	std::string msg = "Vivid: Failed to load effect file: ";
+	msg += file;
+	vvd::Log(msg.c_str());
+	// Output any errors to the log file
+	if(errors) {
+		vvd::Log((LPCSTR)errors->GetBufferPointer());
+		vvd::Release<ID3DXBuffer*>(errors);
+	}
+	exit(1);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef effectpool_h
+#define effectpool_h
+#include "vivid.h"
+#include "resource.h"
+#include <vector>
+
+#define COMPILED_EFFECT_EXTENSION ".vfx" // Appended to the effect file name to get the compiled effect file name
+#define COMPILED_EFFECT_MAGIC 0x58464656 // "VFFX"
+#define COMPILED_EFFECT_VERSION 1 // Bump whenever the layout changes
+
+// Shader compile flags; debug shaders are much slower to compile and run, so only debug builds use them
+#ifdef _DEBUG
+#define EFFECT_COMPILE_FLAGS (D3DXSHADER_DEBUG | D3DXSHADER_SKIPOPTIMIZATION)
+#else
+#define EFFECT_COMPILE_FLAGS 0
+#endif
+#define EFFECT_CREATE_FLAGS (D3DXFX_DONOTSAVESTATE | D3DXFX_DONOTSAVESHADERSTATE) // Effect creation flags
+
+// Start of a compiled effect file; followed by the effect bytecode
+struct CompiledEffectHeader {
+	DWORD magic; // COMPILED_EFFECT_MAGIC
+	DWORD version; // COMPILED_EFFECT_VERSION
+	DWORD sourceHash; // Hash of the effect source it was compiled from
+	DWORD sourceSize; // Size of the effect source it was compiled from
+	DWORD flags; // EFFECT_COMPILE_FLAGS it was compiled with
+	DWORD size; // Bytes of bytecode
+};
+
+// Compiles each effect file once per run, and only when it changed between runs. The compiled
+// effects live in the ResourceCache; users get clones, so they can set their own parameters
+class EffectPool {
+public:
+	// Gets a clone of the effect in the file; resource gets a reference to the compiled effect's
+	// cache entry, which the caller releases with ResourceCache::Release() when it releases the clone
+	static ID3DXEffect* CreateEffect(LPCSTR file, Resource** resource);
+	static int GetNumCompiled(); // Gets the number of effects compiled from source this run
+protected:
+	static int numCompiled; // Effects compiled from source this run
+	// Creates the effect from the compiled effect file if it matches the source, otherwise compiles
+	// the source and writes the compiled effect file
+	static ID3DXEffect* Load(LPCSTR file);
+	static bool ReadFile(LPCSTR file, std::vector<BYTE>* data); // Reads a whole file; returns false if it can't be read
+	static DWORD Hash(const BYTE* data, size_t size); // FNV-1a hash of some bytes
+	static void LogErrors(LPCSTR file, ID3DXBuffer* errors); // Logs the compile errors and exits
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "frustum.h"
+
+Frustum::Frustum() {
+	// Default to planes that contain everything
+	for(int i = 0; i < 6; i++) {
+		planes[i].a = 0.0f; planes[i].b = 0.0f; planes[i].c = 0.0f; planes[i].d = 1.0f;
+	}
+}
+// Extracts the planes from the specified view projection matrix
+Frustum::Frustum(Matrix* viewProj) {
+	Build(viewProj);
+}
+// Extracts the planes from the specified view projection matrix
+void Frustum::Build(Matrix* viewProj) {
+	Matrix& m = *viewProj;
+
+	// Left plane
+	planes[0].a = m._14 + m._11; planes[0].b = m._24 + m._21; planes[0].c = m._34 + m._31; planes[0].d = m._44 + m._41;
+	// Right plane
+	planes[1].a = m._14 - m._11; planes[1].b = m._24 - m._21; planes[1].c = m._34 - m._31; planes[1].d = m._44 - m._41;
+	// Bottom plane
+	planes[2].a = m._14 + m._12; planes[2].b = m._24 + m._22; planes[2].c = m._34 + m._32; planes[2].d = m._44 + m._42;
+	// Top plane
+	planes[3].a = m._14 - m._12; planes[3].b = m._24 - m._22; planes[3].c = m._34 - m._32; planes[3].d = m._44 - m._42;
+	// Near plane; D3D clips Z to [0, 1]
+	planes[4].a = m._13; planes[4].b = m._23; planes[4].c = m._33; planes[4].d = m._43;
+	// Far plane
+	planes[5].a = m._14 - m._13; planes[5].b = m._24 - m._23; planes[5].c = m._34 - m._33; planes[5].d = m._44 - m._43;
+
+	// Normalize the planes so the sphere test gives real distances
+	for(int i = 0; i < 6; i++) {
+		planes[i] = planes[i].Normalized();
+	}
+}
+// Returns true if the sphere is at least partially inside the frustum
+bool Frustum::Intersects(Vector3* center, float radius) {
+	for(int i = 0; i < 6; i++) {
+		if(planes[i].DotCoord(*center) < -radius)
+			return false; // Completely behind this plane
+	}
+	return true;
+}
+// Returns true if the axis aligned box is at least partially inside the frustum
+bool Frustum::IntersectsBox(Vector3* boxMin, Vector3* boxMax) {
+	for(int i = 0; i < 6; i++) {
+		// Test the corner furthest along the plane normal
+		Vector3 corner;
+		corner.x = planes[i].a >= 0.0f ? boxMax->x : boxMin->x;
+		corner.y = planes[i].b >= 0.0f ? boxMax->y : boxMin->y;
+		corner.z = planes[i].c >= 0.0f ? boxMax->z : boxMin->z;
+		if(planes[i].DotCoord(corner) < 0.0f)
+			return false; // Completely behind this plane
+	}
+	return true;
+}
+// Gets the specified plane; 0 left, 1 right, 2 bottom, 3 top, 4 near, 5 far
+Plane* Frustum::GetPlane(int index) {
+	return &planes[index];
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#ifndef frustum_h
+#define frustum_h
+#include "vmath.h"
+
+// The six clip planes of a view projection matrix; used for culling
+class Frustum {
+public:
+	Frustum();
+	Frustum(Matrix* viewProj); // Extracts the planes from the specified view projection matrix
+	void Build(Matrix* viewProj); // Extracts the planes from the specified view projection matrix
+	bool Intersects(Vector3* center, float radius); // Returns true if the sphere is at least partially inside the frustum
+	bool IntersectsBox(Vector3* boxMin, Vector3* boxMax); // Returns true if the axis aligned box is at least partially inside the frustum
+	Plane* GetPlane(int index); // Gets the specified plane; 0 left, 1 right, 2 bottom, 3 top, 4 near, 5 far
+protected:
+	Plane planes[6]; // Clip planes; the normals point into the frustum
+};
+
+#endif
\ No newline at end of file
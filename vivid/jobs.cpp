@@ -0,0 +1,171 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "jobs.h"
+#include "vmath.h"
+#include <string.h>
+#include <deque>
+#include <vector>
+
+// Jobs queued by one thread
+struct JobQueue {
+	Mutex mutex; // Guards jobs
+	std::deque<Job> jobs; // The owner takes from the back, thieves from the front
+};
+
+static JobQueue queues[MAX_JOB_THREADS]; // Queue 0 belongs to the threads outside the pool
+static Mutex statsMutex; // Guards the statistics of the counters
+static Thread threads[MAX_JOB_THREADS]; // Job threads; 0 is unused
+static Semaphore wake; // Signaled when jobs are queued
+static int numThreads = 1; // Threads running jobs, the calling thread included
+static bool started = false; // True once InitJobs() has been called
+static volatile bool stopping = false; // Tells the job threads to exit
+static VVD_THREAD_LOCAL int threadIndex = 0; // Queue of the current thread
+
+// Takes a job from the thread's own queue, or steals one from another thread; returns false if there are none
+static bool FindJob(Job* job) {
+	JobQueue* queue = &queues[threadIndex];
+	{
+		ScopedLock lock(&queue->mutex);
+		if(!queue->jobs.empty()) {
+			*job = queue->jobs.back();
+			queue->jobs.pop_back();
+			return true;
+		}
+	}
+	for(int i = 1; i < numThreads; i++) {
+		JobQueue* victim = &queues[(threadIndex + i) % numThreads];
+		ScopedLock lock(&victim->mutex);
+		if(!victim->jobs.empty()) {
+			*job = victim->jobs.front();
+			victim->jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+// Runs a job, adds its statistics to its counter, and counts it as done
+static void Execute(Job* job) {
+	vvd::FrameStats stats;
+	memset(&stats, 0, sizeof(stats));
+	vvd::FrameStats* previous = vvd::SetThreadFrameStats(&stats);
+	job->function(job->data, job->first, job->last);
+	vvd::SetThreadFrameStats(previous);
+	if(job->counter) {
+		{
+			ScopedLock lock(&statsMutex);
+			vvd::AddFrameStats(&job->counter->stats, &stats);
+		}
+		AtomicAdd(&job->counter->count, -1);
+	}
+}
+// Job thread body
+static void Work(void* index) {
+	threadIndex = (int)(size_t)index;
+	Job job;
+	while(true) {
+		if(FindJob(&job)) {
+			Execute(&job);
+			continue;
+		}
+		wake.Wait();
+		if(stopping)
+			return;
+	}
+}
+// Starts the job threads
+void vvd::InitJobs(int nNumThreads) {
+	if(started)
+		return; // Already started; the first call picks the number of threads
+	started = true;
+	if(nNumThreads <= 0)
+		nNumThreads = Thread::GetNumProcessors();
+	nNumThreads = Min(nNumThreads, MAX_JOB_THREADS);
+	stopping = false;
+	for(int i = 1; i < nNumThreads; i++) {
+		// The thread may start stealing as soon as it exists, so count it first
+		numThreads = i + 1;
+		if(!threads[i].Start(Work, (void*)(size_t)i)) {
+			numThreads = i;
+			break;
+		}
+	}
+}
+// Stops the job threads
+void vvd::DeInitJobs() {
+	stopping = true;
+	wake.Signal(numThreads - 1);
+	for(int i = 1; i < numThreads; i++)
+		threads[i].Join();
+	numThreads = 1;
+	started = false;
+}
+// Queues the jobs
+void vvd::RunJobs(Job* jobs, int count, JobCounter* counter) {
+	if(counter)
+		AtomicAdd(&counter->count, count);
+	JobQueue* queue = &queues[threadIndex];
+	{
+		ScopedLock lock(&queue->mutex);
+		for(int i = 0; i < count; i++)
+			queue->jobs.push_back(jobs[i]);
+	}
+	if(numThreads > 1)
+		wake.Signal(Min(count, numThreads - 1));
+}
+// Runs queued jobs until the counter reaches zero
+void vvd::WaitForCounter(JobCounter* counter) {
+	Job job;
+	while(counter->count > 0) {
+		if(FindJob(&job))
+			Execute(&job);
+		else
+			Thread::YieldTimeSlice(); // The last jobs are running on other threads
+	}
+
+	// The last job added its statistics before counting itself as done
+	AddFrameStats(GetFrameStats(), &counter->stats);
+	memset(&counter->stats, 0, sizeof(counter->stats));
+}
+// Splits [0, count) into jobs, runs them, and waits for them
+void vvd::ParallelFor(int count, int grain, JobFunction function, void* data) {
+	if(count <= 0)
+		return;
+	if(grain <= 0)
+		grain = Max(count / (numThreads * 4), 1);
+	int numJobs = (count + grain - 1) / grain;
+	if(numJobs == 1 || numThreads == 1) {
+		for(int i = 0; i < count; i += grain)
+			function(data, i, Min(i + grain, count));
+		return;
+	}
+
+	JobCounter counter;
+	memset(&counter, 0, sizeof(counter));
+	std::vector<Job> jobs(numJobs);
+	for(int i = 0; i < numJobs; i++) {
+		jobs[i].function = function;
+		jobs[i].data = data;
+		jobs[i].first = i * grain;
+		jobs[i].last = Min((i + 1) * grain, count);
+		jobs[i].counter = &counter;
+	}
+	RunJobs(&jobs[0], numJobs, &counter);
+	WaitForCounter(&counter);
+}
+// Gets the number of threads running jobs, the calling thread included
+int vvd::GetNumJobThreads() {
+	return numThreads;
+}
\ No newline at end of file
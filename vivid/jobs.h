@@ -0,0 +1,58 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef jobs_h
+#define jobs_h
+#include "vividcore.h"
+#include "thread.h"
+
+#define MAX_JOB_THREADS 32 // Most threads running jobs, the thread that queues them included
+
+typedef void (*JobFunction)(void* data, int first, int last); // Does the items in [first, last)
+
+// Counts unfinished jobs; work that depends on the jobs waits for the counter to reach zero. Start it zeroed
+struct JobCounter {
+	volatile long count;
+	vvd::FrameStats stats; // Counted by the finished jobs; added to the waiting thread's when it reaches zero
+};
+
+// A range of items for one thread to do
+struct Job {
+	JobFunction function;
+	void* data; // Passed to the function
+	int first; // First item
+	int last; // One past the last item
+	JobCounter* counter; // Decremented once the job is done; can be 0, but then its statistics are dropped
+};
+
+// Work stealing job scheduler. Every thread has its own queue: it takes the jobs it queued itself newest
+// first, and when it runs out it steals the oldest jobs of the other threads. Threads waiting for a counter
+// run jobs instead of sleeping. Jobs can be queued by any thread, so a game thread and a render thread can
+// share the job threads; each job counts its frame statistics into its counter, and they're added to the
+// statistics of the thread waiting for it
+namespace vvd {
+	// Starts the job threads; numThreads includes the calling thread, and 0 uses one per processor.
+	// Init() calls it with 0; call it before Init() to pick another number
+	void InitJobs(int numThreads);
+	void DeInitJobs(); // Stops the job threads; the queues must be empty
+	void RunJobs(Job* jobs, int count, JobCounter* counter); // Queues the jobs; count is added to the counter first
+	void WaitForCounter(JobCounter* counter); // Runs queued jobs until the counter reaches zero
+	// Splits [0, count) into jobs of at most grain items, runs them, and waits for them; a grain of 0
+	// gives every thread about four jobs. Runs them on the calling thread if there's only one thread
+	void ParallelFor(int count, int grain, JobFunction function, void* data);
+	int GetNumJobThreads(); // Gets the number of threads running jobs, the calling thread included
+}
+
+#endif
\ No newline at end of file
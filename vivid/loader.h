@@ -0,0 +1,64 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef loader_h
+#define loader_h
+#include "vivid.h"
+#include "thread.h"
+#include <list>
+#include <string>
+
+class Mesh;
+struct MeshFileData;
+
+#define MAX_LOADER_THREADS 4 // Most loader threads started; file reads don't gain much from more
+#define MAX_LOADS_PER_FRAME 1 // Most loads finished on the render thread each frame, so finishing them doesn't stall a frame for long
+
+// A mesh being loaded in the background
+struct LoadJob {
+	Mesh* mesh; // 0 if the mesh was deleted before the load finished
+	std::string file; // X file name; a copy, since the loader threads read it
+	MeshFileData* data; // Filled in by a loader thread
+};
+
+// Loads meshes in the background. The loader threads read and parse the files, then Update() creates
+// the Direct3D resources and materials on the render thread, since the device isn't thread safe
+class Loader {
+public:
+	static void Queue(Mesh* mesh, LPCSTR file); // Starts loading the file into the mesh; starts the loader threads the first time
+	static void Cancel(Mesh* mesh); // Drops the mesh's load; called when a pending mesh is deleted
+	static void Update(); // Finishes loads the loader threads are done with; called every frame by vvd::Update()
+	static void Flush(); // Waits for every queued load and finishes it; for loading screens
+	static int GetNumPending(); // Gets the number of loads that haven't finished
+	static bool IsReady(); // Returns true if a load is waiting for Update()
+	// Makes vvd::Update() leave the loads alone. A RenderPipeline finishes them itself while the render thread
+	// is idle, since setting up a mesh's materials changes effects the render thread may be drawing with
+	static void SetDeferred(bool nDeferred);
+	static bool IsDeferred(); // Returns true if vvd::Update() leaves the loads alone
+	static void Shutdown(); // Stops the loader threads; unfinished loads are dropped
+protected:
+	static void Work(void* data); // Loader thread body
+	static Mutex mutex; // Guards the job lists
+	static Semaphore queued; // Signaled once for every job added to the waiting list
+	static std::list<LoadJob*> jobs; // Every unfinished job
+	static std::list<LoadJob*> waiting; // Jobs for the loader threads
+	static std::list<LoadJob*> done; // Jobs read by the loader threads, for the render thread to finish
+	static Thread threads[MAX_LOADER_THREADS]; // Loader threads
+	static int numThreads; // Loader threads started
+	static bool stopping; // Tells the loader threads to exit
+	static bool deferred; // True if vvd::Update() leaves the loads alone
+};
+
+#endif
\ No newline at end of file
@@ -1,293 +1,714 @@
-// Vivid Engine v0.01
-// Copyright (C) 2006 Evan Todd
-
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// version 2 as published by the Free Software Foundation.
-
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-// GNU General Public License (included in README.txt) for more details.
-
-// You can contact the author at evanofsky@sbcglobal.net.
-
-#include "mesh.h"
-
-std::list<Mesh*> Mesh::meshes;
-
-Mesh::Mesh(LPCSTR file) {
-	d3dmesh = 0; // Zero all the members
-	filename = 0;
-	numSubsets = 0;
-	radius = 0.0f;
-	alpha = false;
-	translucent = false;
-	LoadMesh(file); // Load x file
-	meshes.push_back(this); // Add this object to the static rendering list
-}
-Mesh::Mesh() {
-	d3dmesh = 0; // Zero all the members
-	filename = 0;
-	numSubsets = 0;
-	radius = 0.0f;
-	alpha = false;
-	translucent = false;
-	meshes.push_back(this); // Add this object to the static rendering list
-}
-Mesh::~Mesh() {
-	std::list<Mesh*>::iterator i = meshes.begin(); // Iterate through all the meshes
-	while(i != meshes.end()) {
-		if(*i == this) {
-			meshes.erase(i); // Erase this object from the list so we don't have a stray pointer in the mesh list
-			break;
-		}
-		i++;
-	}
-	materials.clear();
-	vvd::Release<ID3DXMesh*>(d3dmesh); // Release the mesh data
-}
-Mesh::Mesh(const Mesh& mesh) {
-	d3dmesh = mesh.d3dmesh;
-	if(d3dmesh)
-		d3dmesh->AddRef(); // Make sure d3dmesh isn't deleted when the other mesh is deleted
-	filename = mesh.filename;
-	numSubsets = mesh.numSubsets;
-	transform = mesh.transform;
-	materials.clear();
-	materials = mesh.materials;
-	cells = mesh.cells;
-	radius = mesh.radius;
-	center = mesh.center;
-	alpha = mesh.alpha;
-	translucent = mesh.translucent;
-}
-// Gets the list of materials in this mesh
-std::vector<Material>* Mesh::GetMaterials() {
-	return &materials;
-}
-// Gets the list of cells this mesh is inside
-std::vector<Cell*>* Mesh::GetCells() {
-	return &cells;
-}
-// Adds a cell to the list of cells this mesh is inside
-void Mesh::AddCell(Cell* cell) {
-	cells.push_back(cell);
-}
-// Clears the list of cells this mesh is inside
-void Mesh::ClearCells() {
-	cells.clear();
-}
-// Gets the center of the mesh
-D3DXVECTOR3 Mesh::GetCenter() {
-	return center;
-}
-// Gets the distance from the center to the outermost vertex of the mesh
-float Mesh::GetRadius() {
-	D3DXVECTOR3 scale = transform.GetScale();
-	return radius * max(max(scale.x, scale.y), scale.z);
-}
-// Returns true if this mesh has alpha information
-bool Mesh::IsAlpha() {
-	return alpha;
-}
-// Returns true if this mesh needs access to the back buffer
-bool Mesh::IsTranslucent() {
-	return translucent;
-}
-// Loads the specified X file
-void Mesh::LoadMesh(LPCSTR xfile) {
-	// Logging stuff
-	vvd::Log("");
-	std::string msg = "Vivid: Loading X file: ";
-	msg += xfile;
-	vvd::Log(msg.c_str());
-
-	IDirect3DDevice9* device = vvd::GetDevice();
-
-	// Iterate through meshes to see if this file has already been loaded
-	std::list<Mesh*>::iterator i = meshes.begin();
-	while(i != meshes.end()) {
-		Mesh* mesh = *i;
-		if(!(0 == mesh->filename)) {
-			if(strcmp(mesh->filename, xfile) == 0 && mesh != this) {
-				// This mesh file has already been loaded; use the pre-loaded data
-				SetTo(mesh);
-				msg = "Vivid: Successfully loaded precached mesh: ";
-				msg += xfile;
-				vvd::Log(msg.c_str());
-				return;
-			}
-		}
-		i++;
-	}
-	filename = xfile;
-	// This file hasn't been loaded, so load the X file
-	ID3DXBuffer* adjBuffer; // The adjacency buffer is used for mesh optimization
-	ID3DXBuffer* mtrlBuffer; // The material buffer holds the filenames for all the materials
-	HRESULT hr = D3DXLoadMeshFromX( // Load X file
-		filename,
-		D3DXMESH_MANAGED,
-		vvd::GetDevice(),
-		&adjBuffer,
-		&mtrlBuffer,
-		0,
-		&numSubsets,
-		&d3dmesh);
-
-	if(FAILED(hr))
-	{
-		msg = "Vivid: Failed to load mesh: ";
-		msg += filename;
-		vvd::Log(msg.c_str());
-		exit(1);
-	}
-
-	// Weld the vertices
-	D3DXWELDEPSILONS epsilons;
-	epsilons.Normal = 0.001f;
-	epsilons.Position = 0.1f;
-	D3DXWeldVertices(d3dmesh, D3DXWELDEPSILONS_WELDPARTIALMATCHES, &epsilons, (DWORD*)adjBuffer->GetBufferPointer(), (DWORD*)adjBuffer->GetBufferPointer(), 0, 0);
-
-	// Optimize the mesh
-	hr = d3dmesh->OptimizeInplace(	
-		D3DXMESHOPT_ATTRSORT |
-		D3DXMESHOPT_COMPACT  |
-		D3DXMESHOPT_VERTEXCACHE,
-		(DWORD*)adjBuffer->GetBufferPointer(),
-		0, 0, 0);
-
-	if(FAILED(hr)) {
-		msg = "Vivid: Failed to optimize mesh: ";
-		msg += xfile;
-		vvd::Log(msg.c_str());
-		exit(1);
-	} else {
-		msg = "Vivid: Successfully optimized mesh: ";
-		msg += xfile;
-		vvd::Log(msg.c_str());
-	}
-
-	D3DVERTEXELEMENT9 decl[MAX_FVF_DECL_SIZE];
-	d3dmesh->GetDeclaration(decl);
-
-	bool hasTangentData = false;
-	bool hasNormalData = false;
-	for(int i = 0; i < MAX_FVF_DECL_SIZE; i++) {
-		if(decl[i].Type == D3DDECLTYPE_UNUSED)
-			break;
-
-		if(decl[i].Usage == D3DDECLUSAGE_TANGENT) {
-			hasTangentData = true;
-		} else if(decl[i].Usage = D3DDECLUSAGE_NORMAL) {
-			hasNormalData = true;
-		}
-	}
-
-	if(!hasTangentData) {
-		if(!hasNormalData) {
-			D3DXComputeTangentFrameEx(d3dmesh, D3DDECLUSAGE_TEXCOORD, 0,
-				D3DDECLUSAGE_BINORMAL, 0, D3DDECLUSAGE_TANGENT, 0,
-				D3DDECLUSAGE_NORMAL, 0,
-				D3DXTANGENT_CALCULATE_NORMALS | D3DXTANGENT_GENERATE_IN_PLACE,
-				(DWORD*)adjBuffer->GetBufferPointer(), 0.01f, 0.25f, 0.01f, &d3dmesh, NULL);
-		} else {
-			D3DXComputeTangentFrameEx(d3dmesh, D3DDECLUSAGE_TEXCOORD, 0,
-				D3DDECLUSAGE_BINORMAL, 0, D3DDECLUSAGE_TANGENT, 0,
-				D3DDECLUSAGE_NORMAL, 0,
-				D3DXTANGENT_GENERATE_IN_PLACE,
-				(DWORD*)adjBuffer->GetBufferPointer(), 0.01f, 0.25f, 0.01f, &d3dmesh, NULL);
-		}
-	}
-
-	vvd::Release<ID3DXBuffer*>(adjBuffer); // Release the adjacency buffer; we don't need it
-
-	// Are there any materials in this mesh?
-	if( mtrlBuffer != 0 && numSubsets != 0 )
-	{
-		// Yes, so get the material buffer
-		D3DXMATERIAL* nmtrls = (D3DXMATERIAL*)mtrlBuffer->GetBufferPointer();
-
-		for(int i = 0; i < (int)numSubsets; i++)
-		{
-			// Check if this material has a material filename
-			if( nmtrls[i].pTextureFilename != 0 )
-			{
-				// Yes, so load the material
-				Material material(nmtrls[i].pTextureFilename);
-				if(material.IsAlpha()) {
-					alpha = true;
-				}
-				if(material.IsTranslucent()) {
-					translucent = true;
-				}
-				materials.push_back(material);
-			}
-			else
-			{
-				// No material for the ith subset, load a blank one
-				Material material;
-				materials.push_back(material);
-			}
-		}
-	}
-
-	// Calculate radius and center vector
-	BYTE* v = 0;
-	d3dmesh->LockVertexBuffer(0, (void**)&v);
-
-	if(FAILED(D3DXComputeBoundingSphere(
-		(D3DXVECTOR3*)v,
-		d3dmesh->GetNumVertices(),
-		D3DXGetFVFVertexSize(d3dmesh->GetFVF()),
-		&center,
-		&radius))) {
-
-		msg = "Failed to compute bounding sphere for mesh ";
-		msg += xfile;
-		vvd::Log(msg.c_str());
-		exit(1);
-
-	}
-
-	d3dmesh->UnlockVertexBuffer();
-
-	msg = "Vivid: Successfully loaded mesh: ";
-	msg += xfile;
-	vvd::Log(msg.c_str());
-}
-// Draws the specified subset of the mesh
-void Mesh::DrawSubset(DWORD index) {
-	d3dmesh->DrawSubset(index);
-}
-// Returns the number of faces (triangles) in the mesh
-DWORD Mesh::GetNumFaces() {
-	return d3dmesh->GetNumFaces();
-}
-// Returns the number of vertices (points) in the mesh
-DWORD Mesh::GetNumVertices() {
-	return d3dmesh->GetNumVertices();
-}
-// Returns the Flexible Vertex Format of the mesh
-DWORD Mesh::GetFVF() {
-	return d3dmesh->GetFVF();
-}
-// Returns the number of subsets (materials) in the mesh
-int Mesh::GetNumSubsets() {
-	return (int)numSubsets;
-}
-void Mesh::SetTo(Mesh* mesh) {
-	vvd::Release<ID3DXMesh*>(d3dmesh);
-	d3dmesh = mesh->d3dmesh;
-	if(d3dmesh)
-		d3dmesh->AddRef(); // Make sure d3dmesh isn't deleted when the other mesh is deleted
-	filename = mesh->filename;
-	numSubsets = mesh->numSubsets;
-	transform = mesh->transform;
-	materials = mesh->materials;
-	center = mesh->center;
-	radius = mesh->radius;
-	alpha = mesh->alpha;
-	translucent = mesh->translucent;
-	cells = mesh->cells;
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "mesh.h"
+#include "loader.h"
+#include <algorithm>
+
+std::list<Mesh*> Mesh::occluders;
+
+Mesh::Mesh(LPCSTR file) {
+	d3dmesh = 0; // Zero all the members
+	instanceDecl = 0;
+	filename = 0;
+	resource = 0;
+	numSubsets = 0;
+	alpha = false;
+	translucent = false;
+	occluder = false;
+	loading = false;
+	LoadMesh(file); // Load x file
+	meshes.push_back(this); // Add this object to the static rendering list
+}
+// Loads the x file specified; in the background if async is true
+Mesh::Mesh(LPCSTR file, bool async) {
+	d3dmesh = 0; // Zero all the members
+	instanceDecl = 0;
+	filename = 0;
+	resource = 0;
+	numSubsets = 0;
+	alpha = false;
+	translucent = false;
+	occluder = false;
+	loading = false;
+	if(async && !ResourceCache::Find(RESOURCE_MESH, file)) {
+		// The mesh joins the rendering list once the Loader has finished it
+		filename = ResourceCache::Intern(file);
+		loading = true;
+		Loader::Queue(this, file);
+		return;
+	}
+	LoadMesh(file);
+	meshes.push_back(this);
+}
+Mesh::Mesh() {
+	d3dmesh = 0; // Zero all the members
+	instanceDecl = 0;
+	filename = 0;
+	resource = 0;
+	numSubsets = 0;
+	alpha = false;
+	translucent = false;
+	occluder = false;
+	loading = false;
+	meshes.push_back(this); // Add this object to the static rendering list
+}
+Mesh::~Mesh() {
+	if(loading)
+		Loader::Cancel(this); // Don't let the Loader finish a deleted mesh
+	if(occluder)
+		occluders.remove(this);
+	materials.clear();
+	vvd::Release<ID3DXMesh*>(d3dmesh); // Release the mesh data
+	vvd::Release<IDirect3DVertexDeclaration9*>(instanceDecl);
+	if(resource)
+		ResourceCache::Release(resource);
+}
+Mesh::Mesh(const Mesh& mesh) : SceneMesh(mesh) {
+	d3dmesh = mesh.d3dmesh;
+	if(d3dmesh)
+		d3dmesh->AddRef(); // Make sure d3dmesh isn't deleted when the other mesh is deleted
+	instanceDecl = mesh.instanceDecl;
+	if(instanceDecl)
+		instanceDecl->AddRef();
+	attributes = mesh.attributes;
+	filename = mesh.filename;
+	resource = mesh.resource;
+	if(resource)
+		ResourceCache::AddRef(resource);
+	numSubsets = mesh.numSubsets;
+	materials.clear();
+	materials = mesh.materials;
+	alpha = mesh.alpha;
+	translucent = mesh.translucent;
+	occluder = false; // Copies have to be marked separately
+	loading = false;
+}
+// Marks the mesh as an occluder
+void Mesh::SetOccluder(bool nOccluder) {
+	if(nOccluder && !occluder)
+		occluders.push_back(this);
+	else if(!nOccluder && occluder)
+		occluders.remove(this);
+	occluder = nOccluder;
+}
+// Returns true if the mesh is an occluder
+bool Mesh::IsOccluder() {
+	return occluder;
+}
+// Gets the list of materials in this mesh
+std::vector<Material>* Mesh::GetMaterials() {
+	return &materials;
+}
+// Returns true if this mesh has alpha information
+bool Mesh::IsAlpha() {
+	return alpha;
+}
+// Returns true if this mesh needs access to the back buffer
+bool Mesh::IsTranslucent() {
+	return translucent;
+}
+// Loads the specified X file
+void Mesh::LoadMesh(LPCSTR xfile) {
+	// Logging stuff
+	vvd::Log("");
+	std::string msg = "Vivid: Loading X file: ";
+	msg += xfile;
+	vvd::Log(msg.c_str());
+
+	// Check if this file has already been loaded
+	Resource* cached = ResourceCache::Find(RESOURCE_MESH, xfile);
+	if(cached) {
+		// This mesh file has already been loaded; use the pre-loaded data
+		SetTo((Mesh*)cached->data);
+		SetResource(cached);
+		msg = "Vivid: Successfully loaded precached mesh: ";
+		msg += xfile;
+		vvd::Log(msg.c_str());
+		return;
+	}
+	SetResource(0);
+	filename = ResourceCache::Intern(xfile);
+
+	MeshFileData data;
+	ReadFiles(xfile, &data);
+	CreateFromFiles(&data);
+}
+// Switches the mesh to another cache entry
+void Mesh::SetResource(Resource* nResource) {
+	if(nResource)
+		ResourceCache::AddRef(nResource);
+	if(resource)
+		ResourceCache::Release(resource);
+	resource = nResource;
+}
+// Reads the cooked mesh if it's current, otherwise parses the X file; doesn't touch the device,
+// so the Loader calls it on its own threads
+void Mesh::ReadFiles(LPCSTR xfile, MeshFileData* data) {
+	std::string cookedFile = xfile;
+	cookedFile += COOKED_MESH_EXTENSION;
+	data->parsed = false;
+	if(ReadCooked(cookedFile.c_str(), xfile, &data->cooked))
+		return;
+	data->cooked.clear();
+
+	XFile parser;
+	data->parsed = parser.Load(xfile, &data->xdata);
+	if(!data->parsed)
+		data->error = parser.GetError();
+}
+// Creates the mesh and its materials from the data ReadFiles() read; render thread only
+void Mesh::CreateFromFiles(MeshFileData* data) {
+	std::string msg;
+	if(loading) {
+		// Another mesh may have loaded the same file while this one was queued
+		Resource* cached = ResourceCache::Find(RESOURCE_MESH, filename);
+		if(cached) {
+			Transform local = transform; // Keep any transform set while the mesh was loading
+			SetTo((Mesh*)cached->data);
+			SetResource(cached);
+			transform = local;
+		}
+		loading = false;
+		meshes.push_back(this); // Add this object to the static rendering list
+		if(cached) {
+			msg = "Vivid: Successfully loaded precached mesh: ";
+			msg += filename;
+			vvd::Log(msg.c_str());
+			return;
+		}
+	}
+
+	// Use the cooked copy if it's current; otherwise import the X file and cook it for next time
+	std::vector<std::string> materialFiles;
+	std::string cookedFile = filename;
+	cookedFile += COOKED_MESH_EXTENSION;
+	if(!data->cooked.empty() && CreateFromCooked(&data->cooked, &materialFiles)) {
+		msg = "Vivid: Loaded cooked mesh: ";
+		msg += cookedFile;
+		vvd::Log(msg.c_str());
+	} else {
+		if(!data->parsed && data->error.empty()) {
+			// The cooked file was read but the mesh couldn't be created from it
+			XFile parser;
+			data->parsed = parser.Load(filename, &data->xdata);
+			if(!data->parsed)
+				data->error = parser.GetError();
+		}
+		if(!data->parsed) {
+			msg = "Vivid: Falling back to D3DX for mesh ";
+			msg += filename;
+			msg += ": ";
+			msg += data->error;
+			vvd::Log(msg.c_str());
+		}
+		ImportX(filename, data->parsed ? &data->xdata : 0, &materialFiles);
+		SaveCooked(cookedFile.c_str(), filename, &materialFiles);
+	}
+	FinishLoading(filename, &materialFiles);
+
+	// Later loads of the file copy this one; the copy isn't in the rendering list
+	resource = ResourceCache::Add(RESOURCE_MESH, filename, new Mesh(*this));
+
+	msg = "Vivid: Successfully loaded mesh: ";
+	msg += filename;
+	vvd::Log(msg.c_str());
+}
+// Returns false until a mesh loaded in the background is ready; it isn't rendered until then
+bool Mesh::IsLoaded() {
+	return !loading;
+}
+// Loads, welds and optimizes the X file and computes its tangents and bounding sphere
+void Mesh::ImportX(LPCSTR xfile, XMeshData* xdata, std::vector<std::string>* materialFiles) {
+	std::string msg;
+	std::vector<DWORD> adjacency; // The adjacency is used for mesh optimization
+	HRESULT hr;
+	if(xdata) {
+		CreateFromXData(xfile, xdata, &adjacency, materialFiles);
+	} else {
+		// Fall back to D3DX for the files our parser can't read
+		ID3DXBuffer* adjBuffer;
+		ID3DXBuffer* mtrlBuffer; // The material buffer holds the filenames for all the materials
+		hr = D3DXLoadMeshFromX( // Load X file
+			xfile,
+			D3DXMESH_MANAGED,
+			vvd::GetDevice(),
+			&adjBuffer,
+			&mtrlBuffer,
+			0,
+			&numSubsets,
+			&d3dmesh);
+
+		if(FAILED(hr))
+		{
+			msg = "Vivid: Failed to load mesh: ";
+			msg += xfile;
+			vvd::Log(msg.c_str());
+			exit(1);
+		}
+
+		DWORD* adj = (DWORD*)adjBuffer->GetBufferPointer();
+		adjacency.assign(adj, adj + d3dmesh->GetNumFaces() * 3);
+		vvd::Release<ID3DXBuffer*>(adjBuffer);
+
+		// Remember the material file names; the materials are loaded by FinishLoading()
+		materialFiles->clear();
+		if(mtrlBuffer != 0) {
+			D3DXMATERIAL* nmtrls = (D3DXMATERIAL*)mtrlBuffer->GetBufferPointer();
+			for(int i = 0; i < (int)numSubsets; i++)
+				materialFiles->push_back(nmtrls[i].pTextureFilename ? nmtrls[i].pTextureFilename : "");
+		}
+		vvd::Release<ID3DXBuffer*>(mtrlBuffer);
+	}
+
+	// Weld the vertices
+	D3DXWELDEPSILONS epsilons;
+	epsilons.Normal = 0.001f;
+	epsilons.Position = 0.1f;
+	D3DXWeldVertices(d3dmesh, D3DXWELDEPSILONS_WELDPARTIALMATCHES, &epsilons, &adjacency[0], &adjacency[0], 0, 0);
+
+	// Optimize the mesh
+	hr = d3dmesh->OptimizeInplace(	
+		D3DXMESHOPT_ATTRSORT |
+		D3DXMESHOPT_COMPACT  |
+		D3DXMESHOPT_VERTEXCACHE,
+		&adjacency[0],
+		0, 0, 0);
+
+	if(FAILED(hr)) {
+		msg = "Vivid: Failed to optimize mesh: ";
+		msg += xfile;
+		vvd::Log(msg.c_str());
+		exit(1);
+	} else {
+		msg = "Vivid: Successfully optimized mesh: ";
+		msg += xfile;
+		vvd::Log(msg.c_str());
+	}
+
+	D3DVERTEXELEMENT9 decl[MAX_FVF_DECL_SIZE];
+	d3dmesh->GetDeclaration(decl);
+
+	bool hasTangentData = false;
+	bool hasNormalData = false;
+	for(int i = 0; i < MAX_FVF_DECL_SIZE; i++) {
+		if(decl[i].Type == D3DDECLTYPE_UNUSED)
+			break;
+
+		if(decl[i].Usage == D3DDECLUSAGE_TANGENT) {
+			hasTangentData = true;
+		} else if(decl[i].Usage = D3DDECLUSAGE_NORMAL) {
+			hasNormalData = true;
+		}
+	}
+
+	if(!hasTangentData) {
+		if(!hasNormalData) {
+			D3DXComputeTangentFrameEx(d3dmesh, D3DDECLUSAGE_TEXCOORD, 0,
+				D3DDECLUSAGE_BINORMAL, 0, D3DDECLUSAGE_TANGENT, 0,
+				D3DDECLUSAGE_NORMAL, 0,
+				D3DXTANGENT_CALCULATE_NORMALS | D3DXTANGENT_GENERATE_IN_PLACE,
+				&adjacency[0], 0.01f, 0.25f, 0.01f, &d3dmesh, NULL);
+		} else {
+			D3DXComputeTangentFrameEx(d3dmesh, D3DDECLUSAGE_TEXCOORD, 0,
+				D3DDECLUSAGE_BINORMAL, 0, D3DDECLUSAGE_TANGENT, 0,
+				D3DDECLUSAGE_NORMAL, 0,
+				D3DXTANGENT_GENERATE_IN_PLACE,
+				&adjacency[0], 0.01f, 0.25f, 0.01f, &d3dmesh, NULL);
+		}
+	}
+
+	// Calculate radius and center vector
+	BYTE* v = 0;
+	d3dmesh->LockVertexBuffer(0, (void**)&v);
+
+	if(FAILED(D3DXComputeBoundingSphere(
+		(D3DXVECTOR3*)v,
+		d3dmesh->GetNumVertices(),
+		d3dmesh->GetNumBytesPerVertex(),
+		(D3DXVECTOR3*)&center,
+		&radius))) {
+
+		msg = "Failed to compute bounding sphere for mesh ";
+		msg += xfile;
+		vvd::Log(msg.c_str());
+		exit(1);
+
+	}
+
+	d3dmesh->UnlockVertexBuffer();
+}
+// Builds the mesh from the data our own X file parser read
+void Mesh::CreateFromXData(LPCSTR xfile, XMeshData* data, std::vector<DWORD>* adjacency, std::vector<std::string>* materialFiles) {
+	std::string msg;
+	// Position, normal and texture coordinates; the tangents are added by ImportX()
+	D3DVERTEXELEMENT9 xdecl[] = {
+		{0, 0, D3DDECLTYPE_FLOAT3, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0},
+		{0, 12, D3DDECLTYPE_FLOAT3, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_NORMAL, 0},
+		{0, 24, D3DDECLTYPE_FLOAT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 0},
+		D3DDECL_END()
+	};
+	DWORD numVertices = (DWORD)data->positions.size();
+	DWORD numFaces = (DWORD)data->attributes.size();
+	DWORD options = D3DXMESH_MANAGED;
+	if(numVertices > 0xFFFF)
+		options |= D3DXMESH_32BIT;
+	if(FAILED(D3DXCreateMesh(numFaces, numVertices, options, xdecl, vvd::GetDevice(), &d3dmesh))) {
+		msg = "Vivid: Failed to create mesh: ";
+		msg += xfile;
+		vvd::Log(msg.c_str());
+		exit(1);
+	}
+
+	float* v = 0;
+	d3dmesh->LockVertexBuffer(0, (void**)&v);
+	for(DWORD i = 0; i < numVertices; i++, v += 8) {
+		Vector3 normal = data->normals.empty() ? Vector3(0.0f, 0.0f, 0.0f) : data->normals[i];
+		v[0] = data->positions[i].x;
+		v[1] = data->positions[i].y;
+		v[2] = data->positions[i].z;
+		v[3] = normal.x;
+		v[4] = normal.y;
+		v[5] = normal.z;
+		v[6] = data->texcoords.empty() ? 0.0f : data->texcoords[i * 2];
+		v[7] = data->texcoords.empty() ? 0.0f : data->texcoords[i * 2 + 1];
+	}
+	d3dmesh->UnlockVertexBuffer();
+
+	void* indices = 0;
+	d3dmesh->LockIndexBuffer(0, &indices);
+	for(DWORD i = 0; i < numFaces * 3; i++) {
+		if(options & D3DXMESH_32BIT)
+			((DWORD*)indices)[i] = data->indices[i];
+		else
+			((WORD*)indices)[i] = (WORD)data->indices[i];
+	}
+	d3dmesh->UnlockIndexBuffer();
+
+	DWORD* attributeBuffer = 0;
+	d3dmesh->LockAttributeBuffer(0, &attributeBuffer);
+	for(DWORD i = 0; i < numFaces; i++)
+		attributeBuffer[i] = data->attributes[i];
+	d3dmesh->UnlockAttributeBuffer();
+
+	adjacency->resize(numFaces * 3);
+	d3dmesh->GenerateAdjacency(0.0f, &(*adjacency)[0]);
+	if(data->normals.empty())
+		D3DXComputeNormals(d3dmesh, &(*adjacency)[0]);
+
+	numSubsets = (DWORD)data->materials.size();
+	materialFiles->clear();
+	for(int i = 0; i < (int)data->materials.size(); i++)
+		materialFiles->push_back(data->materials[i].textureFilename);
+}
+// Builds the attribute table, instancing declaration and materials
+void Mesh::FinishLoading(LPCSTR xfile, std::vector<std::string>* materialFiles) {
+	IDirect3DDevice9* device = vvd::GetDevice();
+	std::string msg;
+
+	// Get the vertex and face range of each subset
+	DWORD numAttributes = 0;
+	d3dmesh->GetAttributeTable(0, &numAttributes);
+	attributes.resize(numAttributes);
+	if(numAttributes > 0)
+		d3dmesh->GetAttributeTable(&attributes[0], &numAttributes);
+
+	// Build the instancing declaration: the mesh's own vertex data in stream 0,
+	// and one world matrix per instance in stream 1
+	D3DVERTEXELEMENT9 instanceElements[MAX_FVF_DECL_SIZE + 4];
+	d3dmesh->GetDeclaration(instanceElements);
+	int numElements = 0;
+	while(instanceElements[numElements].Stream != 0xFF)
+		numElements++;
+	for(int i = 0; i < 4; i++) {
+		D3DVERTEXELEMENT9 row = {1, (WORD)(i * sizeof(D3DXVECTOR4)), D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, (BYTE)(4 + i)};
+		instanceElements[numElements + i] = row;
+	}
+	D3DVERTEXELEMENT9 end = D3DDECL_END();
+	instanceElements[numElements + 4] = end;
+	if(FAILED(device->CreateVertexDeclaration(instanceElements, &instanceDecl))) {
+		msg = "Vivid: Failed to create instancing declaration for mesh: ";
+		msg += xfile;
+		vvd::Log(msg.c_str());
+		instanceDecl = 0;
+	}
+
+	for(int i = 0; i < (int)materialFiles->size(); i++) {
+		// Check if this material has a material filename
+		if(!(*materialFiles)[i].empty()) {
+			// Yes, so load the material
+			Material material((*materialFiles)[i].c_str());
+			if(material.IsAlpha()) {
+				alpha = true;
+			}
+			if(material.IsTranslucent()) {
+				translucent = true;
+			}
+			materials.push_back(material);
+		} else {
+			// No material for the ith subset, load a blank one
+			Material material;
+			materials.push_back(material);
+		}
+	}
+}
+// Gets the last write time and size of a file; returns false if it doesn't exist
+static bool GetFileStamp(LPCSTR file, FILETIME* time, DWORD* size) {
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if(!GetFileAttributesEx(file, GetFileExInfoStandard, &data))
+		return false;
+	*time = data.ftLastWriteTime;
+	*size = data.nFileSizeLow;
+	return true;
+}
+// Reads a cooked mesh file; returns false if the file is missing, was cooked by another version,
+// is older than the X file, or is truncated. Doesn't touch the device
+bool Mesh::ReadCooked(LPCSTR cookedFile, LPCSTR xfile, std::vector<BYTE>* data) {
+	// Read the whole file at once
+	std::ifstream file(cookedFile, std::ios::in | std::ios::binary);
+	if(!file.is_open())
+		return false;
+	file.seekg(0, std::ios::end);
+	size_t size = (size_t)file.tellg();
+	file.seekg(0, std::ios::beg);
+	if(size < sizeof(CookedMeshHeader))
+		return false;
+	data->resize(size);
+	file.read((char*)&(*data)[0], (std::streamsize)size);
+	if(!file)
+		return false;
+
+	CookedMeshHeader* header = (CookedMeshHeader*)&(*data)[0];
+	if(header->magic != COOKED_MESH_MAGIC || header->version != COOKED_MESH_VERSION)
+		return false;
+
+	// A missing X file is fine; games can ship only the cooked files
+	FILETIME sourceTime;
+	DWORD sourceSize;
+	if(GetFileStamp(xfile, &sourceTime, &sourceSize)) {
+		if(CompareFileTime(&sourceTime, &header->sourceTime) != 0 || sourceSize != header->sourceSize)
+			return false;
+	}
+
+	// The counts come from the file, so the sizes are worked out in 64 bits, where they can't wrap around,
+	// and each one is checked against the file size before they're added up
+	UINT64 indexSize = (header->options & D3DXMESH_32BIT) ? sizeof(DWORD) : sizeof(WORD);
+	UINT64 sizes[4];
+	sizes[0] = (UINT64)header->numVertices * header->vertexSize; // Vertices
+	sizes[1] = (UINT64)header->numFaces * 3 * indexSize; // Indices
+	sizes[2] = (UINT64)header->numFaces * sizeof(DWORD); // Attribute ids
+	sizes[3] = (UINT64)header->numAttributes * sizeof(D3DXATTRIBUTERANGE); // Attribute table
+	UINT64 bytes = sizeof(CookedMeshHeader);
+	for(int i = 0; i < 4; i++) {
+		if(sizes[i] > size)
+			return false;
+		bytes += sizes[i];
+	}
+	return bytes <= size; // Truncated if not
+}
+// Creates the mesh from a cooked mesh file read by ReadCooked(); returns false if the mesh can't be created
+bool Mesh::CreateFromCooked(std::vector<BYTE>* cooked, std::vector<std::string>* materialFiles) {
+	std::vector<BYTE>& data = *cooked;
+	size_t size = data.size();
+	CookedMeshHeader* header = (CookedMeshHeader*)&data[0];
+	// ReadCooked() made sure these fit in the file, so they don't wrap around
+	size_t indexSize = (header->options & D3DXMESH_32BIT) ? sizeof(DWORD) : sizeof(WORD);
+	size_t vertexBytes = (size_t)header->numVertices * header->vertexSize;
+	size_t indexBytes = (size_t)header->numFaces * 3 * indexSize;
+	size_t attributeBytes = (size_t)header->numFaces * sizeof(DWORD);
+	size_t tableBytes = (size_t)header->numAttributes * sizeof(D3DXATTRIBUTERANGE);
+	size_t offset = sizeof(CookedMeshHeader);
+
+	// The vertex buffer is sized from the declaration, so it has to agree with the vertex size the data was written with
+	bool declEnd = false;
+	for(int i = 0; i < MAX_FVF_DECL_SIZE && !declEnd; i++)
+		declEnd = header->decl[i].Stream == 0xFF;
+	if(!declEnd || D3DXGetDeclVertexSize(header->decl, 0) != header->vertexSize)
+		return false;
+
+	if(FAILED(D3DXCreateMesh(header->numFaces, header->numVertices, header->options | D3DXMESH_MANAGED,
+		header->decl, vvd::GetDevice(), &d3dmesh))) {
+		return false;
+	}
+
+	void* buffer = 0;
+	d3dmesh->LockVertexBuffer(0, &buffer);
+	memcpy(buffer, &data[offset], vertexBytes);
+	d3dmesh->UnlockVertexBuffer();
+	offset += vertexBytes;
+
+	d3dmesh->LockIndexBuffer(0, &buffer);
+	memcpy(buffer, &data[offset], indexBytes);
+	d3dmesh->UnlockIndexBuffer();
+	offset += indexBytes;
+
+	DWORD* attributeBuffer = 0;
+	d3dmesh->LockAttributeBuffer(0, &attributeBuffer);
+	memcpy(attributeBuffer, &data[offset], attributeBytes);
+	d3dmesh->UnlockAttributeBuffer();
+	offset += attributeBytes;
+
+	if(header->numAttributes > 0)
+		d3dmesh->SetAttributeTable((D3DXATTRIBUTERANGE*)&data[offset], header->numAttributes);
+	offset += tableBytes;
+
+	materialFiles->clear();
+	for(DWORD i = 0; i < header->numSubsets && offset < size; i++) {
+		const char* name = (const char*)&data[offset];
+		size_t length = strnlen(name, size - offset);
+		materialFiles->push_back(std::string(name, length));
+		offset += length + 1;
+	}
+
+	numSubsets = header->numSubsets;
+	center = header->center;
+	radius = header->radius;
+	return true;
+}
+// Writes the loaded mesh to a cooked mesh file
+void Mesh::SaveCooked(LPCSTR cookedFile, LPCSTR xfile, std::vector<std::string>* materialFiles) {
+	CookedMeshHeader header;
+	ZeroMemory(&header, sizeof(header));
+	header.magic = COOKED_MESH_MAGIC;
+	header.version = COOKED_MESH_VERSION;
+	if(!GetFileStamp(xfile, &header.sourceTime, &header.sourceSize))
+		return;
+	header.options = d3dmesh->GetOptions() & D3DXMESH_32BIT;
+	header.numVertices = d3dmesh->GetNumVertices();
+	header.numFaces = d3dmesh->GetNumFaces();
+	header.vertexSize = d3dmesh->GetNumBytesPerVertex();
+	d3dmesh->GetAttributeTable(0, &header.numAttributes);
+	header.numSubsets = (DWORD)materialFiles->size();
+	d3dmesh->GetDeclaration(header.decl);
+	header.center = center;
+	header.radius = radius;
+
+	std::ofstream file(cookedFile, std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!file.is_open()) {
+		std::string msg = "Vivid: Couldn't write cooked mesh: ";
+		msg += cookedFile;
+		vvd::Log(msg.c_str());
+		return;
+	}
+	file.write((const char*)&header, sizeof(header));
+
+	DWORD indexSize = (header.options & D3DXMESH_32BIT) ? sizeof(DWORD) : sizeof(WORD);
+	void* buffer = 0;
+	d3dmesh->LockVertexBuffer(D3DLOCK_READONLY, &buffer);
+	file.write((const char*)buffer, header.numVertices * header.vertexSize);
+	d3dmesh->UnlockVertexBuffer();
+
+	d3dmesh->LockIndexBuffer(D3DLOCK_READONLY, &buffer);
+	file.write((const char*)buffer, header.numFaces * 3 * indexSize);
+	d3dmesh->UnlockIndexBuffer();
+
+	DWORD* attributeBuffer = 0;
+	d3dmesh->LockAttributeBuffer(D3DLOCK_READONLY, &attributeBuffer);
+	file.write((const char*)attributeBuffer, header.numFaces * sizeof(DWORD));
+	d3dmesh->UnlockAttributeBuffer();
+
+	if(header.numAttributes > 0) {
+		std::vector<D3DXATTRIBUTERANGE> table(header.numAttributes);
+		d3dmesh->GetAttributeTable(&table[0], &header.numAttributes);
+		file.write((const char*)&table[0], header.numAttributes * sizeof(D3DXATTRIBUTERANGE));
+	}
+
+	for(int i = 0; i < (int)materialFiles->size(); i++)
+		file.write((*materialFiles)[i].c_str(), (std::streamsize)(*materialFiles)[i].size() + 1);
+
+	std::string msg = "Vivid: Cooked mesh: ";
+	msg += cookedFile;
+	vvd::Log(msg.c_str());
+}
+// Draws the specified subset of the mesh
+void Mesh::DrawSubset(DWORD index) {
+	d3dmesh->DrawSubset(index);
+}
+// Draws the specified subset once for each world matrix in the instance buffer
+void Mesh::DrawSubsetInstanced(DWORD index, IDirect3DVertexBuffer9* instances, UINT numInstances) {
+	IDirect3DDevice9* device = vvd::GetDevice();
+
+	// Find the vertices and faces of the subset
+	D3DXATTRIBUTERANGE* range = 0;
+	for(int i = 0; i < (int)attributes.size(); i++) {
+		if(attributes[i].AttribId == index) {
+			range = &attributes[i];
+			break;
+		}
+	}
+	if(!range || !instanceDecl || range->FaceCount == 0)
+		return;
+
+	IDirect3DVertexBuffer9* vertices;
+	IDirect3DIndexBuffer9* indices;
+	d3dmesh->GetVertexBuffer(&vertices);
+	d3dmesh->GetIndexBuffer(&indices);
+
+	// Stream 0 repeats the mesh for every instance; stream 1 steps one matrix per instance
+	device->SetVertexDeclaration(instanceDecl);
+	device->SetStreamSource(0, vertices, 0, d3dmesh->GetNumBytesPerVertex());
+	device->SetStreamSourceFreq(0, D3DSTREAMSOURCE_INDEXEDDATA | numInstances);
+	device->SetStreamSource(1, instances, 0, sizeof(D3DXMATRIX));
+	device->SetStreamSourceFreq(1, D3DSTREAMSOURCE_INSTANCEDATA | 1);
+	device->SetIndices(indices);
+
+	device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, range->VertexStart, range->VertexCount, range->FaceStart * 3, range->FaceCount);
+
+	// Restore the default stream frequencies so DrawSubset() works again
+	device->SetStreamSourceFreq(0, 1);
+	device->SetStreamSourceFreq(1, 1);
+	device->SetStreamSource(1, 0, 0, 0);
+
+	vvd::Release<IDirect3DVertexBuffer9*>(vertices);
+	vvd::Release<IDirect3DIndexBuffer9*>(indices);
+}
+// Gets the mesh data; shared by every mesh loaded from the same file
+ID3DXMesh* Mesh::GetD3DMesh() {
+	return d3dmesh;
+}
+// Returns the number of faces (triangles) in the mesh
+DWORD Mesh::GetNumFaces() {
+	return d3dmesh->GetNumFaces();
+}
+// Returns the number of vertices (points) in the mesh
+DWORD Mesh::GetNumVertices() {
+	return d3dmesh->GetNumVertices();
+}
+// Returns the Flexible Vertex Format of the mesh
+DWORD Mesh::GetFVF() {
+	return d3dmesh->GetFVF();
+}
+// Returns the number of subsets (materials) in the mesh
+int Mesh::GetNumSubsets() {
+	return (int)numSubsets;
+}
+void Mesh::SetTo(Mesh* mesh) {
+	vvd::Release<ID3DXMesh*>(d3dmesh);
+	d3dmesh = mesh->d3dmesh;
+	if(d3dmesh)
+		d3dmesh->AddRef(); // Make sure d3dmesh isn't deleted when the other mesh is deleted
+	vvd::Release<IDirect3DVertexDeclaration9*>(instanceDecl);
+	instanceDecl = mesh->instanceDecl;
+	if(instanceDecl)
+		instanceDecl->AddRef();
+	attributes = mesh->attributes;
+	filename = mesh->filename;
+	numSubsets = mesh->numSubsets;
+	transform = mesh->transform;
+	materials = mesh->materials;
+	center = mesh->center;
+	radius = mesh->radius;
+	alpha = mesh->alpha;
+	translucent = mesh->translucent;
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "occlusionbuffer.h"
+#include <math.h>
+#ifdef RASTER_SSE
+#include <xmmintrin.h>
+#endif
+
+OcclusionBuffer::OcclusionBuffer(int nWidth, int nHeight) : rasterizer(nWidth, nHeight, 1) {
+	rasterizer.SetDepthOnly(true);
+	viewProj = Matrix::Identity();
+}
+// Clears the buffer and sets the view projection matrix for the frame
+void OcclusionBuffer::Begin(const Matrix* nViewProj) {
+	viewProj = *nViewProj;
+	rasterizer.SetViewProjection(&viewProj);
+	rasterizer.Clear(0);
+}
+// Rasterizes an occluder
+void OcclusionBuffer::DrawOccluder(const Matrix* world, const void* positions, int stride, int numVertices,
+	const void* indices, bool indices32, int numTriangles) {
+	Vector4 diffuse(1.0f, 1.0f, 1.0f, 1.0f); // Unused; only depth is written
+	rasterizer.DrawTriangles(world, &diffuse, positions, 0, stride, numVertices, indices, indices32, numTriangles);
+}
+// Finishes rasterizing the occluders
+void OcclusionBuffer::End() {
+	rasterizer.Flush();
+}
+// Returns true if the occluders hide the whole bounding sphere
+bool OcclusionBuffer::IsOccluded(const Vector3* center, float radius) {
+	int width = rasterizer.GetWidth();
+	int height = rasterizer.GetHeight();
+
+	// Project the corners of the box around the sphere; their screen rectangle holds the sphere,
+	// and the nearest corner is at least as near as any point of the sphere
+	float minX = (float)width, minY = (float)height, maxX = 0.0f, maxY = 0.0f, minDepth = 1.0f;
+	for(int i = 0; i < 8; i++) {
+		Vector3 corner(center->x + ((i & 1) ? radius : -radius), center->y + ((i & 2) ? radius : -radius),
+			center->z + ((i & 4) ? radius : -radius));
+		Vector4 position = viewProj.Transform(corner);
+		if(position.z < 0.0f || position.w <= 0.0f)
+			return false; // The sphere crosses the near plane
+		float invW = 1.0f / position.w;
+		float x = (position.x * invW * 0.5f + 0.5f) * (float)width;
+		float y = (0.5f - position.y * invW * 0.5f) * (float)height;
+		minX = Min(minX, x);
+		minY = Min(minY, y);
+		maxX = Max(maxX, x);
+		maxY = Max(maxY, y);
+		minDepth = Min(minDepth, position.z * invW);
+	}
+
+	// Occluders only cover the pixel centers they were drawn over, so grow the rectangle by a pixel
+	int x0 = Max((int)floorf(minX) - 1, 0);
+	int y0 = Max((int)floorf(minY) - 1, 0);
+	int x1 = Min((int)floorf(maxX) + 1, width - 1);
+	int y1 = Min((int)floorf(maxY) + 1, height - 1);
+	if(x0 > x1 || y0 > y1)
+		return false; // Off the screen; that's for frustum culling to decide
+
+	// The sphere is visible if any pixel of the rectangle is farther away than its nearest point
+	const float* depthBuffer = rasterizer.GetDepthBuffer();
+	int pitch = rasterizer.GetPitch();
+#ifdef RASTER_SSE
+	const __m128 nearest = _mm_set1_ps(minDepth);
+	const __m128 offsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128 firstX = _mm_set1_ps((float)x0);
+	const __m128 lastX = _mm_set1_ps((float)x1);
+	for(int y = y0; y <= y1; y++) {
+		const float* row = depthBuffer + y * pitch;
+		for(int x = x0 & ~3; x <= x1; x += 4) {
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(px, firstX), _mm_cmple_ps(px, lastX));
+			__m128 visible = _mm_and_ps(inside, _mm_cmpge_ps(_mm_loadu_ps(row + x), nearest));
+			if(_mm_movemask_ps(visible))
+				return false;
+		}
+	}
+#else
+	for(int y = y0; y <= y1; y++) {
+		const float* row = depthBuffer + y * pitch;
+		for(int x = x0; x <= x1; x++) {
+			if(row[x] >= minDepth)
+				return false;
+		}
+	}
+#endif
+	return true;
+}
+// Gets the width of the buffer in pixels
+int OcclusionBuffer::GetWidth() {
+	return rasterizer.GetWidth();
+}
+// Gets the height of the buffer in pixels
+int OcclusionBuffer::GetHeight() {
+	return rasterizer.GetHeight();
+}
+// Gets the number of occluder triangles rasterized by the last End()
+int OcclusionBuffer::GetNumTriangles() {
+	return rasterizer.GetNumTriangles();
+}
\ No newline at end of file
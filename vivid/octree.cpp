@@ -0,0 +1,185 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "octree.h"
+
+Octree::Octree(float nWorldSize, float nCellSize) {
+	worldSize = nWorldSize;
+
+	// Halve the world until the leaves are no bigger than the cell size
+	depth = 0;
+	float leafSize = worldSize;
+	while(leafSize > nCellSize && depth < 16) {
+		leafSize /= 2.0f;
+		depth++;
+	}
+
+	// The root reaches out forever so anything outside the world lands in the nodes along the edge
+	numNodes = 1;
+	numCells = 0;
+	root = new OctreeNode;
+	root->boxMin = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	root->boxMax = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+	root->center = Vector3(0.0f, 0.0f, 0.0f);
+	root->halfSize = worldSize / 2.0f;
+	for(int i = 0; i < 8; i++)
+		root->children[i] = 0;
+	root->cell = 0;
+}
+Octree::~Octree() {
+	DeleteNode(root);
+}
+// Gets every cell overlapped by the bounding box of the sphere
+void Octree::GetCells(Vector3 center, float radius, std::vector<Cell*>* cells) {
+	Vector3 boxMin(center.x - radius, center.y - radius, center.z - radius);
+	Vector3 boxMax(center.x + radius, center.y + radius, center.z + radius);
+	cells->clear();
+	Insert(root, 0, &boxMin, &boxMax, cells);
+}
+// Gets the cell at the position specified
+Cell* Octree::GetCell(Vector3 pos) {
+	std::vector<Cell*> cells;
+	Insert(root, 0, &pos, &pos, &cells);
+	return cells[0];
+}
+// Gets every cell that exists
+void Octree::GetAllCells(std::vector<Cell*>* cells) {
+	cells->clear();
+	CollectCells(root, cells);
+}
+// Gets the number of cells created so far
+int Octree::GetNumCells() {
+	return numCells;
+}
+// Gets the cells touching the sphere
+void Octree::QuerySphere(Vector3 center, float radius, std::vector<Cell*>* cells) {
+	cells->clear();
+	QuerySphere(root, &center, radius, cells);
+}
+// Gets the cells at least partially inside the frustum
+void Octree::QueryFrustum(Frustum* frustum, std::vector<Cell*>* cells) {
+	cells->clear();
+	QueryFrustum(root, frustum, cells);
+}
+// Gets the cells the ray passes through before it has traveled the specified length
+void Octree::QueryRay(Vector3 origin, Vector3 direction, float length, std::vector<Cell*>* cells) {
+	cells->clear();
+	QueryRay(root, &origin, &direction, length, cells);
+}
+// Gets the number of levels below the root
+int Octree::GetDepth() {
+	return depth;
+}
+// Gets the number of nodes created so far
+int Octree::GetNumNodes() {
+	return numNodes;
+}
+// Creates the specified child of the node
+OctreeNode* Octree::CreateNode(OctreeNode* parent, int index) {
+	OctreeNode* node = new OctreeNode;
+	numNodes++;
+
+	// Each child takes the half of the parent on one side of the split point along each axis
+	node->boxMin = parent->boxMin;
+	node->boxMax = parent->boxMax;
+	if(index & 1) node->boxMin.x = parent->center.x; else node->boxMax.x = parent->center.x;
+	if(index & 2) node->boxMin.y = parent->center.y; else node->boxMax.y = parent->center.y;
+	if(index & 4) node->boxMin.z = parent->center.z; else node->boxMax.z = parent->center.z;
+
+	// The split point comes from the real size of the node, since the boxes along the edge reach out forever
+	node->halfSize = parent->halfSize / 2.0f;
+	node->center.x = parent->center.x + ((index & 1) ? node->halfSize : -node->halfSize);
+	node->center.y = parent->center.y + ((index & 2) ? node->halfSize : -node->halfSize);
+	node->center.z = parent->center.z + ((index & 4) ? node->halfSize : -node->halfSize);
+
+	for(int i = 0; i < 8; i++)
+		node->children[i] = 0;
+	node->cell = 0;
+
+	parent->children[index] = node;
+	return node;
+}
+// Deletes the node, its children, and its cell
+void Octree::DeleteNode(OctreeNode* node) {
+	for(int i = 0; i < 8; i++) {
+		if(node->children[i])
+			DeleteNode(node->children[i]);
+	}
+	if(node->cell) {
+		node->cell->Clear(); // Make sure no mesh or light points to the cell
+		delete node->cell;
+	}
+	delete node;
+}
+// Adds the leaf cells under the node that overlap the box to the list; creates missing nodes
+void Octree::Insert(OctreeNode* node, int level, Vector3* boxMin, Vector3* boxMax, std::vector<Cell*>* cells) {
+	if(level == depth) {
+		if(!node->cell) {
+			node->cell = new Cell;
+			numCells++;
+		}
+		cells->push_back(node->cell);
+		return;
+	}
+	for(int i = 0; i < 8; i++) {
+		// Skip the children on the wrong side of the split point
+		if((i & 1) ? boxMax->x < node->center.x : boxMin->x >= node->center.x) continue;
+		if((i & 2) ? boxMax->y < node->center.y : boxMin->y >= node->center.y) continue;
+		if((i & 4) ? boxMax->z < node->center.z : boxMin->z >= node->center.z) continue;
+		OctreeNode* child = node->children[i];
+		if(!child)
+			child = CreateNode(node, i);
+		Insert(child, level + 1, boxMin, boxMax, cells);
+	}
+}
+// Adds every cell under the node to the list
+void Octree::CollectCells(OctreeNode* node, std::vector<Cell*>* cells) {
+	if(node->cell)
+		cells->push_back(node->cell);
+	for(int i = 0; i < 8; i++) {
+		if(node->children[i])
+			CollectCells(node->children[i], cells);
+	}
+}
+void Octree::QuerySphere(OctreeNode* node, Vector3* center, float radius, std::vector<Cell*>* cells) {
+	if(!SphereIntersectsBox(center, radius, &node->boxMin, &node->boxMax))
+		return;
+	if(node->cell)
+		cells->push_back(node->cell);
+	for(int i = 0; i < 8; i++) {
+		if(node->children[i])
+			QuerySphere(node->children[i], center, radius, cells);
+	}
+}
+void Octree::QueryFrustum(OctreeNode* node, Frustum* frustum, std::vector<Cell*>* cells) {
+	if(!frustum->IntersectsBox(&node->boxMin, &node->boxMax))
+		return;
+	if(node->cell)
+		cells->push_back(node->cell);
+	for(int i = 0; i < 8; i++) {
+		if(node->children[i])
+			QueryFrustum(node->children[i], frustum, cells);
+	}
+}
+void Octree::QueryRay(OctreeNode* node, Vector3* origin, Vector3* direction, float length, std::vector<Cell*>* cells) {
+	if(!RayIntersectsBox(origin, direction, length, &node->boxMin, &node->boxMax))
+		return;
+	if(node->cell)
+		cells->push_back(node->cell);
+	for(int i = 0; i < 8; i++) {
+		if(node->children[i])
+			QueryRay(node->children[i], origin, direction, length, cells);
+	}
+}
\ No newline at end of file
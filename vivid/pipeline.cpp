@@ -0,0 +1,143 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#include "pipeline.h"
+#include "loader.h"
+
+SnapshotQueue::SnapshotQueue() {
+	head = 0;
+	tail = 0;
+	for(int i = 0; i < SNAPSHOT_QUEUE_SIZE; i++)
+		snapshots[i] = 0;
+}
+// Adds a snapshot; only the producer calls it
+bool SnapshotQueue::Push(FrameSnapshot* snapshot) {
+	if(tail - head == SNAPSHOT_QUEUE_SIZE)
+		return false;
+	snapshots[tail % SNAPSHOT_QUEUE_SIZE] = snapshot;
+	AtomicAdd(&tail, 1); // The interlocked add makes the slot visible before the new tail
+	return true;
+}
+// Takes the oldest snapshot; only the consumer calls it
+FrameSnapshot* SnapshotQueue::Pop() {
+	if(head == tail)
+		return 0;
+	FrameSnapshot* snapshot = snapshots[head % SNAPSHOT_QUEUE_SIZE];
+	AtomicAdd(&head, 1); // The slot is read before the producer can reuse it
+	return snapshot;
+}
+RenderPipeline::RenderPipeline(int nMaxFramesInFlight, RenderFunction nFunction, void* nData) {
+	maxFramesInFlight = Max(1, Min(nMaxFramesInFlight, MAX_FRAMES_IN_FLIGHT));
+	function = nFunction;
+	data = nData;
+	frame = 0;
+
+	// The loader keeps creating resources on the game thread while the render thread draws
+	D3DDEVICE_CREATION_PARAMETERS parameters;
+	if(SUCCEEDED(vvd::GetDevice()->GetCreationParameters(&parameters)) && !(parameters.BehaviorFlags & D3DCREATE_MULTITHREADED))
+		vvd::Log("Vivid: RenderPipeline needs a device created after vvd::SetMultithreadedDevice(true)");
+
+	// Loads are finished between frames instead
+	Loader::SetDeferred(true);
+
+	// Every snapshot starts out free
+	for(int i = 0; i < maxFramesInFlight; i++)
+		done.Push(&snapshots[i]);
+	doneCount.Signal(maxFramesInFlight);
+
+	if(!thread.Start(Run, this))
+		vvd::Log("Vivid: Failed to start the render thread; frames are drawn by RenderPipeline::Submit()");
+}
+RenderPipeline::~RenderPipeline() {
+	Flush();
+	if(thread.IsRunning()) {
+		readyCount.Signal(); // Without a snapshot, which stops the render thread
+		thread.Join();
+	}
+	Loader::SetDeferred(false);
+}
+// Captures the scene into a free snapshot and hands it to the render thread
+void RenderPipeline::Submit(D3DXVECTOR3* cameraPos, D3DXVECTOR3* cameraLook, D3DXVECTOR3* cameraUp) {
+	// Finishing a load sets up effects the render thread may be drawing with, so let it catch up first;
+	// that only happens once for every mesh loaded in the background
+	if(Loader::IsReady()) {
+		Flush();
+		Loader::Update();
+	}
+
+	// Wait until the render thread is done with a snapshot
+	doneCount.Wait();
+	FrameSnapshot* snapshot = done.Pop();
+
+	// It still holds the statistics of the frame it was last drawn for
+	if(snapshot->frame >= 0) {
+		vvd::FrameStats* stats = vvd::GetFrameStats();
+		vvd::AddFrameStats(stats, &snapshot->stats);
+		stats->inputLatency += (float)((snapshot->presentTime - snapshot->inputTime) * 1000.0);
+		stats->inputLatencyFrames += snapshot->latencyFrames;
+	}
+	memset(&snapshot->stats, 0, sizeof(snapshot->stats));
+
+	snapshot->Capture();
+	snapshot->SetCamera(cameraPos, cameraLook, cameraUp);
+	snapshot->frame = frame;
+	snapshot->inputTime = vvd::GetInputTime();
+	AtomicAdd(&frame, 1);
+
+	ready.Push(snapshot);
+	if(thread.IsRunning()) {
+		readyCount.Signal();
+	} else {
+		DrawNext();
+	}
+}
+// Waits until the render thread has drawn every frame handed to it
+void RenderPipeline::Flush() {
+	// The snapshots come back in any order, so wait for all of them and put the counts back
+	for(int i = 0; i < maxFramesInFlight; i++)
+		doneCount.Wait();
+	doneCount.Signal(maxFramesInFlight);
+}
+// Gets the number of frames the game thread can run ahead of the screen
+int RenderPipeline::GetMaxFramesInFlight() {
+	return maxFramesInFlight;
+}
+// Render thread body
+void RenderPipeline::Run(void* nPipeline) {
+	RenderPipeline* pipeline = (RenderPipeline*)nPipeline;
+	while(true) {
+		pipeline->readyCount.Wait();
+		if(!pipeline->DrawNext())
+			return; // Signaled without a snapshot; the pipeline is being destroyed
+	}
+}
+// Draws the oldest ready snapshot and hands it back
+bool RenderPipeline::DrawNext() {
+	FrameSnapshot* snapshot = ready.Pop();
+	if(!snapshot)
+		return false;
+
+	// Everything the renderers count while drawing it goes back to the game thread with it
+	vvd::SetThreadFrameStats(&snapshot->stats);
+	function(snapshot, data);
+	vvd::SetThreadFrameStats(0);
+
+	// The frame is on the screen now; see how long ago its input was read
+	snapshot->presentTime = vvd::GetTime();
+	snapshot->latencyFrames = frame - snapshot->frame;
+
+	done.Push(snapshot);
+	doneCount.Signal();
+	return true;
+}
\ No newline at end of file
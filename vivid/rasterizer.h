@@ -0,0 +1,125 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#ifndef rasterizer_h
+#define rasterizer_h
+#include "vmath.h"
+#include "thread.h"
+#include "transform.h"
+#include "scene.h"
+#include "xfile.h"
+#include <vector>
+
+#define RASTER_TILE_SIZE 32 // Width and height of a screen tile in pixels
+#define MAX_RASTER_THREADS 16 // Most threads shading tiles, the calling thread included
+#define MAX_RASTER_LIGHTS 6 // Same as MAX_LIGHTS
+
+#if defined(__SSE__) || defined(_M_IX86) || defined(_M_X64)
+#define RASTER_SSE // Shade four pixels at a time
+#endif
+
+// Vertex after lighting and projection
+struct RasterVertex {
+	Vector4 position; // Clip space
+	Vector3 color; // Lit color
+};
+
+// Triangle set up for shading: edge functions and perspective correct attribute planes in screen space.
+// Each plane p is evaluated at a pixel center as p[0] * x + p[1] * y + p[2]
+struct RasterTriangle {
+	float edges[3][3]; // Positive inside; edge i is opposite vertex i
+	bool topLeft[3]; // True for top and left edges, which own the pixels exactly on them
+	float depth[3]; // z / w
+	float invW[3]; // 1 / w
+	float red[3]; // Color divided by w
+	float green[3];
+	float blue[3];
+	int minX, minY, maxX, maxY; // Pixel bounding box, clipped to the screen
+};
+
+// Draws lit, depth tested triangles on the CPU, for machines without a graphics card. Triangles are
+// transformed and binned into screen tiles by the calling thread, then Flush() shades the tiles on
+// several threads at once; no two threads ever write the same pixel
+class Rasterizer {
+public:
+	// numThreads includes the calling thread; 0 uses one per processor
+	Rasterizer(int nWidth, int nHeight, int nNumThreads);
+	~Rasterizer();
+	void SetViewProjection(const Matrix* nViewProj); // Sets the view projection matrix used by DrawTriangles()
+	void SetCullBackFaces(bool nCullBackFaces); // Skips counterclockwise triangles, like D3DCULL_CCW; on by default
+	void SetDepthOnly(bool nDepthOnly); // Only writes the depth buffer; skips lighting and colors. Off by default
+	// Sets the lights used by DrawTriangles(); the arrays the Renderer compiles for the effects.
+	// A position with w = 0 is a directional light shining from that direction
+	void SetLights(int nNumLights, const Vector4* positions, const Vector4* colors, const float* ranges, const Vector3* nAmbient);
+	void SetLights(std::vector<SceneLight*>* lights, const Vector3* nAmbient); // Sets the lights from a ranked light list,
+																			   // like SceneMesh::GetLights()
+	void Clear(unsigned int color); // Clears the color buffer to an A8R8G8B8 color and the depth buffer to 1
+	// Transforms, lights and bins triangles. Positions and normals are read every stride bytes; normals can be 0,
+	// which lights every vertex as if it faced the lights. Indices are 32 bit if indices32 is true, otherwise 16 bit
+	void DrawTriangles(const Matrix* world, const Vector4* diffuse, const void* positions, const void* normals, int stride,
+		int numVertices, const void* indices, bool indices32, int nNumTriangles);
+	// Draws a parsed X file at the transform's world matrix, each material's triangles in its diffuse color.
+	// Doesn't need Direct3D; every material transforms the vertices again, so few materials draw fastest
+	void DrawMesh(const XMeshData* mesh, Transform* transform);
+	void Flush(); // Shades the triangles binned since the last flush
+	const unsigned int* GetColorBuffer(); // A8R8G8B8 pixels, top row first, GetPitch() pixels per row
+	const float* GetDepthBuffer(); // z / w of every pixel, laid out like the color buffer
+	int GetWidth(); // Gets the width of the buffers in pixels
+	int GetHeight(); // Gets the height of the buffers in pixels
+	int GetPitch(); // Gets the number of pixels per row; the width rounded up to a multiple of 4
+	int GetNumThreads(); // Gets the number of threads shading tiles, the calling thread included
+	int GetNumTriangles(); // Gets the number of triangles shaded by the last Flush()
+	bool SaveTGA(const char* file); // Writes the color buffer to a 32 bit TGA file; returns false if it can't be written
+protected:
+	int width; // Buffer size in pixels
+	int height;
+	int pitch; // Pixels per row; padded to a multiple of 4 so aligned groups of four pixels stay inside a row
+	int tilesX; // Tiles across the screen
+	int tilesY; // Tiles down the screen
+	std::vector<unsigned int> colorBuffer; // A8R8G8B8 pixels
+	std::vector<float> depthBuffer; // z / w of the nearest triangle
+	Matrix viewProj; // View projection matrix
+	bool cullBackFaces; // True if counterclockwise triangles are skipped
+	bool depthOnly; // True if only the depth buffer is written
+	int numLights; // Lights used by DrawTriangles()
+	Vector4 lightPositions[MAX_RASTER_LIGHTS];
+	Vector3 lightColors[MAX_RASTER_LIGHTS];
+	float lightRanges[MAX_RASTER_LIGHTS];
+	Vector3 ambient; // Added to every vertex
+	std::vector<RasterVertex> vertices; // The vertices of the last DrawTriangles() call
+	std::vector<unsigned int> materialIndices; // The triangles of one material; used by DrawMesh()
+	std::vector<RasterTriangle> triangles; // Triangles binned since the last flush
+	std::vector<std::vector<int> > bins; // Indices of the triangles touching each tile
+	int numTriangles; // Triangles shaded by the last flush
+	// Threads
+	int numThreads; // Threads shading tiles, the calling thread included
+	Thread threads[MAX_RASTER_THREADS - 1]; // Helper threads
+	Semaphore start; // Signaled once per helper thread when there are tiles to shade
+	Semaphore finished; // Signaled by each helper thread once it runs out of tiles
+	Mutex tileMutex; // Guards nextTile
+	int nextTile; // Next tile to hand out
+	bool stopping; // Tells the helper threads to exit
+	static void Work(void* rasterizer); // Helper thread body
+	void ShadeTiles(); // Shades tiles until there are none left
+	void ShadeTile(int tile); // Shades every triangle in the tile's bin
+	Vector3 Light(const Vector3& position, const Vector3* normal); // Lights a vertex
+	void ClipTriangle(const RasterVertex* a, const RasterVertex* b, const RasterVertex* c); // Clips against the near plane
+	void SetupTriangle(const RasterVertex* a, const RasterVertex* b, const RasterVertex* c); // Sets up and bins a triangle
+private:
+	Rasterizer(const Rasterizer&); // The helper threads point at the rasterizer
+	Rasterizer& operator=(const Rasterizer&);
+};
+
+#endif
\ No newline at end of file
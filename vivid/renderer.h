@@ -1,84 +1,194 @@
-// Vivid Engine v0.01
-// Copyright (C) 2006 Evan Todd
-
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// version 2 as published by the Free Software Foundation.
-
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-// GNU General Public License (included in README.txt) for more details.
-
-// You can contact the author at evanofsky@sbcglobal.net.
-
-#ifndef renderer_h
-#define renderer_h
-#include "vivid.h"
-#include "mesh.h"
-#include "rendertarget.h"
-#include "imagefilter.h"
-
-class Renderer {
-public:
-	Renderer();
-	~Renderer();
-	Renderer(const Renderer& renderer);
-	void SetCameraPosition(D3DXVECTOR3* nCameraPos); // Sets the position of the camera
-	void SetCameraPosition(float x, float y, float z); // Sets the position of the camera
-	void SetCameraRotation(D3DXVECTOR3* look, D3DXVECTOR3* up); // Sets the rotation of the camera;
-																// Look defines where the camera points
-																// Up defines the rotation on the Z axis
-	void SetCullMode(DWORD nCullMode); // Three options: D3DCULL_NONE, D3DCULL_CW, and D3DCULL_CCW
-	void SetFillMode(DWORD nFillMode); // Three options: D3DFILL_POINT, D3DFILL_WIREFRAME, and D3DFILL_SOLID
-	void SetBackgroundColor(D3DCOLOR nBackgroundColor); // Sets the color of the background (in hex code)
-	void SetBackgroundTexture(IDirect3DTexture9* nBackgroundTex); // Sets the background texture
-	void SetProjectionMatrix(D3DXMATRIX* nProjectionMat); // Sets the projection matrix
-	void SetProjection(float nFovY, float aspect, float zn, float zf); // Generates the projection matrix
-																	  // based on the values given
-	void SetViewport(D3DVIEWPORT9* nView); // Sets the viewport
-	void SetViewport(DWORD x, DWORD y, DWORD width, DWORD height, float minZ, float maxZ); // Generates
-																// the viewport based on the values given
-	void CameraLookAt(D3DXVECTOR3* target); // Points the camera at the position specified
-	void CameraLookAt(float x, float y, float z); // Points the camera at the position specified
-	void SetRenderTarget(int index, RenderTarget* nTarget); // Sets the rendertarget
-	void SetTechnique(LPCSTR nTechnique); // Sets the desired effect technique
-	void SetDepthBias(float nBias); // Sets the depth bias
-	void Draw(); // Draws the entire scene
-	void Draw(std::vector<Cell*>* cells); // Draws the specified cells
-	void DrawShadows(); // Draws the entire scene's shadows
-	void ClearScreen(); // Clears the render target to the background color
-	void EnableFilter(ImageFilter* imgfilter);
-	void DisableFilter(ImageFilter* imgfilter);
-protected:
-	void DrawMesh(Mesh* mesh); // Draws a single mesh
-	UINT SetMaterial(Material* material, Mesh* mesh); // Sets the material handles;
-													// returns the number of passes required by the effect
-	void DrawRenderTargets(); // Draws the render targets on the right side of the screen
-	void CompileLightArray(std::vector<Cell*>* cells, Material* material); // Compiles light data from the cells provided
-	void BeginScene(); // Initializes rendering; called before rendering the scene
-	void EndScene(); // Ends rendering; called after rendering the scene
-	D3DXVECTOR3 GetCubeMapLook(int i); // Gets the specified look vector for cube map rendering
-	D3DXVECTOR3 GetCubeMapUp(int i); // Gets the specified up vector for cube map rendering
-	D3DXVECTOR3 cameraPos; // Position of the camera
-	D3DXVECTOR3 look; // The camera look vector; defines camera rotation
-	D3DXVECTOR3 up; // The camera up vector; defines camera rotation
-	D3DXMATRIX cameraMat; // The camera (view) matrix
-	D3DXMATRIX projectionMat; // The projection matrix
-	DWORD cullMode; // Cull mode: D3DCULL_NONE, D3DCULL_CW, or D3DCULL_CCW; defaults to D3DCULL_CCW
-	DWORD fillMode; // Fill mode: D3DFILL_WIREFRAME, D3DFILL_POINT, or D3DFILL_SOLID; defaults to D3DFILL_SOLID
-	D3DCOLOR backgroundColor; // Color of the background
-	IDirect3DTexture9* backgroundTex; // Background texture
-	D3DVIEWPORT9 view; // The viewport
-	std::vector<RenderTarget*> renderTargets; // RenderTarget to render on; defaults to the back buffer
-	std::list<ImageFilter*> filters;
-	bool Contains(ImageFilter* imgfilter);
-	std::list<ImageFilter*>::iterator GetFilter(ImageFilter* imgfilter);
-	LPCSTR technique; // Technique; the renderer will activate this technique if an effect supports it
-	float nearPlane; // The near clip plane
-	float farPlane; // The far clip plane
-	float fovY; // Field of vision; for projection matrix generation
-	float depthBias; // Depth bias
-};
-
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#ifndef renderer_h
+#define renderer_h
+#include "vivid.h"
+#include "mesh.h"
+#include "rendertarget.h"
+#include "imagefilter.h"
+#include "frustum.h"
+#include "transformbatch.h"
+#include "rasterizer.h"
+#include "occlusionbuffer.h"
+#include "snapshot.h"
+#include <algorithm>
+
+#define MAX_INSTANCES 256 // Maximum number of copies drawn by one instanced draw call
+#define MIN_INSTANCES 2 // Minimum number of copies worth an instanced draw call
+
+#define DRAW_LIST_GRAIN 64 // Meshes a draw list job culls and queues
+
+// A single mesh subset waiting to be drawn. Items are built on the job threads with everything the
+// render thread needs to submit them, so it only has to make the effect and device calls
+struct DrawItem {
+	Mesh* mesh; // The mesh that owns the subset
+	DWORD subset; // Index of the subset in the mesh
+	Material* material; // The subset's material
+	ID3DXEffect* effect; // The material's effect; 0 for the fixed function pipeline
+	ID3DXMesh* d3dmesh; // The mesh data; shared by copies of the same X file
+	UINT64 key; // Effect, mesh data and subset packed for sorting
+	MeshState* state; // World matrix, cells and lights of the mesh in the frame being drawn
+};
+
+// The draw items one job built; sorted before they're merged
+struct DrawList {
+	std::vector<DrawItem> opaque;
+	std::vector<DrawItem> alpha;
+	std::vector<DrawItem> translucent;
+	TransformBatch spheres; // Bounding spheres of the job's meshes, frustum culled four at a time
+	std::vector<int> visible; // Indices of the spheres inside the frustum
+	std::vector<DrawItem> scratch; // Where MergeDrawLists() merges two lists before swapping them in
+};
+
+class Renderer {
+public:
+	Renderer();
+	~Renderer();
+	Renderer(const Renderer& renderer);
+	void SetCameraPosition(D3DXVECTOR3* nCameraPos); // Sets the position of the camera
+	void SetCameraPosition(float x, float y, float z); // Sets the position of the camera
+	void SetCameraRotation(D3DXVECTOR3* look, D3DXVECTOR3* up); // Sets the rotation of the camera;
+																// Look defines where the camera points
+																// Up defines the rotation on the Z axis
+	void SetCullMode(DWORD nCullMode); // Three options: D3DCULL_NONE, D3DCULL_CW, and D3DCULL_CCW
+	void SetFillMode(DWORD nFillMode); // Three options: D3DFILL_POINT, D3DFILL_WIREFRAME, and D3DFILL_SOLID
+	void SetBackgroundColor(D3DCOLOR nBackgroundColor); // Sets the color of the background (in hex code)
+	void SetBackgroundTexture(IDirect3DTexture9* nBackgroundTex); // Sets the background texture
+	void SetProjectionMatrix(D3DXMATRIX* nProjectionMat); // Sets the projection matrix
+	void SetProjection(float nFovY, float aspect, float zn, float zf); // Generates the projection matrix
+																	  // based on the values given
+	void SetViewport(D3DVIEWPORT9* nView); // Sets the viewport
+	void SetViewport(DWORD x, DWORD y, DWORD width, DWORD height, float minZ, float maxZ); // Generates
+																// the viewport based on the values given
+	void CameraLookAt(D3DXVECTOR3* target); // Points the camera at the position specified
+	void CameraLookAt(float x, float y, float z); // Points the camera at the position specified
+	void SetRenderTarget(int index, RenderTarget* nTarget); // Sets the rendertarget
+	void SetTechnique(LPCSTR nTechnique); // Sets the desired effect technique
+	void SetDepthBias(float nBias); // Sets the depth bias
+	void SetFrustumCulling(bool nFrustumCulling); // Enables or disables frustum culling; enabled by default
+	void SetShadowCaching(bool nShadowCaching); // Enables or disables shadow map caching; enabled by default
+	// Enables or disables skipping meshes hidden behind the meshes marked with Mesh::SetOccluder(); enabled by default
+	void SetOcclusionCulling(bool nOcclusionCulling);
+	// Enables or disables hardware instancing; enabled by default. Only used for effects with "Instanced" techniques
+	void SetInstancing(bool nInstancing);
+	void Draw(); // Draws the entire scene
+	void Draw(std::vector<Cell*>* cells); // Draws the specified cells
+	void Draw(World* world); // Draws the cells of the world inside the view frustum
+	// Draws the meshes of a snapshot instead of the live ones; for a render thread. The camera isn't taken from it
+	void Draw(FrameSnapshot* nSnapshot);
+	void DrawShadows(); // Draws the entire scene's shadows
+	void DrawShadows(FrameSnapshot* nSnapshot); // Draws the shadows of a snapshot instead of the live scene
+	// Draws the entire scene into the rasterizer's buffers on the CPU instead of the device
+	// Meshes are lit per vertex by their strongest lights and aren't textured
+	void DrawSoftware(Rasterizer* rasterizer);
+	void ClearScreen(); // Clears the render target to the background color
+	void EnableFilter(ImageFilter* imgfilter);
+	void DisableFilter(ImageFilter* imgfilter);
+protected:
+	void QueueMesh(MeshState* state, std::vector<DrawItem>* queue); // Adds every subset of the mesh to the queue; safe on the job threads
+	void DrawQueue(std::vector<DrawItem>* queue); // Draws a sorted queue and empties it
+	static void SortQueue(std::vector<DrawItem>* queue); // Sorts the queue by effect, mesh data and subset
+	// Merges the sorted next list into the sorted list after its own items; scratch ends up holding the old list
+	static void MergeQueue(std::vector<DrawItem>* list, std::vector<DrawItem>* next, std::vector<DrawItem>* scratch);
+	// Merges each pair of draw lists mergeStep apart into the first of the pair, for pairs [first, last); a job
+	static void MergeDrawLists(void* renderer, int first, int last);
+	// Draws the items in [first, last) of the queue; all the items must share one effect
+	void DrawItems(std::vector<DrawItem>* queue, int first, int last);
+	// Draws each batch of the queue with one instanced draw call per pass; all the batches must share one effect
+	void DrawInstanced(std::vector<DrawItem>* queue, std::vector<std::pair<int, int> >* batches);
+	// Returns true if the mesh's bounding sphere is inside the view frustum and not hidden by the occluders
+	bool IsVisible(MeshState* state);
+	bool IsOccluded(MeshState* state); // Returns true if the occluders hide the mesh's bounding sphere
+	void DrawOccluders(); // Rasterizes the occluders inside the view frustum into the occlusion buffer
+	void DrawMeshes(); // Draws drawMeshes, or the snapshot's meshes if there is one
+	// Culls drawStates and builds their draw lists on the job threads, then merges the lists into sorted queues
+	void QueueVisibleMeshes();
+	// Culls drawStates[first, last), ranks the lights of the visible ones, and builds their sorted draw list; a job
+	static void BuildDrawList(void* renderer, int first, int last);
+	static void GetShadowBounds(void* renderer, int first, int last); // Gets the bounding spheres of shadowStates[first, last); a job
+	// Finds the meshes inside each cube face of shadowLights[first, last) and builds the sorted queues of
+	// the faces that have to be rendered again; a job
+	static void FindShadowCasters(void* renderer, int first, int last);
+	int FindVertexElement(ID3DXMesh* d3dmesh, BYTE usage); // Gets the offset of a float3 vertex element; -1 if there isn't one
+	UINT BeginEffect(Material* material, bool instanced); // Sets the technique and per-frame constants and begins the effect;
+														  // returns the number of passes required by the effect
+	void SetObject(DrawItem* item); // Sets the world matrix and lights of the item's mesh
+	void DrawRenderTargets(); // Draws the render targets on the right side of the screen
+	// Compiles the data of the strongest lights reaching the mesh and sends it to the material's effect
+	void CompileLightArray(MeshState* state, Material* material);
+	void GetLightState(Light* light, LightState* state); // Gets the parameters of the light in the frame being drawn
+	int GetLightingRevision(); // Gets Light::GetLightingRevision() in the frame being drawn
+	void UpdateView(); // Builds the view matrix and view frustum from the camera settings
+	void BeginScene(); // Initializes rendering; called before rendering the scene
+	void EndScene(); // Ends rendering; called after rendering the scene
+	D3DXVECTOR3 GetCubeMapLook(int i); // Gets the specified look vector for cube map rendering
+	D3DXVECTOR3 GetCubeMapUp(int i); // Gets the specified up vector for cube map rendering
+	D3DXVECTOR3 cameraPos; // Position of the camera
+	D3DXVECTOR3 look; // The camera look vector; defines camera rotation
+	D3DXVECTOR3 up; // The camera up vector; defines camera rotation
+	D3DXMATRIX cameraMat; // The camera (view) matrix
+	D3DXMATRIX projectionMat; // The projection matrix
+	DWORD cullMode; // Cull mode: D3DCULL_NONE, D3DCULL_CW, or D3DCULL_CCW; defaults to D3DCULL_CCW
+	DWORD fillMode; // Fill mode: D3DFILL_WIREFRAME, D3DFILL_POINT, or D3DFILL_SOLID; defaults to D3DFILL_SOLID
+	D3DCOLOR backgroundColor; // Color of the background
+	IDirect3DTexture9* backgroundTex; // Background texture
+	D3DVIEWPORT9 view; // The viewport
+	std::vector<RenderTarget*> renderTargets; // RenderTarget to render on; defaults to the back buffer
+	std::list<ImageFilter*> filters;
+	bool Contains(ImageFilter* imgfilter);
+	std::list<ImageFilter*>::iterator GetFilter(ImageFilter* imgfilter);
+	LPCSTR technique; // Technique; the renderer will activate this technique if an effect supports it
+	float nearPlane; // The near clip plane
+	float farPlane; // The far clip plane
+	float fovY; // Field of vision; for projection matrix generation
+	float depthBias; // Depth bias
+	bool frustumCulling; // True if meshes outside the view frustum are skipped
+	Frustum frustum; // The view frustum; built in UpdateView()
+	bool shadowCaching; // True if shadow map faces are only rendered when something inside them changed
+	bool occlusionCulling; // True if meshes hidden behind the occluders are skipped
+	OcclusionBuffer* occlusionBuffer; // Depth of the occluders; created the first time it's needed
+	bool occlusionReady; // True from DrawOccluders() to EndScene() if the occlusion buffer holds this scene's occluders
+	std::vector<DrawItem> opaqueQueue; // Opaque subsets waiting to be drawn
+	std::vector<DrawItem> alphaQueue; // Alpha subsets; drawn after the opaque ones
+	std::vector<DrawItem> translucentQueue; // Translucent subsets; drawn after the back buffer is copied
+	ID3DXEffect* lightEffect; // The effect the light arrays were last sent to; reset every scene
+	std::vector<SceneLight*> effectLights; // The lights last sent to lightEffect
+	std::vector<Cell*> effectCells; // The cells whose ambient colors were last sent to lightEffect
+	int effectLightCount; // The number of lights last sent to lightEffect
+	int effectLightingRevision; // Light::GetLightingRevision() when the lights were sent to lightEffect
+	std::vector<Cell*> visibleCells; // The cells of the world inside the view frustum
+	FrameSnapshot* snapshot; // The snapshot being drawn; 0 while drawing the live scene
+	std::vector<Mesh*> drawMeshes; // The meshes Draw() is considering: every mesh, or the ones inside its cells without duplicates
+	std::vector<MeshState> meshStates; // The states of drawMeshes; copied out by the jobs
+	std::vector<MeshState*> drawStates; // The states Draw() is considering: meshStates, or the snapshot's meshes
+	std::vector<DrawList> drawLists; // One for each DRAW_LIST_GRAIN meshes of drawStates; filled in by the jobs
+	int mergeStep; // Distance between the draw lists MergeDrawLists() pairs up
+	std::vector<MeshState> occluderStates; // The occluders DrawOccluders() is considering
+	std::vector<Mesh*> shadowMeshes; // Every mesh; for DrawShadows()
+	std::vector<MeshState> shadowMeshStates; // The states of shadowMeshes; copied out by the jobs
+	std::vector<MeshState*> shadowStates; // The states DrawShadows() is considering: shadowMeshStates, or the snapshot's meshes
+	std::vector<Vector3> shadowCenters; // World space bounding sphere of each of shadowStates
+	std::vector<float> shadowRadii;
+	std::vector<LightState> shadowLights; // Every light; for DrawShadows()
+	std::vector<std::vector<MeshState*> > shadowFaceCasters; // The meshes inside each cube face of each light; six per light
+	std::vector<std::vector<DrawItem> > shadowFaceQueues; // Sorted draw items of each cube face that has to be rendered
+	std::vector<char> shadowFaceCached; // True for the cube faces that still hold the right shadows
+	std::vector<DrawItem> singleQueue; // Subsets of an effect run that can't be instanced
+	std::vector<std::pair<int, int> > instanceBatches; // [first, last) ranges of an effect run drawn with instancing
+	bool instancing; // True if copies of the same mesh are drawn with one instanced draw call
+	IDirect3DVertexBuffer9* instanceBuffer; // Per-instance world matrices; created the first time it's needed
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "resource.h"
+#include "mesh.h"
+#include "material.h"
+
+std::vector<ResourceCache::Name*> ResourceCache::names;
+int ResourceCache::numNames = 0;
+std::vector<Resource*> ResourceCache::resources;
+int ResourceCache::numResources = 0;
+
+// Gets the cache's copy of the normalized name; the same name always gets the same pointer
+LPCSTR ResourceCache::Intern(LPCSTR name) {
+	// Windows file names aren't case sensitive, and either slash works
+	std::string normalized = name;
+	for(int i = 0; i < (int)normalized.size(); i++) {
+		char c = normalized[i];
+		if(c == '/')
+			normalized[i] = '\\';
+		else if(c >= 'A' && c <= 'Z')
+			normalized[i] = c - 'A' + 'a';
+	}
+
+	unsigned int hash = Hash(normalized.c_str());
+	if(!names.empty()) {
+		Name* entry = names[hash & (names.size() - 1)];
+		while(entry) {
+			if(entry->hash == hash && normalized == entry->name)
+				return entry->name;
+			entry = entry->next;
+		}
+	}
+
+	if(numNames >= (int)names.size())
+		GrowNames();
+	Name* entry = new Name;
+	entry->hash = hash;
+	entry->name = new char[normalized.size() + 1];
+	memcpy(entry->name, normalized.c_str(), normalized.size() + 1);
+	Name** bucket = &names[hash & (names.size() - 1)];
+	entry->next = *bucket;
+	*bucket = entry;
+	numNames++;
+	return entry->name;
+}
+// Gets the resource loaded from the file; 0 if there isn't one
+Resource* ResourceCache::Find(ResourceType type, LPCSTR name) {
+	if(numResources == 0 || !name)
+		return 0;
+	LPCSTR interned = Intern(name);
+	unsigned int hash = Hash(interned);
+	Resource* resource = resources[GetBucket(hash, type, resources.size())];
+	while(resource) {
+		// Interned names are equal only if their pointers are
+		if(resource->type == type && resource->name == interned)
+			return resource;
+		resource = resource->next;
+	}
+	return 0;
+}
+// Caches data loaded from the file, with one reference
+Resource* ResourceCache::Add(ResourceType type, LPCSTR name, void* data) {
+	if(numResources >= (int)resources.size())
+		GrowResources();
+	Resource* resource = new Resource;
+	resource->type = type;
+	resource->name = Intern(name);
+	resource->hash = Hash(resource->name);
+	resource->data = data;
+	resource->refs = 1;
+	Resource** bucket = &resources[GetBucket(resource->hash, type, resources.size())];
+	resource->next = *bucket;
+	*bucket = resource;
+	numResources++;
+	return resource;
+}
+// Adds a reference to the resource
+void ResourceCache::AddRef(Resource* resource) {
+	resource->refs++;
+}
+// Releases a reference; frees the resource when there are none left
+void ResourceCache::Release(Resource* resource) {
+	if(--resource->refs > 0)
+		return;
+
+	// Unlink it first; freeing a mesh releases the resources of its materials
+	Resource** link = &resources[GetBucket(resource->hash, resource->type, resources.size())];
+	while(*link != resource)
+		link = &(*link)->next;
+	*link = resource->next;
+	numResources--;
+
+	Free(resource);
+	delete resource;
+}
+// Gets the number of cached resources
+int ResourceCache::GetNumResources() {
+	return numResources;
+}
+// FNV-1a hash of a name
+unsigned int ResourceCache::Hash(LPCSTR name) {
+	unsigned int hash = 2166136261u;
+	while(*name) {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+// Mixes the type into the hash, so a mesh and a material with the same name don't share a bucket
+unsigned int ResourceCache::GetBucket(unsigned int hash, ResourceType type, size_t numBuckets) {
+	return (hash ^ ((unsigned int)type * 0x9E3779B9u)) & (unsigned int)(numBuckets - 1);
+}
+// Doubles the name table
+void ResourceCache::GrowNames() {
+	std::vector<Name*> old;
+	old.swap(names);
+	names.resize(Max(old.size() * 2, (size_t)MIN_RESOURCE_BUCKETS), 0);
+	for(int i = 0; i < (int)old.size(); i++) {
+		Name* entry = old[i];
+		while(entry) {
+			Name* next = entry->next;
+			Name** bucket = &names[entry->hash & (names.size() - 1)];
+			entry->next = *bucket;
+			*bucket = entry;
+			entry = next;
+		}
+	}
+}
+// Doubles the resource table
+void ResourceCache::GrowResources() {
+	std::vector<Resource*> old;
+	old.swap(resources);
+	resources.resize(Max(old.size() * 2, (size_t)MIN_RESOURCE_BUCKETS), 0);
+	for(int i = 0; i < (int)old.size(); i++) {
+		Resource* resource = old[i];
+		while(resource) {
+			Resource* next = resource->next;
+			Resource** bucket = &resources[GetBucket(resource->hash, resource->type, resources.size())];
+			resource->next = *bucket;
+			*bucket = resource;
+			resource = next;
+		}
+	}
+}
+// Frees the resource's data
+void ResourceCache::Free(Resource* resource) {
+	switch(resource->type) {
+	case RESOURCE_MESH:
+		delete (Mesh*)resource->data;
+		break;
+	case RESOURCE_MATERIAL:
+		delete (Material*)resource->data;
+		break;
+	case RESOURCE_EFFECT:
+		vvd::Release<ID3DXEffect*>(*(ID3DXEffect**)&resource->data);
+		break;
+	}
+	resource->data = 0;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#ifndef scene_h
+#define scene_h
+#include "vividcore.h"
+#include "vmath.h"
+#include "transform.h"
+#include <list>
+#include <vector>
+
+struct Cell;
+class SceneLight;
+
+#define MAX_LIGHTS 6
+
+// The part of a Mesh the World and the light ranking use: its transform, bounding sphere, cells and lights.
+// It doesn't need Direct3D, so the World builds on other platforms; Mesh adds the mesh data and materials
+class SceneMesh {
+public:
+	static std::list<SceneMesh*> meshes; // Every loaded mesh; Mesh adds itself once it's loaded
+	Transform transform; // World transform
+	SceneMesh();
+	SceneMesh(const SceneMesh& mesh); // Copies the transform and bounding sphere; the copy isn't in any cell
+	~SceneMesh(); // Takes the mesh out of its cells and the mesh list
+	void SetBounds(Vector3 nCenter, float nRadius); // Sets the bounding sphere, relative to the transform
+	std::vector<Cell*>* GetCells(); // Gets the list of cells this mesh is inside
+	// Gets the lights reaching the mesh from its cells, strongest first; at most MAX_LIGHTS
+	// Cached until the mesh or its cells change, or a light enters, leaves or changes in one of its cells
+	std::vector<SceneLight*>* GetLights();
+	Vector3 GetCenter(); // Gets the center of the mesh
+	Vector3 GetWorldCenter(); // Gets the center of the mesh in world space
+	float GetRadius(); // Gets the distance from the center to the outermost vertex of the mesh
+	void AddCell(Cell* cell); // Adds a cell to the list of cells this mesh is inside
+	void ClearCells(); // Clears the list of cells this mesh is inside
+	void RemoveCell(Cell* cell); // Removes a cell from the list of cells this mesh is inside
+	int GetCellRevision(); // Gets the transform revision the mesh was last assigned to a cell with
+	void SetCellRevision(int revision); // Sets the transform revision the mesh was last assigned to a cell with
+protected:
+	Vector3 center; // The center of the mesh
+	float radius; // The distance from the center to the outermost vertex of the mesh
+	std::vector<Cell*> cells; // List of cells this mesh is inside
+	int cellRevision; // Transform revision when the mesh was last assigned to a cell; -1 if never
+	std::vector<SceneLight*> lights; // The strongest lights reaching the mesh
+	int lightsRevision; // Transform revision when the lights were selected; -1 if they need selecting again
+	int lightingRevision; // SceneLight::GetLightingRevision() when the lights were selected
+	bool LightsChanged(); // Returns true if the lights have to be selected again
+	void SelectLights(); // Ranks the lights in the mesh's cells by how much they light the mesh and keeps the strongest
+};
+
+// The part of a Light the World and the light ranking use: its position, color, range and cells.
+// It doesn't need Direct3D; Light adds the light texture and the shadow map
+class SceneLight {
+public:
+	static std::list<SceneLight*> lights; // Every light except copies; lights add themselves
+	// Position of the light and rotation of its texture. Parent it to a mesh's transform to carry the light
+	// along; the position then becomes relative to the parent. The parent's rotation doesn't turn the texture
+	Transform transform;
+	SceneLight();
+	SceneLight(const SceneLight& light); // Copies the position, color and range; the copy isn't in any cell or the light list
+	~SceneLight(); // Takes the light out of its cells and the light list
+	void SetRange(float nRange); // Sets the range of the light
+	float GetRange(); // Gets the range
+	void SetColor(float r, float g, float b); // Sets the color of the light
+	Vector3 GetColor(); // Gets the color
+	void SetPosition(float x, float y, float z, float nw); // Sets the position of the light, relative to the parent of its transform;
+														  // make W 0.0f if you want the light to be directional. Parents don't move directional lights
+	Vector4 GetPosition(); // Gets the position in world space, as of the last SetPosition() or UpdateLights()
+	void ClearCells(); // Clears the list of cells this light affects
+	void AddCell(Cell* cell); // Adds the specified cell to the list of cells this light affects
+	void RemoveCell(Cell* cell); // Removes a cell from the list of cells this light affects
+	std::vector<Cell*>* GetCells(); // Gets the list of cells this light affects
+	int GetRevision(); // Gets a number that changes whenever the light moves, changes range or is recolored
+	int GetCellRevision(); // Gets the revision the light was last assigned to cells with
+	void SetCellRevision(int nRevision); // Sets the revision the light was last assigned to cells with
+	int GetShadowRevision(); // Gets a number that changes whenever the light moves, changes range or its shadow map is invalidated
+	// Gets a number that changes whenever any light is created, destroyed, moved, recolored,
+	// changes range, or changes cells; meshes use it to know when to select their lights again
+	static int GetLightingRevision();
+	// Picks up the lights that moved through their transforms or the parents of their transforms since the last call;
+	// call once per frame after Transform::UpdateHierarchy(). World::Update() and FrameSnapshot::Capture() do
+	static void UpdateLights();
+protected:
+	Vector3 color; // The color of the light
+	Vector4 position; // The position of the light in world space
+	float positionW; // W of the position; 0.0f for directional lights
+	int positionRevision; // Revision of the transform the position was last computed from
+	void UpdatePosition(); // Computes the position from the transform; a change moves the light
+	void Changed(); // Bumps the revisions and tells the light's cells after it moved, changed range or was recolored
+	float range; // The maximum distance from which the light can affect an object
+	std::vector<Cell*> cells; // List of cells this light affects
+	int revision; // Changes whenever the light moves, changes range or is recolored
+	int cellRevision; // Revision when the light was last assigned to cells; -1 if never
+	int shadowRevision; // Changes whenever the light moves, changes range or the shadow map is invalidated
+	static int lightingRevision; // Changes whenever any light changes
+};
+
+#endif
\ No newline at end of file
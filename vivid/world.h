@@ -1,67 +1,58 @@
-// Vivid Engine v0.01
-// Copyright (C) 2006 Evan Todd
-
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// version 2 as published by the Free Software Foundation.
-
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-// GNU General Public License (included in README.txt) for more details.
-
-// You can contact the author at evanofsky@sbcglobal.net.
-
-#ifndef world_h
-#define world_h
-#include "vivid.h"
-#include "mesh.h"
-#include <vector>
-#include "light.h"
-
-class Mesh;
-class Light;
-
-// The World is divided into Cells, which contain Meshes and Lights
-struct Cell {
-public:
-	Cell();
-	bool Contains(Mesh* mesh); // Returns true if the cell contains the specified mesh
-	bool Contains(Light* light); // Returns true if the cell contains the specified light
-	void AddMesh(Mesh* mesh); // Adds the specified mesh to the cell
-	void AddLight(Light* light); // Adds the specified light to the cell
-	void Clear(); // Clears the lists of lights and meshes
-	void SetAmbientColor(D3DXVECTOR3 nColor); // Sets the ambient color of the cell
-	D3DXVECTOR4 GetAmbientColor(); // Gets the ambient color of the cell
-	std::vector<Light*>* GetLights(); // Gets the list of lights in the cell
-	std::vector<Mesh*>* GetMeshes(); // Gets the list of meshes in the cell
-private:
-	D3DXVECTOR4 color; // Ambient color
-	std::vector<Mesh*> meshes; // List of meshes in the cell
-	std::vector<Light*> lights; // List of lights in the cell
-};
-
-class World {
-public:
-	World();
-	World(float nWorldSizeX, float nWorldSizeY, float nWorldSizeZ, float nCellSizeX, float nCellSizeY, float nCellSizeZ);
-	void Update(); // Assigns lights and meshes to cells; called once every frame
-	void SetAmbientColor(D3DXVECTOR3 pos, D3DXVECTOR3 color); // Sets the ambient color of the cell at the position specified
-	std::vector<Cell>* GetCells(); // Gets the list of cells in the world
-private:
-	Cell* GetCell(D3DXVECTOR3 pos); // Gets the cell at the position specified
-	void SetSize(float nWorldSizeX, float nWorldSizeY, float nWorldSizeZ, float nCellSizeX, float nCellSizeY, float nCellSizeZ);
-	float worldSizeX; // World size along the X axis
-	float worldSizeY; // World size along the Y axis
-	float worldSizeZ; // World size along the Z axis
-	float cellSizeX; // Cell size along the X axis
-	float cellSizeY; // Cell size along the Y axis
-	float cellSizeZ; // Cell size along the Z axis
-	int numCellsX; // Number of cells along the X axis
-	int numCellsY; // Number of cells along the Y axis
-	int numCellsZ; // Number of cells along the Z axis
-	int numCells; // Total number of cells
-	std::vector<Cell> cells; // List of cells in the world
-};
-
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+#ifndef world_h
+#define world_h
+#include "vividcore.h"
+#include <vector>
+#include "scene.h"
+#include "spatialindex.h"
+#include "cell.h"
+
+// The World keeps track of which Cells every Mesh and Light is inside; a SpatialIndex decides where the cells are
+// It only uses the SceneMesh and SceneLight parts of them, so it doesn't need Direct3D
+class World {
+public:
+	World();
+	// Divides the world into a UniformGrid of equally sized cells
+	World(float nWorldSizeX, float nWorldSizeY, float nWorldSizeZ, float nCellSizeX, float nCellSizeY, float nCellSizeZ);
+	World(SpatialIndex* nIndex); // Uses the specified spatial index; the World deletes it
+	~World();
+	void Update(); // Moves lights and meshes whose bounding spheres crossed a cell boundary to their new cells;
+				   // called once every frame
+	void SetAmbientColor(Vector3 pos, Vector3 color); // Sets the ambient color of the cell at the position specified
+	SpatialIndex* GetIndex(); // Gets the spatial index
+	void GetCells(std::vector<Cell*>* cells); // Gets every cell in the world
+	void QuerySphere(Vector3 center, float radius, std::vector<Cell*>* cells); // Gets the cells touching the sphere
+	void QueryFrustum(Frustum* frustum, std::vector<Cell*>* cells); // Gets the cells at least partially inside the frustum
+	// Gets the cells the ray passes through before it has traveled the specified length; the direction must be normalized
+	void QueryRay(Vector3 origin, Vector3 direction, float length, std::vector<Cell*>* cells);
+private:
+	World(const World& world); // Not copyable; the World owns its index
+	void AssignCells(SceneMesh* mesh, std::vector<Cell*>* nCells); // Moves the mesh from its current cells to the specified cells
+	void AssignCells(SceneLight* light, std::vector<Cell*>* nCells); // Moves the light from its current cells to the specified cells
+	void Clear(); // Takes every light and mesh out of the cells
+	// Finds which of meshes[first, last) moved since they were assigned to cells and gets their bounding spheres; a job
+	static void FindMovedMeshes(void* world, int first, int last);
+	SpatialIndex* index; // Decides which cells objects are inside
+	std::vector<Cell*> cells; // Scratch list for Update()
+	std::vector<SceneMesh*> meshes; // Every mesh; scratch list for Update()
+	std::vector<char> moved; // True for the meshes that need new cells
+	std::vector<int> revisions; // Transform revision of each mesh
+	std::vector<Vector3> centers; // World space bounding sphere of each mesh that moved
+	std::vector<float> radii;
+	int lightCellCount; // Number of cells in the index when the lights were last assigned; -1 to assign them all again
+};
+
 #endif
\ No newline at end of file
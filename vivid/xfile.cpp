@@ -0,0 +1,659 @@
+// Vivid Engine v0.01
+// Copyright (C) 2006 Evan Todd
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// version 2 as published by the Free Software Foundation.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License (included in README.txt) for more details.
+
+// You can contact the author at evanofsky@sbcglobal.net.
+
+
+#include "xfile.h"
+#include <stdio.h>
+#include <string.h>
+
+// Binary format tokens
+#define XBIN_NAME 1
+#define XBIN_STRING 2
+#define XBIN_INTEGER 3
+#define XBIN_GUID 5
+#define XBIN_INTEGER_LIST 6
+#define XBIN_FLOAT_LIST 7
+#define XBIN_OBRACE 10
+#define XBIN_CBRACE 11
+
+XFile::XFile() {
+	data = 0;
+	pos = 0;
+	end = 0;
+	binary = false;
+	doubles = false;
+	listCount = 0;
+	listFloats = false;
+	line = 1;
+	output = 0;
+}
+// Maps and parses the file; returns false on errors
+bool XFile::Load(const char* nFile, XMeshData* mesh) {
+	if(!file.Open(nFile)) {
+		error = "Couldn't open ";
+		error += nFile;
+		return false;
+	}
+	bool result = Parse(file.GetData(), file.GetSize(), mesh);
+	file.Close();
+	return result;
+}
+// Parses a file already in memory
+bool XFile::Parse(const char* nData, size_t size, XMeshData* mesh) {
+	data = nData;
+	pos = data;
+	end = data + size;
+	line = 1;
+	listCount = 0;
+	error = "";
+	output = mesh;
+	namedMaterials.clear();
+	*mesh = XMeshData();
+
+	// Header: "xof 0302txt 0032"; the format is txt, bin, tzip or bzip and the float size is 0032 or 0064
+	if(size < 16 || strncmp(data, "xof ", 4) != 0)
+		return Fail("Not an X file");
+	if(strncmp(data + 8, "txt ", 4) == 0) {
+		binary = false;
+	} else if(strncmp(data + 8, "bin ", 4) == 0) {
+		binary = true;
+	} else {
+		return Fail("Compressed X files aren't supported");
+	}
+	doubles = strncmp(data + 12, "0064", 4) == 0;
+	pos = data + 16;
+
+	Matrix identity = Matrix::Identity();
+	while(true) {
+		XToken token = Next();
+		if(token.type == XTOKEN_END)
+			break;
+		if(token.type != XTOKEN_NAME)
+			return Fail("Expected a template or data object");
+		if(IsName(&token, "template")) {
+			// Templates only describe the layout; the objects we read have fixed layouts
+			if(!OpenObject() || !SkipObject())
+				return false;
+		} else if(!ParseObject(&token, &identity)) {
+			return false;
+		}
+	}
+
+	if(output->positions.empty())
+		return Fail("The file has no meshes");
+	return true;
+}
+// Describes the last error
+const char* XFile::GetError() {
+	return error.c_str();
+}
+// Parses a data object whose type token was just read
+bool XFile::ParseObject(XToken* type, Matrix* parentMatrix) {
+	if(IsName(type, "Frame"))
+		return ParseFrame(parentMatrix);
+	if(IsName(type, "Mesh"))
+		return ParseMesh(parentMatrix);
+	if(IsName(type, "Material")) {
+		// Top level materials are referenced by name from the meshes' material lists
+		XToken name = Next();
+		if(name.type != XTOKEN_NAME)
+			return Fail("Top level materials need a name");
+		XMaterial material;
+		if(!Expect(XTOKEN_OBRACE) || !ParseMaterial(&material))
+			return false;
+		namedMaterials[std::string(name.text, name.length)] = material;
+		return true;
+	}
+	// Header, animations, skinning and anything else we don't use
+	return OpenObject() && SkipObject();
+}
+// Parses the body of a Frame
+bool XFile::ParseFrame(Matrix* parentMatrix) {
+	if(!OpenObject())
+		return false;
+	Matrix world = *parentMatrix;
+	while(true) {
+		XToken token = Next();
+		if(token.type == XTOKEN_CBRACE)
+			return true;
+		if(token.type == XTOKEN_OBRACE) {
+			if(!SkipObject()) // Reference to another frame
+				return false;
+		} else if(IsName(&token, "FrameTransformMatrix")) {
+			if(!OpenObject())
+				return false;
+			Matrix local;
+			for(int i = 0; i < 16; i++) {
+				if(!ReadFloat(&local.m[i / 4][i % 4]))
+					return false;
+			}
+			if(!Expect(XTOKEN_CBRACE))
+				return false;
+			world = local * *parentMatrix;
+		} else if(token.type == XTOKEN_NAME) {
+			if(!ParseObject(&token, &world))
+				return false;
+		} else {
+			return Fail("Unexpected token in frame");
+		}
+	}
+}
+// Parses the body of a Mesh and adds it to the output
+bool XFile::ParseMesh(Matrix* worldMatrix) {
+	if(!OpenObject())
+		return false;
+
+	unsigned int numVertices;
+	if(!ReadCount(&numVertices) || !CheckCount(numVertices, 3))
+		return false;
+	std::vector<Vector3> positions(numVertices);
+	for(unsigned int i = 0; i < numVertices; i++) {
+		if(!ReadFloat(&positions[i].x) || !ReadFloat(&positions[i].y) || !ReadFloat(&positions[i].z))
+			return false;
+	}
+	std::vector<unsigned int> faces;
+	if(!ParseFaces(&faces))
+		return false;
+
+	std::vector<Vector3> normals;
+	std::vector<unsigned int> normalFaces;
+	std::vector<float> texcoords;
+	std::vector<unsigned int> faceMaterials;
+	std::vector<XMaterial> materials;
+	while(true) {
+		XToken token = Next();
+		if(token.type == XTOKEN_CBRACE)
+			break;
+		if(token.type != XTOKEN_NAME)
+			return Fail("Unexpected token in mesh");
+		if(IsName(&token, "MeshNormals")) {
+			unsigned int numNormals;
+			if(!OpenObject() || !ReadCount(&numNormals) || !CheckCount(numNormals, 3))
+				return false;
+			normals.resize(numNormals);
+			for(unsigned int i = 0; i < numNormals; i++) {
+				if(!ReadFloat(&normals[i].x) || !ReadFloat(&normals[i].y) || !ReadFloat(&normals[i].z))
+					return false;
+			}
+			if(!ParseFaces(&normalFaces) || !Expect(XTOKEN_CBRACE))
+				return false;
+		} else if(IsName(&token, "MeshTextureCoords")) {
+			unsigned int numCoords;
+			if(!OpenObject() || !ReadCount(&numCoords) || !CheckCount(numCoords, 2))
+				return false;
+			texcoords.resize(numCoords * 2);
+			for(unsigned int i = 0; i < numCoords * 2; i++) {
+				if(!ReadFloat(&texcoords[i]))
+					return false;
+			}
+			if(!Expect(XTOKEN_CBRACE))
+				return false;
+		} else if(IsName(&token, "MeshMaterialList")) {
+			if(!ParseMaterialList(&faceMaterials, &materials))
+				return false;
+		} else if(!OpenObject() || !SkipObject()) {
+			return false;
+		}
+	}
+	if(normalFaces.size() != faces.size())
+		normals.clear(); // The normal faces have to match the position faces
+	if(texcoords.size() != positions.size() * 2)
+		texcoords.clear();
+
+	// Meshes without a material list get a blank material
+	unsigned int firstMaterial = (unsigned int)output->materials.size();
+	if(materials.empty()) {
+		XMaterial material;
+		material.diffuse = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+		material.power = 0.0f;
+		material.specular = Vector3(0.0f, 0.0f, 0.0f);
+		material.emissive = Vector3(0.0f, 0.0f, 0.0f);
+		materials.push_back(material);
+	}
+	output->materials.insert(output->materials.end(), materials.begin(), materials.end());
+
+	// The first mesh decides whether the merged mesh has normals and texture coordinates
+	bool first = output->positions.empty();
+	bool hasNormals = first ? !normals.empty() : !output->normals.empty();
+	bool hasTexcoords = first ? !texcoords.empty() : !output->texcoords.empty();
+
+	// Split the vertices wherever a position is used with more than one normal,
+	// and fan triangulate faces with more than three corners
+	std::map<std::pair<unsigned int, unsigned int>, unsigned int> vertices;
+	unsigned int face = 0;
+	for(size_t i = 0; i < faces.size(); face++) {
+		unsigned int numCorners = faces[i];
+		std::vector<unsigned int> corners;
+		for(unsigned int j = 0; j < numCorners; j++) {
+			unsigned int position = faces[i + 1 + j];
+			unsigned int normal = normals.empty() ? 0 : normalFaces[i + 1 + j];
+			if(position >= numVertices || (!normals.empty() && (normalFaces[i] != numCorners || normal >= normals.size())))
+				return Fail("Face index out of range");
+
+			std::pair<unsigned int, unsigned int> key(position, normal);
+			std::map<std::pair<unsigned int, unsigned int>, unsigned int>::iterator found = vertices.find(key);
+			if(found != vertices.end()) {
+				corners.push_back(found->second);
+				continue;
+			}
+			unsigned int index = (unsigned int)output->positions.size();
+			vertices[key] = index;
+			corners.push_back(index);
+			output->positions.push_back(worldMatrix->TransformCoord(positions[position]));
+			if(hasNormals) {
+				Vector3 n = normals.empty() ? Vector3(0.0f, 0.0f, 0.0f) : normals[normal];
+				output->normals.push_back(worldMatrix->TransformNormal(n).Normalized());
+			}
+			if(hasTexcoords) {
+				output->texcoords.push_back(texcoords.empty() ? 0.0f : texcoords[position * 2]);
+				output->texcoords.push_back(texcoords.empty() ? 0.0f : texcoords[position * 2 + 1]);
+			}
+		}
+
+		// Later faces without an index use the last one
+		unsigned int material = 0;
+		if(!faceMaterials.empty())
+			material = faceMaterials[Min((size_t)face, faceMaterials.size() - 1)];
+		if(material >= materials.size())
+			return Fail("Material index out of range");
+		for(unsigned int j = 2; j < numCorners; j++) {
+			output->indices.push_back(corners[0]);
+			output->indices.push_back(corners[j - 1]);
+			output->indices.push_back(corners[j]);
+			output->attributes.push_back(firstMaterial + material);
+		}
+		i += numCorners + 1;
+	}
+	return true;
+}
+// Reads a face count and the faces as count, index, index...
+bool XFile::ParseFaces(std::vector<unsigned int>* faces) {
+	unsigned int numFaces;
+	if(!ReadCount(&numFaces))
+		return false;
+	faces->clear();
+	for(unsigned int i = 0; i < numFaces; i++) {
+		unsigned int numCorners;
+		if(!ReadCount(&numCorners))
+			return false;
+		faces->push_back(numCorners);
+		for(unsigned int j = 0; j < numCorners; j++) {
+			unsigned int index;
+			if(!ReadCount(&index))
+				return false;
+			faces->push_back(index);
+		}
+	}
+	return true;
+}
+// Parses a MeshMaterialList; the materials are either inline or references to top level ones
+bool XFile::ParseMaterialList(std::vector<unsigned int>* faceMaterials, std::vector<XMaterial>* materials) {
+	unsigned int numMaterials, numIndices;
+	if(!OpenObject() || !ReadCount(&numMaterials) || !ReadCount(&numIndices) || !CheckCount(numIndices, 1))
+		return false;
+	faceMaterials->resize(numIndices);
+	for(unsigned int i = 0; i < numIndices; i++) {
+		if(!ReadCount(&(*faceMaterials)[i]))
+			return false;
+	}
+
+	materials->clear();
+	while(true) {
+		XToken token = Next();
+		if(token.type == XTOKEN_CBRACE)
+			break;
+		if(token.type == XTOKEN_OBRACE) {
+			// { name } refers to a top level material
+			XToken name = Next();
+			if(name.type != XTOKEN_NAME)
+				return Fail("Expected a material name");
+			std::map<std::string, XMaterial>::iterator found = namedMaterials.find(std::string(name.text, name.length));
+			if(found == namedMaterials.end())
+				return Fail("Reference to an unknown material");
+			materials->push_back(found->second);
+			if(!SkipObject())
+				return false;
+		} else if(IsName(&token, "Material")) {
+			XMaterial material;
+			if(!OpenObject() || !ParseMaterial(&material))
+				return false;
+			materials->push_back(material);
+		} else if(token.type == XTOKEN_NAME) {
+			if(!OpenObject() || !SkipObject())
+				return false;
+		} else {
+			return Fail("Unexpected token in material list");
+		}
+	}
+	if(materials->size() < numMaterials)
+		return Fail("Material list is missing materials");
+	return true;
+}
+// Parses the body of a Material
+bool XFile::ParseMaterial(XMaterial* material) {
+	if(!ReadFloat(&material->diffuse.x) || !ReadFloat(&material->diffuse.y) || !ReadFloat(&material->diffuse.z) ||
+		!ReadFloat(&material->diffuse.w) || !ReadFloat(&material->power) ||
+		!ReadFloat(&material->specular.x) || !ReadFloat(&material->specular.y) || !ReadFloat(&material->specular.z) ||
+		!ReadFloat(&material->emissive.x) || !ReadFloat(&material->emissive.y) || !ReadFloat(&material->emissive.z)) {
+		return false;
+	}
+	material->textureFilename = "";
+	while(true) {
+		XToken token = Next();
+		if(token.type == XTOKEN_CBRACE)
+			return true;
+		if(IsName(&token, "TextureFilename")) {
+			if(!OpenObject() || !ParseTextureFilename(&material->textureFilename))
+				return false;
+		} else if(token.type == XTOKEN_NAME) {
+			if(!OpenObject() || !SkipObject())
+				return false;
+		} else if(token.type == XTOKEN_OBRACE) {
+			if(!SkipObject())
+				return false;
+		} else {
+			return Fail("Unexpected token in material");
+		}
+	}
+}
+// Parses the body of a TextureFilename
+bool XFile::ParseTextureFilename(std::string* filename) {
+	return ReadString(filename) && Expect(XTOKEN_CBRACE);
+}
+// Skips the rest of an object whose opening brace was just read
+bool XFile::SkipObject() {
+	int depth = 1;
+	while(depth > 0) {
+		XToken token = Next();
+		if(token.type == XTOKEN_OBRACE) {
+			depth++;
+		} else if(token.type == XTOKEN_CBRACE) {
+			depth--;
+		} else if(token.type == XTOKEN_END) {
+			return Fail("Unexpected end of file");
+		} else if(token.type == XTOKEN_ERROR) {
+			return false;
+		}
+	}
+	return true;
+}
+// Skips the optional name and GUID of an object and reads its opening brace
+bool XFile::OpenObject() {
+	XToken token = Next();
+	if(token.type == XTOKEN_NAME)
+		token = Next();
+	if(token.type != XTOKEN_OBRACE)
+		return Fail("Expected {");
+	return true;
+}
+// Reads the next token as a number
+bool XFile::ReadNumber(double* number) {
+	XToken token = Next();
+	if(token.type != XTOKEN_NUMBER)
+		return Fail("Expected a number");
+	*number = token.number;
+	return true;
+}
+// Reads the next token as an element count
+bool XFile::ReadCount(unsigned int* count) {
+	double number;
+	if(!ReadNumber(&number))
+		return false;
+	if(!(number >= 0.0))
+		return Fail("Expected a positive number");
+	if(number > 4294967295.0)
+		return Fail("Count out of range"); // Casting it would be undefined
+	*count = (unsigned int)number;
+	return true;
+}
+// Fails unless the rest of the file could hold count elements made of the specified number of numbers
+bool XFile::CheckCount(unsigned int count, unsigned int numbers) {
+	// Every number takes at least a byte in either format, so a corrupt count can't allocate much more than the file
+	if(count > (size_t)(end - pos) / numbers)
+		return Fail("Count is larger than the file");
+	return true;
+}
+// Reads the next token as a float
+bool XFile::ReadFloat(float* number) {
+	double value;
+	if(!ReadNumber(&value))
+		return false;
+	*number = (float)value;
+	return true;
+}
+// Reads the next token as a string
+bool XFile::ReadString(std::string* string) {
+	XToken token = Next();
+	if(token.type != XTOKEN_STRING)
+		return Fail("Expected a string");
+	string->assign(token.text, token.length);
+	return true;
+}
+// Reads the next token and fails unless it has the type specified
+bool XFile::Expect(XTokenType type) {
+	XToken token = Next();
+	if(token.type != type)
+		return Fail(type == XTOKEN_CBRACE ? "Expected }" : "Unexpected token");
+	return true;
+}
+// Sets the error message and returns false
+bool XFile::Fail(const char* message) {
+	if(!error.empty())
+		return false; // Keep the first error
+	error = message;
+	if(!binary) {
+		char lineText[32];
+		sprintf(lineText, " on line %d", line);
+		error += lineText;
+	}
+	return false;
+}
+// Returns true if the token is the name specified
+bool XFile::IsName(XToken* token, const char* name) {
+	return token->type == XTOKEN_NAME && strlen(name) == token->length && strncmp(token->text, name, token->length) == 0;
+}
+// Reads the next token
+XToken XFile::Next() {
+	return binary ? NextBinary() : NextText();
+}
+// Reads the next token of a text file
+XToken XFile::NextText() {
+	XToken token;
+	token.type = XTOKEN_END;
+	token.text = 0;
+	token.length = 0;
+	token.number = 0.0;
+
+	// Skip whitespace, separators and comments
+	while(pos < end) {
+		char c = *pos;
+		if(c == '\n') {
+			line++;
+			pos++;
+		} else if(c == ' ' || c == '\t' || c == '\r' || c == ',' || c == ';') {
+			pos++;
+		} else if(c == '#' || (c == '/' && pos + 1 < end && pos[1] == '/')) {
+			while(pos < end && *pos != '\n')
+				pos++;
+		} else {
+			break;
+		}
+	}
+	if(pos >= end)
+		return token;
+
+	char c = *pos;
+	if(c == '{' || c == '}') {
+		token.type = c == '{' ? XTOKEN_OBRACE : XTOKEN_CBRACE;
+		pos++;
+	} else if(c == '"') {
+		const char* start = ++pos;
+		while(pos < end && *pos != '"')
+			pos++;
+		if(pos >= end) {
+			Fail("Unterminated string");
+			token.type = XTOKEN_ERROR;
+			return token;
+		}
+		token.type = XTOKEN_STRING;
+		token.text = start;
+		token.length = pos - start;
+		pos++;
+	} else if(c == '<') {
+		while(pos < end && *pos != '>')
+			pos++;
+		pos++;
+		token.type = XTOKEN_OTHER; // GUID
+	} else if((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.') {
+		// Parse the number in place; the file isn't null terminated, so strtod can't be used
+		double sign = 1.0;
+		if(*pos == '-' || *pos == '+') {
+			if(*pos == '-')
+				sign = -1.0;
+			pos++;
+		}
+		double value = 0.0;
+		while(pos < end && *pos >= '0' && *pos <= '9')
+			value = value * 10.0 + (*pos++ - '0');
+		if(pos < end && *pos == '.') {
+			pos++;
+			double scale = 0.1;
+			while(pos < end && *pos >= '0' && *pos <= '9') {
+				value += (*pos++ - '0') * scale;
+				scale *= 0.1;
+			}
+		}
+		if(pos < end && (*pos == 'e' || *pos == 'E')) {
+			pos++;
+			int exponentSign = 1;
+			if(pos < end && (*pos == '-' || *pos == '+')) {
+				if(*pos == '-')
+					exponentSign = -1;
+				pos++;
+			}
+			int exponent = 0;
+			while(pos < end && *pos >= '0' && *pos <= '9')
+				exponent = exponent * 10 + (*pos++ - '0');
+			value *= pow(10.0, exponentSign * exponent);
+		}
+		token.type = XTOKEN_NUMBER;
+		token.number = sign * value;
+	} else if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+		const char* start = pos;
+		while(pos < end && ((*pos >= 'a' && *pos <= 'z') || (*pos >= 'A' && *pos <= 'Z') ||
+			(*pos >= '0' && *pos <= '9') || *pos == '_' || *pos == '-'))
+			pos++;
+		token.type = XTOKEN_NAME;
+		token.text = start;
+		token.length = pos - start;
+	} else {
+		token.type = XTOKEN_OTHER; // Brackets and dots inside templates
+		pos++;
+	}
+	return token;
+}
+// Reads the next token of a binary file
+XToken XFile::NextBinary() {
+	XToken token;
+	token.type = XTOKEN_END;
+	token.text = 0;
+	token.length = 0;
+	token.number = 0.0;
+
+	// Hand out the numbers of the current list one at a time
+	if(listCount > 0) {
+		size_t size = listFloats && doubles ? 8 : 4;
+		if(pos + size > end) {
+			Fail("Unexpected end of file");
+			token.type = XTOKEN_ERROR;
+			return token;
+		}
+		if(!listFloats) {
+			unsigned int value;
+			memcpy(&value, pos, 4);
+			token.number = value;
+		} else if(doubles) {
+			memcpy(&token.number, pos, 8);
+		} else {
+			float value;
+			memcpy(&value, pos, 4);
+			token.number = value;
+		}
+		pos += size;
+		listCount--;
+		token.type = XTOKEN_NUMBER;
+		return token;
+	}
+
+	if(pos + 2 > end)
+		return token;
+	unsigned short type;
+	memcpy(&type, pos, 2);
+	pos += 2;
+
+	unsigned int count = 0;
+	if(type == XBIN_NAME || type == XBIN_STRING || type == XBIN_INTEGER || type == XBIN_INTEGER_LIST || type == XBIN_FLOAT_LIST) {
+		if(pos + 4 > end) {
+			Fail("Unexpected end of file");
+			token.type = XTOKEN_ERROR;
+			return token;
+		}
+		memcpy(&count, pos, 4);
+		pos += 4;
+	}
+
+	switch(type) {
+	case XBIN_NAME:
+	case XBIN_STRING:
+		if(pos + count > end) {
+			Fail("Unexpected end of file");
+			token.type = XTOKEN_ERROR;
+			return token;
+		}
+		token.type = type == XBIN_NAME ? XTOKEN_NAME : XTOKEN_STRING;
+		token.text = pos;
+		token.length = count;
+		pos += count;
+		if(type == XBIN_STRING)
+			pos += 2; // The string's terminating separator token
+		break;
+	case XBIN_INTEGER:
+		token.type = XTOKEN_NUMBER;
+		token.number = count;
+		break;
+	case XBIN_GUID:
+		pos += 16;
+		token.type = XTOKEN_OTHER;
+		break;
+	case XBIN_INTEGER_LIST:
+	case XBIN_FLOAT_LIST:
+		listCount = count;
+		listFloats = type == XBIN_FLOAT_LIST;
+		return NextBinary();
+	case XBIN_OBRACE:
+		token.type = XTOKEN_OBRACE;
+		break;
+	case XBIN_CBRACE:
+		token.type = XTOKEN_CBRACE;
+		break;
+	default:
+		token.type = XTOKEN_OTHER; // Separators, brackets and template keywords
+		break;
+	}
+	if(pos > end) {
+		Fail("Unexpected end of file");
+		token.type = XTOKEN_ERROR;
+	}
+	return token;
+}
\ No newline at end of file